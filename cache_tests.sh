@@ -0,0 +1,116 @@
+#!/bin/bash
+# 用法: cache_tests.sh [编译器]
+# 检查 --cache-dir 的命中与失效：依次编译同一程序的几个版本，比较编译器报告的
+# "[INFO] Cache: R functions reused, C compiled" 与预期，并检查输出与不用缓存时完全相同
+
+COMPILER=${1:-"./build/compiler"}
+TEMP_DIR="/tmp/toyc_cache_test_$$"
+CACHE_DIR="$TEMP_DIR/cache"
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -x "$COMPILER" ]; then
+    echo -e "${RED}Error: Compiler not found or not executable: $COMPILER${NC}"
+    exit 1
+fi
+
+mkdir -p "$TEMP_DIR"
+
+echo -e "${BLUE}ToyC Function Cache Test Suite (--cache-dir)${NC}"
+echo "=================================================="
+
+total_tests=0
+passed_tests=0
+
+# 以 mode 带缓存编译 file，期望复用 reused 个函数、重新编译 compiled 个
+check() {
+    local label=$1
+    local file=$2
+    local mode=$3
+    local reused=$4
+    local compiled=$5
+    local name=$(basename "$file" .tc)${mode:+_${mode#-}}
+    
+    echo -n "Testing $label... "
+    total_tests=$((total_tests + 1))
+    
+    if ! "$COMPILER" $mode --cache-dir "$CACHE_DIR" "$file" > "$TEMP_DIR/$name.cached.s" 2> "$TEMP_DIR/$name.err"; then
+        echo -e "${RED}FAIL${NC} (compilation)"
+        sed 's/^/    /' "$TEMP_DIR/$name.err"
+        return
+    fi
+    local report=$(sed -n 's/^\[INFO\] Cache: \([0-9]*\) functions reused, \([0-9]*\) compiled$/\1 \2/p' "$TEMP_DIR/$name.err")
+    if [ "$report" != "$reused $compiled" ]; then
+        echo -e "${RED}FAIL${NC} (reused/compiled: ${report:-no report}, expected $reused $compiled)"
+        return
+    fi
+    "$COMPILER" $mode "$file" > "$TEMP_DIR/$name.s" 2>/dev/null
+    if ! cmp -s "$TEMP_DIR/$name.s" "$TEMP_DIR/$name.cached.s"; then
+        echo -e "${RED}FAIL${NC} (output differs from compiling without the cache)"
+        diff "$TEMP_DIR/$name.s" "$TEMP_DIR/$name.cached.s" | head -n 10 | sed 's/^/    /'
+        return
+    fi
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+}
+
+cat > "$TEMP_DIR/v1.tc" << 'EOF'
+int touch(int x) {
+    return x * 3;
+}
+int scale(int a, int b) {
+    return a * b + 1;
+}
+int twice(int x) {
+    touch(x);
+    return scale(x, 2);
+}
+int loop(int n) {
+    int s = 0;
+    while (n > 0) { s = s + n; n = n - 1; }
+    return s;
+}
+int main() {
+    return twice(5) + loop(10);
+}
+EOF
+# 只改空白和注释：记号序列不变
+sed 's|^int loop(int n) {|// 求和\nint   loop(int n)   {|' "$TEMP_DIR/v1.tc" > "$TEMP_DIR/v1_layout.tc"
+# 改 touch 的函数体，签名不变
+sed 's/x \* 3/x * 4/' "$TEMP_DIR/v1.tc" > "$TEMP_DIR/v2_body.tc"
+# 改 touch 的签名（返回类型），调用它的 twice 记号不变
+sed 's/^int touch/void touch/; s/return x \* 3;/x = x * 3;/' "$TEMP_DIR/v1.tc" > "$TEMP_DIR/v3_signature.tc"
+
+echo "Default mode (each function is keyed by its own tokens and its callees' signatures):"
+check "cold cache" "$TEMP_DIR/v1.tc" "" 0 5
+check "unchanged program" "$TEMP_DIR/v1.tc" "" 5 0
+check "whitespace and comments only" "$TEMP_DIR/v1_layout.tc" "" 5 0
+check "callee body changed" "$TEMP_DIR/v2_body.tc" "" 4 1
+check "callee signature changed" "$TEMP_DIR/v3_signature.tc" "" 3 2
+check "back to the first version" "$TEMP_DIR/v1.tc" "" 5 0
+echo ""
+
+# -opt 把这些函数全部内联进 main 并删去其余函数，main 的键包含被内联函数的记号
+echo "-opt (callers are keyed by the bodies they may inline):"
+check "options are part of the key" "$TEMP_DIR/v1.tc" "-opt" 0 1
+check "unchanged program" "$TEMP_DIR/v1.tc" "-opt" 1 0
+check "inlined callee body changed" "$TEMP_DIR/v2_body.tc" "-opt" 0 1
+check "callee signature changed" "$TEMP_DIR/v3_signature.tc" "-opt" 0 1
+check "back to the first version" "$TEMP_DIR/v1.tc" "-opt" 1 0
+
+echo ""
+echo "=================================================="
+echo -e "Tests completed: ${GREEN}$passed_tests${NC}/${total_tests} passed"
+
+if [ $passed_tests -eq $total_tests ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    rm -rf "$TEMP_DIR"
+    exit 0
+else
+    echo -e "${RED}$((total_tests - passed_tests)) tests failed${NC}"
+    echo "Generated files are in: $TEMP_DIR"
+    exit 1
+fi
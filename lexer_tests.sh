@@ -0,0 +1,187 @@
+#!/bin/bash
+# 用法: lexer_tests.sh [toyc_lexcheck] [生成的 lexer.cpp]
+# 检查手写扫描器（FastLexer）与 Flex 生成的扫描器给出相同的记号流和诊断信息：
+# test_samples/*.tc 以及下面几个针对注释、带符号数字和非法字符的输入；
+# 后者还与预期的记号流比较（"行号 偏移 文本 [取值]"，不含随 parser.y 变化的记号编号）。
+# 给出 lexer.cpp 时先检查它确实是由当前的 src/lexer.l 生成的（而不是过时的预生成文件），
+# 这样上面的比较验证的就是 lexer.l 本身
+
+LEXCHECK=${1:-"./build/toyc_lexcheck"}
+GENERATED=$2
+LEXER_SOURCE="$(dirname "$0")/src/lexer.l"
+TEST_DIR="$(dirname "$0")/test_samples"
+TEMP_DIR="/tmp/toyc_lexer_test_$$"
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -x "$LEXCHECK" ]; then
+    echo -e "${RED}Error: toyc_lexcheck not found or not executable: $LEXCHECK${NC}"
+    exit 1
+fi
+
+mkdir -p "$TEMP_DIR"
+
+echo -e "${BLUE}ToyC Lexer Test Suite (FastLexer vs Flex)${NC}"
+echo "=================================================="
+
+total_tests=0
+passed_tests=0
+
+# 两种扫描器对 file 的结果相同；给出 expected 文件时 FastLexer 的记号流还要与它一致
+check() {
+    local name=$1
+    local file=$2
+    local expected=$3
+    
+    echo -n "Testing $name... "
+    total_tests=$((total_tests + 1))
+    
+    if ! "$LEXCHECK" --dump "$file" > "$TEMP_DIR/$name.dump" 2> "$TEMP_DIR/$name.err"; then
+        echo -e "${RED}FAIL${NC} (FastLexer and Flex differ)"
+        sed 's/^/    /' "$TEMP_DIR/$name.err"
+        return
+    fi
+    if [ -n "$expected" ]; then
+        sed -E 's/^([0-9]+ [0-9]+) [0-9]+ /\1 /' "$TEMP_DIR/$name.dump" > "$TEMP_DIR/$name.out"
+        if ! diff -u "$expected" "$TEMP_DIR/$name.out" > "$TEMP_DIR/$name.diff"; then
+            echo -e "${RED}FAIL${NC} (unexpected tokens)"
+            sed 's/^/    /' "$TEMP_DIR/$name.diff"
+            return
+        fi
+    fi
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+}
+
+# Flex 把 lexer.l 中的代码（%{ %} 块、各规则的动作、第三节）原样抄进 lexer.cpp，前面是指向 lexer.l 的 #line。
+# 逐段核对：#line N 之后的第一行是 lexer.l 第 N 行的结尾（规则的动作跟在模式之后），其余各行与后续各行相同，
+# 最后一段一直到 lexer.l 的末尾
+if [ -n "$GENERATED" ]; then
+    echo -n "Testing that $(basename "$GENERATED") is generated from lexer.l... "
+    total_tests=$((total_tests + 1))
+    if awk '
+        { sub(/\r$/, "") }
+        FNR == NR { source[FNR] = $0; lines = FNR; next }
+        /^#line [0-9]+ "/ {
+            line = $0 ~ /lexer\.l"$/ ? $2 : 0
+            offset = 0
+            next
+        }
+        line == 0 { next }
+        $0 == "\tYY_BREAK" || $0 == "YY_FATAL_ERROR( \"flex scanner jammed\" );" { line = 0; next }
+        {
+            want = source[line + offset]
+            same = offset == 0 ? substr(want, length(want) - length($0) + 1) == $0 : want == $0
+            if (!same || line + offset > lines) {
+                printf "line %d does not match lexer.l line %d\n  generated: %s\n  lexer.l:   %s\n", FNR, line + offset, $0, want
+                failed = 1
+                exit 1
+            }
+            last = line + offset
+            offset++
+        }
+        END {
+            if (failed) exit 1
+            if (last != lines) {
+                printf "generated code ends at lexer.l line %d of %d\n", last, lines
+                exit 1
+            }
+        }' "$LEXER_SOURCE" "$GENERATED" > "$TEMP_DIR/generated.err"; then
+        echo -e "${GREEN}PASS${NC}"
+        passed_tests=$((passed_tests + 1))
+    else
+        echo -e "${RED}FAIL${NC} (stale or hand-edited scanner)"
+        sed 's/^/    /' "$TEMP_DIR/generated.err"
+    fi
+fi
+
+# 行注释中的 "/*"、跨行块注释、"/**/"、"/***/"、以 "/*/" 开头的注释（"/" 不结束注释），末尾没有换行的行注释
+printf 'int a; // line comment /* not a block\n/* block\n   spanning */ int b;\n/**/ /***/ /*/ still comment */ c\n/* a ** b */ d // no newline' \
+    > "$TEMP_DIR/comments.tc"
+cat > "$TEMP_DIR/comments.expected" << 'EOF'
+1 0 int
+1 4 a a
+1 5 ;
+3 62 int
+3 66 b b
+3 67 ;
+4 101 c c
+5 116 d d
+EOF
+check comments "$TEMP_DIR/comments.tc" "$TEMP_DIR/comments.expected"
+
+# 紧跟数字的 "-" 属于数字记号（-?(0|[1-9][0-9]*)），前导 0 单独成为记号
+cat > "$TEMP_DIR/numbers.tc" << 'EOF'
+x-1 x - 1 -0 007 -12a
+2147483647 -2147483648 --5 -x 0x1f
+EOF
+cat > "$TEMP_DIR/numbers.expected" << 'EOF'
+1 0 x x
+1 1 -1 -1
+1 4 x x
+1 6 -
+1 8 1 1
+1 10 -0 0
+1 13 0 0
+1 14 0 0
+1 15 7 7
+1 17 -12 -12
+1 20 a a
+2 22 2147483647 2147483647
+2 33 -2147483648 -2147483648
+2 45 -
+2 46 -5 -5
+2 49 -
+2 50 x x
+2 52 0 0
+2 53 x1f x1f
+EOF
+check numbers "$TEMP_DIR/numbers.tc" "$TEMP_DIR/numbers.expected"
+
+# 单个 "&"、"|" 和其他非法字符，以及到输入末尾仍未结束的块注释
+cat > "$TEMP_DIR/errors.tc" << 'EOF'
+a @ b & c | d && e || f
+/* never
+closed
+EOF
+cat > "$TEMP_DIR/errors.expected" << 'EOF'
+1 0 a a
+1 2 @
+1 4 b b
+1 6 &
+1 8 c c
+1 10 |
+1 12 d d
+1 14 &&
+1 17 e e
+1 19 ||
+1 22 f f
+Illegal character '@' at line 1, offset 2
+Illegal character '&' at line 1, offset 6
+Illegal character '|' at line 1, offset 10
+Unterminated comment at line 4
+EOF
+check errors "$TEMP_DIR/errors.tc" "$TEMP_DIR/errors.expected"
+
+for test_file in "$TEST_DIR"/*.tc; do
+    if [ -f "$test_file" ]; then
+        check "$(basename "$test_file" .tc)" "$test_file"
+    fi
+done
+
+echo ""
+echo "=================================================="
+echo -e "Tests completed: ${GREEN}$passed_tests${NC}/${total_tests} passed"
+
+if [ $passed_tests -eq $total_tests ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    rm -rf "$TEMP_DIR"
+    exit 0
+else
+    echo -e "${RED}$((total_tests - passed_tests)) tests failed${NC}"
+    echo "Generated files are in: $TEMP_DIR"
+    exit 1
+fi
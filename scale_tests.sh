@@ -0,0 +1,94 @@
+#!/bin/bash
+# 用法: scale_tests.sh [编译器]
+# 检查编译开销随单元规模线性增长：生成 N 个与 2N 个函数的单元，分别用 --time-report 编译，
+# 每个阶段的堆分配字节数和耗时在函数个数加倍时都应大致加倍（分配字节数不超过 2.5 倍，
+# 耗时不超过 3 倍；两者各留一点余量，避免很小的阶段因为计时抖动而失败）
+
+COMPILER=${1:-"./build/compiler"}
+TEMP_DIR="/tmp/toyc_scale_test_$$"
+FUNCTIONS=10000
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -x "$COMPILER" ]; then
+    echo -e "${RED}Error: Compiler not found or not executable: $COMPILER${NC}"
+    exit 1
+fi
+
+mkdir -p "$TEMP_DIR"
+
+echo -e "${BLUE}ToyC Scaling Test Suite (N vs 2N functions)${NC}"
+echo "=================================================="
+
+total_tests=0
+passed_tests=0
+
+# 生成 n 个互不相同的函数：每个函数的参数和局部变量都是新的标识符
+generate() {
+    local n=$1
+    awk -v n="$n" 'BEGIN {
+        for (i = 1; i <= n; i++) {
+            printf "int f%d(int a%d) {\n    int b%d = a%d + 1;\n    while (b%d > 10) { b%d = b%d - 3; }\n    return b%d * 2;\n}\n", i, i, i, i, i, i, i, i
+        }
+        print "int main() {\n    return f1(1);\n}"
+    }' > "$TEMP_DIR/unit_$n.tc"
+}
+
+# time-report 中每个阶段一行："名字 耗时 分配字节数"
+phases() {
+    sed -n 's/.*{"name": "\([a-z-]*\)", "count": [0-9]*, "seconds": \([0-9.]*\), "allocations": [0-9]*, "allocated_bytes": \([0-9]*\)}.*/\1 \2 \3/p' "$1"
+}
+
+check() {
+    local label=$1
+    shift
+    echo -n "Testing $label... "
+    total_tests=$((total_tests + 1))
+    
+    for n in $FUNCTIONS $((FUNCTIONS * 2)); do
+        if ! "$COMPILER" "$@" --time-report="$TEMP_DIR/report_$n.json" "$TEMP_DIR/unit_$n.tc" > /dev/null 2> "$TEMP_DIR/err_$n"; then
+            echo -e "${RED}FAIL${NC} (compilation of $n functions)"
+            sed 's/^/    /' "$TEMP_DIR/err_$n"
+            return
+        fi
+    done
+    
+    local failures=$(join <(phases "$TEMP_DIR/report_$FUNCTIONS.json" | sort) \
+                          <(phases "$TEMP_DIR/report_$((FUNCTIONS * 2)).json" | sort) |
+        awk '$5 > 2.5 * $3 + 65536 || $4 > 3 * $2 + 0.02 {
+            printf "%s: %.3fs -> %.3fs, %.0f -> %.0f bytes\n", $1, $2, $4, $3, $5
+        }')
+    if [ -n "$failures" ]; then
+        echo -e "${RED}FAIL${NC} (grows faster than the number of functions)"
+        echo "$failures" | sed 's/^/    /'
+        return
+    fi
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+}
+
+generate $FUNCTIONS
+generate $((FUNCTIONS * 2))
+
+check "default"
+check "-j 2" -j 2
+check "-opt" -opt
+check "-opt -j 2" -opt -j 2
+check "--stream" --stream
+
+echo ""
+echo "=================================================="
+echo -e "Tests completed: ${GREEN}$passed_tests${NC}/${total_tests} passed"
+
+if [ $passed_tests -eq $total_tests ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    rm -rf "$TEMP_DIR"
+    exit 0
+else
+    echo -e "${RED}$((total_tests - passed_tests)) tests failed${NC}"
+    echo "Generated files are in: $TEMP_DIR"
+    exit 1
+fi
@@ -0,0 +1,192 @@
+#!/bin/bash
+# 用法: server_tests.sh [编译器]
+# 启动编译守护进程（--server），检查经 --connect 编译 test_samples/*.tc 得到的输出、退出状态和诊断信息
+# 与直接编译相同（诊断信息中的 [INFO] 行不比较），包括重复请求、并发请求和出错的输入；
+# 空闲和请求中途停住的连接不妨碍其他客户端；最后检查守护进程收到 SIGTERM 后退出并删除套接字文件
+
+COMPILER=${1:-"./build/compiler"}
+TEST_DIR="$(dirname "$0")/test_samples"
+TEMP_DIR="/tmp/toyc_server_test_$$"
+SOCKET="$TEMP_DIR/toyc.sock"
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+if [ ! -x "$COMPILER" ]; then
+    echo -e "${RED}Error: Compiler not found or not executable: $COMPILER${NC}"
+    exit 1
+fi
+
+mkdir -p "$TEMP_DIR"
+
+echo -e "${BLUE}ToyC Compile Server Test Suite (--connect vs direct compilation)${NC}"
+echo "=================================================="
+
+"$COMPILER" --server "$SOCKET" -j 2 2> "$TEMP_DIR/server.log" &
+server_pid=$!
+for i in $(seq 50); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+if [ ! -S "$SOCKET" ]; then
+    echo -e "${RED}Error: server did not create $SOCKET${NC}"
+    cat "$TEMP_DIR/server.log"
+    kill $server_pid 2>/dev/null
+    exit 1
+fi
+
+total_tests=0
+passed_tests=0
+
+# 把 file 以 mode 分别经守护进程和直接编译，name 区分输出文件
+compile_both() {
+    local name=$1
+    local file=$2
+    local mode=$3
+    
+    "$COMPILER" --connect "$SOCKET" $mode "$file" > "$TEMP_DIR/$name.remote.s" 2> "$TEMP_DIR/$name.remote.err"
+    echo $? > "$TEMP_DIR/$name.remote.status"
+    "$COMPILER" $mode "$file" > "$TEMP_DIR/$name.direct.s" 2> "$TEMP_DIR/$name.direct.err"
+    echo $? > "$TEMP_DIR/$name.direct.status"
+}
+
+# 比较 compile_both 的两份结果
+check_same() {
+    local name=$1
+    local label=$2
+    
+    echo -n "Testing $label... "
+    total_tests=$((total_tests + 1))
+    
+    if ! cmp -s "$TEMP_DIR/$name.remote.status" "$TEMP_DIR/$name.direct.status"; then
+        echo -e "${RED}FAIL${NC} (exit status $(cat "$TEMP_DIR/$name.remote.status"), expected $(cat "$TEMP_DIR/$name.direct.status"))"
+        sed 's/^/    /' "$TEMP_DIR/$name.remote.err"
+        return
+    fi
+    if ! cmp -s "$TEMP_DIR/$name.remote.s" "$TEMP_DIR/$name.direct.s"; then
+        echo -e "${RED}FAIL${NC} (output differs)"
+        diff "$TEMP_DIR/$name.direct.s" "$TEMP_DIR/$name.remote.s" | head -n 10 | sed 's/^/    /'
+        return
+    fi
+    grep -v '^\[INFO\]' "$TEMP_DIR/$name.direct.err" > "$TEMP_DIR/$name.direct.diag"
+    grep -v '^\[INFO\]' "$TEMP_DIR/$name.remote.err" > "$TEMP_DIR/$name.remote.diag"
+    if ! diff "$TEMP_DIR/$name.direct.diag" "$TEMP_DIR/$name.remote.diag" > "$TEMP_DIR/$name.diff"; then
+        echo -e "${RED}FAIL${NC} (diagnostics differ)"
+        sed 's/^/    /' "$TEMP_DIR/$name.diff"
+        return
+    fi
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+}
+
+# 第二轮默认模式的请求与第一轮完全相同，由守护进程的响应缓存直接回答
+for mode in "" "-opt" "-stack-machine" "-emit-ir" ""; do
+    echo "Running tests (${mode:-default}):"
+    for test_file in "$TEST_DIR"/*.tc; do
+        if [ -f "$test_file" ]; then
+            name="$(basename "$test_file" .tc)${mode:+_${mode#-}}"
+            compile_both "$name" "$test_file" "$mode"
+            check_same "$name" "$name"
+        fi
+    done
+    echo ""
+done
+
+echo "Testing errors and concurrent requests:"
+cat > "$TEMP_DIR/syntax_error.tc" << 'EOF'
+int main() {
+    int x = ;  // 语法错误
+    return x;
+}
+EOF
+cat > "$TEMP_DIR/semantic_error.tc" << 'EOF'
+int f(int a) { return a; }
+int main() {
+    return f(1, 2) + y;
+}
+EOF
+for name in syntax_error semantic_error; do
+    compile_both "$name" "$TEMP_DIR/$name.tc" ""
+    check_same "$name" "$name"
+done
+
+# 同时发出的请求各占一个工作线程（或排队），结果互不影响
+names=()
+for test_file in "$TEST_DIR"/*.tc; do
+    name="concurrent_$(basename "$test_file" .tc)"
+    compile_both "$name" "$test_file" "-opt" &
+    names+=("$name")
+done
+wait $(jobs -p | grep -v "^$server_pid$")
+for name in "${names[@]}"; do
+    check_same "$name" "$name"
+done
+
+# 连接 SOCKET 后发送 data（可以为空、也可以只是请求的一部分），然后一直不再发送也不关闭
+hold_connection() {
+    perl -MIO::Socket::UNIX -e '$s = IO::Socket::UNIX->new(Peer => $ARGV[0]) or exit 1; print $s $ARGV[1]; sleep 60' "$1" "$2" &
+    holders+=($!)
+}
+
+# 空闲的连接不占用工作线程，请求中途停住的连接至多占用一个；其他客户端不受影响
+echo -n "Testing requests while idle connections are open... "
+total_tests=$((total_tests + 1))
+holders=()
+for i in 1 2 3; do
+    hold_connection "$SOCKET" ""
+done
+hold_connection "$SOCKET" "$(printf '4\n-opt\n3')"
+sleep 0.5
+if timeout 10 "$COMPILER" --connect "$SOCKET" "$TEST_DIR/fib.tc" > "$TEMP_DIR/idle.remote.s" 2> "$TEMP_DIR/idle.remote.err" &&
+    "$COMPILER" "$TEST_DIR/fib.tc" > "$TEMP_DIR/idle.direct.s" 2>/dev/null &&
+    cmp -s "$TEMP_DIR/idle.remote.s" "$TEMP_DIR/idle.direct.s"; then
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+else
+    echo -e "${RED}FAIL${NC} (--connect did not get the right answer within 10 seconds)"
+    sed 's/^/    /' "$TEMP_DIR/idle.remote.err"
+fi
+# 保留一个空闲连接，守护进程退出时应当关闭它而不是等待它
+kill "${holders[@]:1}" 2>/dev/null
+
+echo -n "Testing shutdown on SIGTERM... "
+total_tests=$((total_tests + 1))
+kill -TERM $server_pid
+wait $server_pid
+server_status=$?
+kill "${holders[@]}" 2>/dev/null
+if [ $server_status -ne 0 ] || [ -e "$SOCKET" ]; then
+    echo -e "${RED}FAIL${NC} (exit status $server_status, socket $( [ -e "$SOCKET" ] && echo kept || echo removed))"
+    sed 's/^/    /' "$TEMP_DIR/server.log"
+else
+    echo -e "${GREEN}PASS${NC}"
+    passed_tests=$((passed_tests + 1))
+fi
+
+# 退出时的统计行形如 "Server stopped: N requests, M answered from the response cache"
+echo -n "Testing response cache... "
+total_tests=$((total_tests + 1))
+answered=$(sed -n 's/.*, \([0-9]*\) answered from the response cache.*/\1/p' "$TEMP_DIR/server.log")
+if [ -z "$answered" ] || [ "$answered" -lt 1 ]; then
+    echo -e "${RED}FAIL${NC} (repeated requests were not answered from the response cache)"
+    sed 's/^/    /' "$TEMP_DIR/server.log"
+else
+    echo -e "${GREEN}PASS${NC} ($answered responses reused)"
+    passed_tests=$((passed_tests + 1))
+fi
+
+echo ""
+echo "=================================================="
+echo -e "Tests completed: ${GREEN}$passed_tests${NC}/${total_tests} passed"
+
+if [ $passed_tests -eq $total_tests ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    rm -rf "$TEMP_DIR"
+    exit 0
+else
+    echo -e "${RED}$((total_tests - passed_tests)) tests failed${NC}"
+    echo "Generated files are in: $TEMP_DIR"
+    exit 1
+fi
@@ -0,0 +1,42 @@
+#include "ast/arena.hpp"
+#include <algorithm>
+
+static thread_local std::shared_ptr<ASTArena> activeArena;
+
+void ASTArena::grow(size_t minimum) {
+    size_t size = std::max(BLOCK_SIZE, minimum);
+    if (blocks.empty()) firstBlockSize = size;
+    blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+    current = blocks.back().get();
+    remaining = size;
+}
+
+void ASTArena::reset() {
+    used = 0;
+    // 只保留标准大小的第一块；超大的块（单个分配超过 BLOCK_SIZE）留着没有意义
+    if (blocks.empty() || firstBlockSize != BLOCK_SIZE) {
+        blocks.clear();
+        current = nullptr;
+        remaining = 0;
+        return;
+    }
+    blocks.resize(1);
+    current = blocks[0].get();
+    remaining = BLOCK_SIZE;
+}
+
+ASTArena* ASTArena::active() {
+    return activeArena.get();
+}
+
+std::shared_ptr<ASTArena> ASTArena::activeHandle() {
+    return activeArena;
+}
+
+ASTArena::Scope::Scope(std::shared_ptr<ASTArena> arena) : previous(std::move(activeArena)) {
+    activeArena = std::move(arena);
+}
+
+ASTArena::Scope::~Scope() {
+    activeArena = std::move(previous);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// AST 节点的指针碰撞（bump-pointer）分配器。
+// 语法分析期间由 ASTArena::Scope 安装为当前线程的分配区，期间创建的节点和子节点数组都从这里分配；
+// 单个节点的释放是空操作，整块内存随持有它的 CompilationUnit 一起归还。
+// 分析结束后（如常量折叠）新建的节点没有分配区，照常走堆分配。
+class ASTArena {
+public:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+    
+    ASTArena() : current(nullptr), remaining(0), used(0), firstBlockSize(0) {}
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+    
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t padding = (align - (reinterpret_cast<size_t>(current) & (align - 1))) & (align - 1);
+        if (padding + size > remaining) {
+            grow(size + align);
+            padding = (align - (reinterpret_cast<size_t>(current) & (align - 1))) & (align - 1);
+        }
+        char* result = current + padding;
+        current = result + size;
+        remaining -= padding + size;
+        used += size;
+        return result;
+    }
+    
+    // 清空分配区以便重新使用：保留第一块，归还其余内存块。之前分配的节点必须都已销毁
+    // （流式编译在每个函数之后、编译守护进程在每个请求之后调用）
+    void reset();
+    
+    size_t bytesUsed() const { return used; }
+    size_t blockCount() const { return blocks.size(); }
+    
+    // 当前线程正在使用的分配区，没有时为 nullptr
+    static ASTArena* active();
+    static std::shared_ptr<ASTArena> activeHandle();
+    
+    // 在作用域内把 arena 安装为当前线程的分配区
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<ASTArena> arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        
+    private:
+        std::shared_ptr<ASTArena> previous;
+    };
+    
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current;
+    size_t remaining;
+    size_t used;
+    size_t firstBlockSize;
+    
+    void grow(size_t minimum);
+};
+
+// 从创建时的当前分配区取内存的 STL 分配器，用于节点的子节点数组；
+// 没有分配区时退回到堆分配
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    
+    ArenaAllocator() : arena(ASTArena::active()) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    
+    T* allocate(size_t n) {
+        if (arena) return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t) {
+        if (!arena) ::operator delete(ptr);
+    }
+    
+    // 复制出的容器使用复制时的当前分配区
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+    
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+    
+private:
+    template <typename U> friend class ArenaAllocator;
+    ASTArena* arena;
+};
+
+// AST 中的子节点数组
+template <typename T>
+using ASTVector = std::vector<T, ArenaAllocator<T>>;
@@ -1,266 +1,382 @@
-#pragma once
-#include <memory>
-#include <vector>
-#include <string>
-#include <iostream>
-
-// 前向声明
-class Visitor;
-
-// AST节点基类
-class ASTNode {
-public:
-    virtual ~ASTNode() = default;
-    virtual void accept(Visitor& visitor) = 0;
-    virtual void print(int indent = 0) const = 0;
-};
-
-// 表达式基类
-class Expression : public ASTNode {
-public:
-    enum Type { INT, VOID };
-    virtual Type getType() const = 0;
-};
-
-// 语句基类
-class Statement : public ASTNode {};
-
-// 二元表达式
-class BinaryExpression : public Expression {
-public:
-    enum Operator { 
-        ADD, SUB, MUL, DIV, MOD,
-        LT, LE, GT, GE, EQ, NE,
-        AND, OR
-    };
-    
-    std::unique_ptr<Expression> left;
-    std::unique_ptr<Expression> right;
-    Operator op;
-    
-    BinaryExpression(std::unique_ptr<Expression> l, Operator o, std::unique_ptr<Expression> r)
-        : left(std::move(l)), right(std::move(r)), op(o) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-    Type getType() const override { return INT; }
-};
-
-// 一元表达式
-class UnaryExpression : public Expression {
-public:
-    enum Operator { PLUS, MINUS, NOT };
-    
-    Operator op;
-    std::unique_ptr<Expression> operand;
-    
-    UnaryExpression(Operator o, std::unique_ptr<Expression> expr)
-        : op(o), operand(std::move(expr)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-    Type getType() const override { return INT; }
-};
-
-// 数字字面量
-class NumberLiteral : public Expression {
-public:
-    int value;
-    
-    NumberLiteral(int val) : value(val) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-    Type getType() const override { return INT; }
-};
-
-// 标识符表达式
-class Identifier : public Expression {
-public:
-    std::string name;
-    
-    Identifier(const std::string& n) : name(n) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-    Type getType() const override { return INT; }
-};
-
-// 函数调用表达式
-class FunctionCall : public Expression {
-public:
-    std::string functionName;
-    std::vector<std::unique_ptr<Expression>> arguments;
-    Expression::Type returnType;
-    
-    FunctionCall(const std::string& name, std::vector<std::unique_ptr<Expression>> args, Expression::Type type)
-        : functionName(name), arguments(std::move(args)), returnType(type) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-    Type getType() const override { return returnType; }
-};
-
-// 赋值语句
-class AssignmentStatement : public Statement {
-public:
-    std::string variable;
-    std::unique_ptr<Expression> value;
-    
-    AssignmentStatement(const std::string& var, std::unique_ptr<Expression> val)
-        : variable(var), value(std::move(val)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 变量声明语句
-class VariableDeclaration : public Statement {
-public:
-    std::string name;
-    std::unique_ptr<Expression> initializer;
-    
-    VariableDeclaration(const std::string& n, std::unique_ptr<Expression> init)
-        : name(n), initializer(std::move(init)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 语句块
-class Block : public Statement {
-public:
-    std::vector<std::unique_ptr<Statement>> statements;
-    
-    void addStatement(std::unique_ptr<Statement> stmt) {
-        statements.push_back(std::move(stmt));
-    }
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// If语句
-class IfStatement : public Statement {
-public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> thenStatement;
-    std::unique_ptr<Statement> elseStatement; // 可选
-    
-    IfStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> then, 
-                std::unique_ptr<Statement> els = nullptr)
-        : condition(std::move(cond)), thenStatement(std::move(then)), elseStatement(std::move(els)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// While语句
-class WhileStatement : public Statement {
-public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> body;
-    
-    WhileStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> b)
-        : condition(std::move(cond)), body(std::move(b)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// Break语句
-class BreakStatement : public Statement {
-public:
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// Continue语句
-class ContinueStatement : public Statement {
-public:
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// Return语句
-class ReturnStatement : public Statement {
-public:
-    std::unique_ptr<Expression> value; // 可选
-    
-    ReturnStatement(std::unique_ptr<Expression> val = nullptr) : value(std::move(val)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 表达式语句
-class ExpressionStatement : public Statement {
-public:
-    std::unique_ptr<Expression> expression;
-    
-    ExpressionStatement(std::unique_ptr<Expression> expr) : expression(std::move(expr)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 参数定义
-class Parameter {
-public:
-    std::string name;
-    Expression::Type type;
-    
-    Parameter(const std::string& n, Expression::Type t) : name(n), type(t) {}
-};
-
-// 函数定义
-class FunctionDefinition : public ASTNode {
-public:
-    std::string name;
-    Expression::Type returnType;
-    std::vector<Parameter> parameters;
-    std::unique_ptr<Block> body;
-    
-    FunctionDefinition(const std::string& n, Expression::Type ret, 
-                      std::vector<Parameter> params, std::unique_ptr<Block> b)
-        : name(n), returnType(ret), parameters(std::move(params)), body(std::move(b)) {}
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 编译单元（程序根节点）
-class CompilationUnit : public ASTNode {
-public:
-    std::vector<std::unique_ptr<FunctionDefinition>> functions;
-    
-    void addFunction(std::unique_ptr<FunctionDefinition> func) {
-        functions.push_back(std::move(func));
-    }
-    
-    void accept(Visitor& visitor) override;
-    void print(int indent = 0) const override;
-};
-
-// 访问者模式接口
-class Visitor {
-public:
-    virtual ~Visitor() = default;
-    
-    virtual void visit(BinaryExpression& node) = 0;
-    virtual void visit(UnaryExpression& node) = 0;
-    virtual void visit(NumberLiteral& node) = 0;
-    virtual void visit(Identifier& node) = 0;
-    virtual void visit(FunctionCall& node) = 0;
-    virtual void visit(AssignmentStatement& node) = 0;
-    virtual void visit(VariableDeclaration& node) = 0;
-    virtual void visit(Block& node) = 0;
-    virtual void visit(IfStatement& node) = 0;
-    virtual void visit(WhileStatement& node) = 0;
-    virtual void visit(BreakStatement& node) = 0;
-    virtual void visit(ContinueStatement& node) = 0;
-    virtual void visit(ReturnStatement& node) = 0;
-    virtual void visit(ExpressionStatement& node) = 0;
-    virtual void visit(FunctionDefinition& node) = 0;
-    virtual void visit(CompilationUnit& node) = 0;
-};
\ No newline at end of file
+#pragma once
+#include <memory>
+#include <vector>
+#include <string>
+#include <iostream>
+#include "ast/arena.hpp"
+#include "common/symbol.hpp"
+
+// 前向声明
+class Visitor;
+
+// AST节点基类
+// 节点从当前线程的 ASTArena 分配（见 arena.hpp），没有分配区时走堆；
+// arena 中的节点 delete 时只执行析构，内存随整个分配区一起释放
+class ASTNode {
+public:
+    // 节点种类标签：类型测试只比较整数，ASTVisitor 按它做静态分派
+    enum Kind {
+        BINARY_EXPRESSION, UNARY_EXPRESSION, NUMBER_LITERAL, IDENTIFIER, FUNCTION_CALL,
+        ASSIGNMENT_STATEMENT, VARIABLE_DECLARATION, BLOCK, IF_STATEMENT, WHILE_STATEMENT,
+        BREAK_STATEMENT, CONTINUE_STATEMENT, RETURN_STATEMENT, EXPRESSION_STATEMENT,
+        FUNCTION_DEFINITION, COMPILATION_UNIT
+    };
+    
+    const Kind kind;
+    
+    explicit ASTNode(Kind k) : kind(k) {}
+    virtual ~ASTNode() = default;
+    
+    // 代替 dynamic_cast：T 为具体节点类型，种类不符时 as 返回 nullptr
+    template <typename T> bool is() const { return kind == T::KIND; }
+    template <typename T> T* as() { return is<T>() ? static_cast<T*>(this) : nullptr; }
+    template <typename T> const T* as() const { return is<T>() ? static_cast<const T*>(this) : nullptr; }
+    
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+    
+    virtual void accept(Visitor& visitor) = 0;
+    virtual void print(int indent = 0) const = 0;
+};
+
+// 表达式基类
+class Expression : public ASTNode {
+public:
+    enum Type { INT, VOID };
+    virtual Type getType() const = 0;
+    
+protected:
+    explicit Expression(Kind k) : ASTNode(k) {}
+};
+
+// 语句基类
+class Statement : public ASTNode {
+protected:
+    explicit Statement(Kind k) : ASTNode(k) {}
+};
+
+// 二元表达式
+class BinaryExpression : public Expression {
+public:
+    static const Kind KIND = BINARY_EXPRESSION;
+    
+    enum Operator { 
+        ADD, SUB, MUL, DIV, MOD,
+        LT, LE, GT, GE, EQ, NE,
+        AND, OR
+    };
+    
+    std::unique_ptr<Expression> left;
+    std::unique_ptr<Expression> right;
+    Operator op;
+    
+    BinaryExpression(std::unique_ptr<Expression> l, Operator o, std::unique_ptr<Expression> r)
+        : Expression(KIND), left(std::move(l)), right(std::move(r)), op(o) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+    Type getType() const override { return INT; }
+};
+
+// 一元表达式
+class UnaryExpression : public Expression {
+public:
+    static const Kind KIND = UNARY_EXPRESSION;
+    
+    enum Operator { PLUS, MINUS, NOT };
+    
+    Operator op;
+    std::unique_ptr<Expression> operand;
+    
+    UnaryExpression(Operator o, std::unique_ptr<Expression> expr)
+        : Expression(KIND), op(o), operand(std::move(expr)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+    Type getType() const override { return INT; }
+};
+
+// 数字字面量
+class NumberLiteral : public Expression {
+public:
+    static const Kind KIND = NUMBER_LITERAL;
+    
+    int value;
+    
+    NumberLiteral(int val) : Expression(KIND), value(val) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+    Type getType() const override { return INT; }
+};
+
+// 标识符表达式
+class Identifier : public Expression {
+public:
+    static const Kind KIND = IDENTIFIER;
+    
+    SymbolId name;
+    
+    Identifier(SymbolId n) : Expression(KIND), name(n) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+    Type getType() const override { return INT; }
+};
+
+class Statement;
+class FunctionDefinition;
+class Parameter;
+
+// 子节点数组，与节点一样从分配区分配
+typedef ASTVector<std::unique_ptr<Expression>> ExpressionList;
+typedef ASTVector<std::unique_ptr<Statement>> StatementList;
+typedef ASTVector<Parameter> ParameterList;
+typedef ASTVector<std::unique_ptr<FunctionDefinition>> FunctionList;
+
+// 函数调用表达式
+class FunctionCall : public Expression {
+public:
+    static const Kind KIND = FUNCTION_CALL;
+    
+    SymbolId functionName;
+    ExpressionList arguments;
+    Expression::Type returnType;
+    
+    FunctionCall(SymbolId name, ExpressionList args, Expression::Type type)
+        : Expression(KIND), functionName(name), arguments(std::move(args)), returnType(type) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+    Type getType() const override { return returnType; }
+};
+
+// 赋值语句
+class AssignmentStatement : public Statement {
+public:
+    static const Kind KIND = ASSIGNMENT_STATEMENT;
+    
+    SymbolId variable;
+    std::unique_ptr<Expression> value;
+    
+    AssignmentStatement(SymbolId var, std::unique_ptr<Expression> val)
+        : Statement(KIND), variable(var), value(std::move(val)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 变量声明语句
+class VariableDeclaration : public Statement {
+public:
+    static const Kind KIND = VARIABLE_DECLARATION;
+    
+    SymbolId name;
+    std::unique_ptr<Expression> initializer;
+    
+    VariableDeclaration(SymbolId n, std::unique_ptr<Expression> init)
+        : Statement(KIND), name(n), initializer(std::move(init)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 语句块
+class Block : public Statement {
+public:
+    static const Kind KIND = BLOCK;
+    
+    StatementList statements;
+    
+    Block() : Statement(KIND) {}
+    
+    void addStatement(std::unique_ptr<Statement> stmt) {
+        statements.push_back(std::move(stmt));
+    }
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// If语句
+class IfStatement : public Statement {
+public:
+    static const Kind KIND = IF_STATEMENT;
+    
+    std::unique_ptr<Expression> condition;
+    std::unique_ptr<Statement> thenStatement;
+    std::unique_ptr<Statement> elseStatement; // 可选
+    
+    IfStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> then, 
+                std::unique_ptr<Statement> els = nullptr)
+        : Statement(KIND), condition(std::move(cond)), thenStatement(std::move(then)), elseStatement(std::move(els)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// While语句
+class WhileStatement : public Statement {
+public:
+    static const Kind KIND = WHILE_STATEMENT;
+    
+    std::unique_ptr<Expression> condition;
+    std::unique_ptr<Statement> body;
+    
+    WhileStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> b)
+        : Statement(KIND), condition(std::move(cond)), body(std::move(b)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// Break语句
+class BreakStatement : public Statement {
+public:
+    static const Kind KIND = BREAK_STATEMENT;
+    
+    BreakStatement() : Statement(KIND) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// Continue语句
+class ContinueStatement : public Statement {
+public:
+    static const Kind KIND = CONTINUE_STATEMENT;
+    
+    ContinueStatement() : Statement(KIND) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// Return语句
+class ReturnStatement : public Statement {
+public:
+    static const Kind KIND = RETURN_STATEMENT;
+    
+    std::unique_ptr<Expression> value; // 可选
+    
+    ReturnStatement(std::unique_ptr<Expression> val = nullptr) : Statement(KIND), value(std::move(val)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 表达式语句
+class ExpressionStatement : public Statement {
+public:
+    static const Kind KIND = EXPRESSION_STATEMENT;
+    
+    std::unique_ptr<Expression> expression;
+    
+    ExpressionStatement(std::unique_ptr<Expression> expr) : Statement(KIND), expression(std::move(expr)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 参数定义
+class Parameter {
+public:
+    SymbolId name;
+    Expression::Type type;
+    
+    Parameter(SymbolId n, Expression::Type t) : name(n), type(t) {}
+};
+
+// 函数定义
+class FunctionDefinition : public ASTNode {
+public:
+    static const Kind KIND = FUNCTION_DEFINITION;
+    
+    SymbolId name;
+    Expression::Type returnType;
+    ParameterList parameters;
+    std::unique_ptr<Block> body;
+    
+    FunctionDefinition(SymbolId n, Expression::Type ret, 
+                      ParameterList params, std::unique_ptr<Block> b)
+        : ASTNode(KIND), name(n), returnType(ret), parameters(std::move(params)), body(std::move(b)) {}
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 编译单元（程序根节点）
+// 根节点自身总在堆上分配，并持有解析期间使用的分配区；
+// arena 声明在最前，所有节点析构完之后才整体释放
+class CompilationUnit : public ASTNode {
+public:
+    static const Kind KIND = COMPILATION_UNIT;
+    
+    std::shared_ptr<ASTArena> arena;
+    FunctionList functions;
+    
+    CompilationUnit() : ASTNode(KIND), arena(ASTArena::activeHandle()) {}
+    
+    static void* operator new(size_t size) { return ::operator new(size); }
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+    
+    void addFunction(std::unique_ptr<FunctionDefinition> func) {
+        functions.push_back(std::move(func));
+    }
+    
+    void accept(Visitor& visitor) override;
+    void print(int indent = 0) const override;
+};
+
+// 访问者模式接口
+class Visitor {
+public:
+    virtual ~Visitor() = default;
+    
+    virtual void visit(BinaryExpression& node) = 0;
+    virtual void visit(UnaryExpression& node) = 0;
+    virtual void visit(NumberLiteral& node) = 0;
+    virtual void visit(Identifier& node) = 0;
+    virtual void visit(FunctionCall& node) = 0;
+    virtual void visit(AssignmentStatement& node) = 0;
+    virtual void visit(VariableDeclaration& node) = 0;
+    virtual void visit(Block& node) = 0;
+    virtual void visit(IfStatement& node) = 0;
+    virtual void visit(WhileStatement& node) = 0;
+    virtual void visit(BreakStatement& node) = 0;
+    virtual void visit(ContinueStatement& node) = 0;
+    virtual void visit(ReturnStatement& node) = 0;
+    virtual void visit(ExpressionStatement& node) = 0;
+    virtual void visit(FunctionDefinition& node) = 0;
+    virtual void visit(CompilationUnit& node) = 0;
+};
+
+// 基于节点标签的静态分派（CRTP）：Derived 为每种具体节点提供一个 visit 重载，
+// 返回类型统一为 Result；dispatch 按 kind 直接调用，不经过虚函数 accept/visit。
+// 遍历逻辑由各 visit 自己决定，需要访问子节点时再调用 dispatch
+template <typename Derived, typename Result = void>
+class ASTVisitor {
+public:
+    Result dispatch(ASTNode& node) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (node.kind) {
+            case ASTNode::BINARY_EXPRESSION: return self.visit(static_cast<BinaryExpression&>(node));
+            case ASTNode::UNARY_EXPRESSION: return self.visit(static_cast<UnaryExpression&>(node));
+            case ASTNode::NUMBER_LITERAL: return self.visit(static_cast<NumberLiteral&>(node));
+            case ASTNode::IDENTIFIER: return self.visit(static_cast<Identifier&>(node));
+            case ASTNode::FUNCTION_CALL: return self.visit(static_cast<FunctionCall&>(node));
+            case ASTNode::ASSIGNMENT_STATEMENT: return self.visit(static_cast<AssignmentStatement&>(node));
+            case ASTNode::VARIABLE_DECLARATION: return self.visit(static_cast<VariableDeclaration&>(node));
+            case ASTNode::BLOCK: return self.visit(static_cast<Block&>(node));
+            case ASTNode::IF_STATEMENT: return self.visit(static_cast<IfStatement&>(node));
+            case ASTNode::WHILE_STATEMENT: return self.visit(static_cast<WhileStatement&>(node));
+            case ASTNode::BREAK_STATEMENT: return self.visit(static_cast<BreakStatement&>(node));
+            case ASTNode::CONTINUE_STATEMENT: return self.visit(static_cast<ContinueStatement&>(node));
+            case ASTNode::RETURN_STATEMENT: return self.visit(static_cast<ReturnStatement&>(node));
+            case ASTNode::EXPRESSION_STATEMENT: return self.visit(static_cast<ExpressionStatement&>(node));
+            case ASTNode::FUNCTION_DEFINITION: return self.visit(static_cast<FunctionDefinition&>(node));
+            case ASTNode::COMPILATION_UNIT: break;
+        }
+        return self.visit(static_cast<CompilationUnit&>(node));
+    }
+};
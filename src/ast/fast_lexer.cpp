@@ -0,0 +1,184 @@
+#include "ast/fast_lexer.hpp"
+#include "parser.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+
+// 字符类别，按字节查表
+enum CharClass : unsigned char {
+    OTHER_CHAR = 0,
+    IDENT_START = 1,   // [a-zA-Z_]
+    DIGIT_CHAR = 2,    // [0-9]
+    BLANK_CHAR = 4,    // [ \t\r]
+};
+
+struct CharClassTable {
+    unsigned char classes[256];
+    
+    CharClassTable() {
+        std::memset(classes, OTHER_CHAR, sizeof(classes));
+        for (int c = 'a'; c <= 'z'; ++c) classes[c] = IDENT_START;
+        for (int c = 'A'; c <= 'Z'; ++c) classes[c] = IDENT_START;
+        classes['_'] = IDENT_START;
+        for (int c = '0'; c <= '9'; ++c) classes[c] = DIGIT_CHAR;
+        classes[' '] = classes['\t'] = classes['\r'] = BLANK_CHAR;
+    }
+};
+
+static const CharClassTable charTable;
+
+static inline unsigned char classOf(char c) {
+    return charTable.classes[(unsigned char)c];
+}
+
+// 关键字按长度和内容判断；标识符的规则与关键字同长时 Flex 取先出现的关键字规则
+static int keyword(const char* text, size_t length) {
+    switch (length) {
+    case 2:
+        if (text[0] == 'i' && text[1] == 'f') return IF;
+        break;
+    case 3:
+        if (std::memcmp(text, "int", 3) == 0) return INT;
+        break;
+    case 4:
+        if (std::memcmp(text, "void", 4) == 0) return VOID;
+        if (std::memcmp(text, "else", 4) == 0) return ELSE;
+        break;
+    case 5:
+        if (std::memcmp(text, "while", 5) == 0) return WHILE;
+        if (std::memcmp(text, "break", 5) == 0) return BREAK;
+        break;
+    case 6:
+        if (std::memcmp(text, "return", 6) == 0) return RETURN;
+        break;
+    case 8:
+        if (std::memcmp(text, "continue", 8) == 0) return CONTINUE;
+        break;
+    }
+    return 0;
+}
+
+FastLexer::FastLexer(const char* input, size_t size, ParseContext& context)
+    : begin(input), cursor(input), end(input + size), ruleStart(input), tokenStart(input), tokenEnd(input),
+      context(context), line(1) {}
+
+int FastLexer::token(const char* start, int kind) {
+    ruleStart = tokenStart = start;
+    tokenEnd = cursor;
+    context.tokenOffset = (size_t)(start - begin);
+    context.scanOffset = (size_t)(cursor - begin);
+    return kind;
+}
+
+// cursor 指向 "/*"。找到结束的 "*/" 并统计其中的换行；到输入末尾仍未结束时报告错误
+void FastLexer::skipBlockComment() {
+    const char* body = cursor + 2;
+    const char* close = body;
+    while (true) {
+        close = static_cast<const char*>(std::memchr(close, '/', end - close));
+        if (!close || (close > body && close[-1] == '*')) break;
+        close++;
+    }
+    const char* stop = close ? close + 1 : end;
+    for (const char* p = body; (p = static_cast<const char*>(std::memchr(p, '\n', stop - p))) != nullptr; ++p) {
+        line++;
+    }
+    cursor = stop;
+    if (!close) {
+        context.diagnostics << "Unterminated comment at line " << line << std::endl;
+    }
+}
+
+int FastLexer::next(YYSTYPE& value) {
+    while (cursor < end) {
+        const char* start = cursor;
+        char c = *cursor;
+        unsigned char kind = classOf(c);
+        
+        if (kind == BLANK_CHAR) {
+            ruleStart = start;
+            while (++cursor < end && classOf(*cursor) == BLANK_CHAR) {}
+            continue;
+        }
+        if (c == '\n') {
+            ruleStart = start;
+            line++;
+            cursor++;
+            continue;
+        }
+        if (kind == IDENT_START) {
+            while (++cursor < end && (classOf(*cursor) & (IDENT_START | DIGIT_CHAR))) {}
+            size_t length = cursor - start;
+            int reserved = keyword(start, length);
+            if (reserved) return token(start, reserved);
+            value.sym_val = SymbolId::intern(start, length);
+            return token(start, ID);
+        }
+        if (kind == DIGIT_CHAR || (c == '-' && cursor + 1 < end && classOf(cursor[1]) == DIGIT_CHAR)) {
+            // -?(0|[1-9][0-9]*)：前导 0 单独成为一个记号
+            const char* digits = c == '-' ? cursor + 1 : cursor;
+            cursor = digits + 1;
+            if (*digits != '0') {
+                while (cursor < end && classOf(*cursor) == DIGIT_CHAR) cursor++;
+            }
+            // 与 Flex 规则一样按 strtol 取值；记号之后不是数字，strtol 恰好停在记号末尾
+            value.int_val = *digits == '0' ? 0 : (int)std::strtol(start, nullptr, 10);
+            return token(start, NUMBER_LITERAL);
+        }
+        
+        cursor++;
+        char following = cursor < end ? *cursor : '\0';
+        switch (c) {
+        case '/':
+            if (following == '/') {
+                ruleStart = start;
+                const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+                cursor = newline ? newline : end;
+                continue;
+            }
+            if (following == '*') {
+                ruleStart = start;
+                cursor = start;
+                skipBlockComment();
+                continue;
+            }
+            return token(start, DIVIDE);
+        case '+': return token(start, PLUS);
+        case '-': return token(start, MINUS);
+        case '*': return token(start, MULTIPLY);
+        case '%': return token(start, MOD);
+        case '(': return token(start, LPAREN);
+        case ')': return token(start, RPAREN);
+        case '{': return token(start, LBRACE);
+        case '}': return token(start, RBRACE);
+        case ',': return token(start, COMMA);
+        case ';': return token(start, SEMICOLON);
+        case '=':
+            if (following == '=') { cursor++; return token(start, EQ); }
+            return token(start, ASSIGN);
+        case '!':
+            if (following == '=') { cursor++; return token(start, NE); }
+            return token(start, NOT);
+        case '<':
+            if (following == '=') { cursor++; return token(start, LE); }
+            return token(start, LT);
+        case '>':
+            if (following == '=') { cursor++; return token(start, GE); }
+            return token(start, GT);
+        case '&':
+            if (following == '&') { cursor++; return token(start, AND); }
+            break;
+        case '|':
+            if (following == '|') { cursor++; return token(start, OR); }
+            break;
+        }
+        token(start, ERROR);
+        context.diagnostics << "Illegal character '" << c << "' at line " << line
+                            << ", offset " << context.tokenOffset << std::endl;
+        return ERROR;
+    }
+    // 与 Flex 相同：输入结束时偏移停在最后一次匹配处，记号文本为空
+    tokenStart = tokenEnd = end;
+    context.tokenOffset = (size_t)(ruleStart - begin);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "ast/parse.hpp"
+#include <cstddef>
+#include <string>
+
+union YYSTYPE;
+
+// 手写的扫描器，给出与 lexer.l 中 Flex 规则相同的记号、记号值、偏移和诊断信息，用于原地扫描内存中的输入。
+// 字符按表分类；注释用 memchr（libc 的向量化实现）直接找结束符，不逐字符读取；
+// 不修改输入，标识符直接从输入中驻留，扫描过程中不分配内存
+class FastLexer {
+public:
+    FastLexer(const char* input, size_t size, ParseContext& context);
+    
+    // 下一个记号（parser.hpp 中的编号），值写入 value；输入结束时返回 0
+    int next(YYSTYPE& value);
+    
+    int lineno() const { return line; }
+    // 最近一个记号的文本（语法错误信息用）
+    std::string text() const { return std::string(tokenStart, tokenEnd - tokenStart); }
+    
+private:
+    const char* begin;
+    const char* cursor;
+    const char* end;
+    const char* ruleStart;   // 最近一次匹配（含空白和注释）的起点，对应 Flex 的 YY_USER_ACTION
+    const char* tokenStart;
+    const char* tokenEnd;
+    ParseContext& context;
+    int line;
+    
+    int token(const char* start, int kind);
+    void skipBlockComment();
+};
@@ -0,0 +1,247 @@
+#include "ast/flat_ast.hpp"
+#include "opt/constant_folder.hpp"
+#include <cstdint>
+
+FlatAST::Index FlatAST::append(ASTNode::Kind kind, int op, int value, Index first, Index second) {
+    Node node;
+    node.kind = (uint8_t)kind;
+    node.op = (uint8_t)op;
+    node.reserved = 0;
+    node.value = value;
+    node.first = first;
+    node.second = second;
+    nodes.push_back(node);
+    Index index = (Index)nodes.size() - 1;
+    stack.push_back(index);
+    return index;
+}
+
+FlatAST::Index FlatAST::pop() {
+    Index index = stack.back();
+    stack.pop_back();
+    return index;
+}
+
+FlatAST::Index FlatAST::popList(size_t count) {
+    Index start = (Index)lists.size();
+    lists.insert(lists.end(), stack.end() - count, stack.end());
+    stack.resize(stack.size() - count);
+    return start;
+}
+
+void FlatAST::number(int value) {
+    append(ASTNode::NUMBER_LITERAL, 0, value, NONE, NONE);
+}
+
+void FlatAST::identifier(SymbolId name) {
+    append(ASTNode::IDENTIFIER, 0, (int)name.index(), NONE, NONE);
+}
+
+void FlatAST::binary(BinaryExpression::Operator op) {
+    Index right = pop();
+    Index left = pop();
+    append(ASTNode::BINARY_EXPRESSION, op, 0, left, right);
+}
+
+void FlatAST::unary(UnaryExpression::Operator op) {
+    Index operand = pop();
+    append(ASTNode::UNARY_EXPRESSION, op, 0, operand, NONE);
+}
+
+void FlatAST::call(SymbolId callee, size_t argCount) {
+    Index start = popList(argCount);
+    append(ASTNode::FUNCTION_CALL, 0, (int)callee.index(), start, (Index)argCount);
+}
+
+void FlatAST::assignment(SymbolId variable) {
+    Index value = pop();
+    append(ASTNode::ASSIGNMENT_STATEMENT, 0, (int)variable.index(), value, NONE);
+}
+
+void FlatAST::declaration(SymbolId name, bool hasInitializer) {
+    Index initializer = hasInitializer ? pop() : NONE;
+    append(ASTNode::VARIABLE_DECLARATION, 0, (int)name.index(), initializer, NONE);
+}
+
+void FlatAST::expressionStatement() {
+    Index expression = pop();
+    append(ASTNode::EXPRESSION_STATEMENT, 0, 0, expression, NONE);
+}
+
+void FlatAST::ifStatement(bool hasElse) {
+    Index elseStatement = hasElse ? pop() : NONE;
+    Index thenStatement = pop();
+    Index condition = pop();
+    Index start = (Index)lists.size();
+    lists.push_back(thenStatement);
+    lists.push_back(elseStatement);
+    append(ASTNode::IF_STATEMENT, hasElse, 0, condition, start);
+}
+
+void FlatAST::whileStatement() {
+    Index body = pop();
+    Index condition = pop();
+    append(ASTNode::WHILE_STATEMENT, 0, 0, condition, body);
+}
+
+void FlatAST::breakStatement() {
+    append(ASTNode::BREAK_STATEMENT, 0, 0, NONE, NONE);
+}
+
+void FlatAST::continueStatement() {
+    append(ASTNode::CONTINUE_STATEMENT, 0, 0, NONE, NONE);
+}
+
+void FlatAST::returnStatement(bool hasValue) {
+    Index value = hasValue ? pop() : NONE;
+    append(ASTNode::RETURN_STATEMENT, 0, 0, value, NONE);
+}
+
+void FlatAST::block(size_t count) {
+    Index start = popList(count);
+    append(ASTNode::BLOCK, 0, 0, start, (Index)count);
+}
+
+void FlatAST::function(SymbolId name, Expression::Type returnType, const ParameterList& params) {
+    Index body = pop();
+    Index start = (Index)lists.size();
+    lists.push_back((Index)params.size());
+    for (const auto& param : params) {
+        lists.push_back(param.name.index());
+    }
+    append(ASTNode::FUNCTION_DEFINITION, returnType, (int)name.index(), body, start);
+}
+
+void FlatAST::finish() {
+    size_t count = stack.size();
+    Index start = popList(count);
+    append(ASTNode::COMPILATION_UNIT, 0, 0, start, (Index)count);
+    stack.clear();
+}
+
+// 后序遍历指针树，按与语法分析器相同的顺序追加节点
+class FlatASTConverter : public ASTVisitor<FlatASTConverter> {
+public:
+    FlatAST& flat;
+    
+    explicit FlatASTConverter(FlatAST& f) : flat(f) {}
+    
+    void visit(BinaryExpression& node) {
+        dispatch(*node.left);
+        dispatch(*node.right);
+        flat.binary(node.op);
+    }
+    void visit(UnaryExpression& node) {
+        dispatch(*node.operand);
+        flat.unary(node.op);
+    }
+    void visit(NumberLiteral& node) { flat.number(node.value); }
+    void visit(Identifier& node) { flat.identifier(node.name); }
+    void visit(FunctionCall& node) {
+        for (auto& arg : node.arguments) dispatch(*arg);
+        flat.call(node.functionName, node.arguments.size());
+    }
+    void visit(AssignmentStatement& node) {
+        dispatch(*node.value);
+        flat.assignment(node.variable);
+    }
+    void visit(VariableDeclaration& node) {
+        if (node.initializer) dispatch(*node.initializer);
+        flat.declaration(node.name, node.initializer != nullptr);
+    }
+    void visit(Block& node) {
+        for (auto& stmt : node.statements) dispatch(*stmt);
+        flat.block(node.statements.size());
+    }
+    void visit(IfStatement& node) {
+        dispatch(*node.condition);
+        dispatch(*node.thenStatement);
+        if (node.elseStatement) dispatch(*node.elseStatement);
+        flat.ifStatement(node.elseStatement != nullptr);
+    }
+    void visit(WhileStatement& node) {
+        dispatch(*node.condition);
+        dispatch(*node.body);
+        flat.whileStatement();
+    }
+    void visit(BreakStatement&) { flat.breakStatement(); }
+    void visit(ContinueStatement&) { flat.continueStatement(); }
+    void visit(ReturnStatement& node) {
+        if (node.value) dispatch(*node.value);
+        flat.returnStatement(node.value != nullptr);
+    }
+    void visit(ExpressionStatement& node) {
+        dispatch(*node.expression);
+        flat.expressionStatement();
+    }
+    void visit(FunctionDefinition& node) {
+        dispatch(*node.body);
+        flat.function(node.name, node.returnType, node.parameters);
+    }
+    void visit(CompilationUnit& node) {
+        for (auto& func : node.functions) dispatch(*func);
+        flat.finish();
+    }
+};
+
+FlatAST FlatAST::fromTree(CompilationUnit& unit) {
+    FlatAST flat;
+    FlatASTConverter converter(flat);
+    converter.dispatch(unit);
+    return flat;
+}
+
+int FlatAST::foldConstants() {
+    int folded = 0;
+    for (Node& node : nodes) {
+        if (node.kind == ASTNode::BINARY_EXPRESSION) {
+            const Node& left = nodes[node.first];
+            const Node& right = nodes[node.second];
+            int result;
+            if (left.kind != ASTNode::NUMBER_LITERAL || right.kind != ASTNode::NUMBER_LITERAL ||
+                !ConstantFolder::evaluate((BinaryExpression::Operator)node.op, left.value, right.value, result)) {
+                continue;
+            }
+            node.value = result;
+        } else if (node.kind == ASTNode::UNARY_EXPRESSION) {
+            const Node& operand = nodes[node.first];
+            if (operand.kind != ASTNode::NUMBER_LITERAL) continue;
+            switch ((UnaryExpression::Operator)node.op) {
+                case UnaryExpression::PLUS: node.value = operand.value; break;
+                case UnaryExpression::MINUS: node.value = (int)(0u - (uint32_t)operand.value); break;
+                case UnaryExpression::NOT: node.value = !operand.value; break;
+            }
+        } else {
+            continue;
+        }
+        node.kind = ASTNode::NUMBER_LITERAL;
+        node.op = 0;
+        node.first = node.second = NONE;
+        folded++;
+    }
+    return folded;
+}
+
+std::vector<std::string> FlatAST::checkCalls() const {
+    // 函数定义在后序中位于其函数体之后，先扫一遍收集参数个数
+    SymbolMap<Index> arity;
+    for (const Node& node : nodes) {
+        if (node.kind == ASTNode::FUNCTION_DEFINITION) {
+            arity[SymbolId::fromIndex(node.value)] = lists[node.second];
+        }
+    }
+    
+    std::vector<std::string> errors;
+    for (const Node& node : nodes) {
+        if (node.kind != ASTNode::FUNCTION_CALL) continue;
+        SymbolId callee = SymbolId::fromIndex(node.value);
+        const Index* expected = arity.find(callee);
+        if (!expected) {
+            errors.push_back("Undefined function '" + callee.str() + "'");
+        } else if (*expected != node.second) {
+            errors.push_back("Function '" + callee.str() + "' expects " + std::to_string(*expected) +
+                             " arguments, got " + std::to_string(node.second));
+        }
+    }
+    return errors;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "common/symbol.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// AST 的扁平编码：全部节点按后序存放在一个连续数组中，子节点用 32 位下标引用。
+// 后序保证子节点总在父节点之前，自底向上的分析（常量求值、调用检查等）只需顺序扫描一遍，
+// 不再沿指针在堆上跳转。变长的子节点列表存放在 lists 中，节点只记录起始位置和长度。
+//
+// 节点的构造顺序就是 Bison 的归约顺序：语法分析器设置 flatOutput 后在每次归约时直接追加节点，
+// 也可以用 fromTree 从指针树转换。构造期间维护一个下标栈，与分析器的语义值栈一一对应：
+// 每个构造函数从栈顶取走子节点，再压入新节点。
+class FlatAST {
+public:
+    typedef uint32_t Index;
+    static const Index NONE = UINT32_MAX;
+    
+    // 16 字节。各种节点对字段的使用：
+    //   NUMBER_LITERAL       value = 字面量
+    //   IDENTIFIER           value = SymbolId
+    //   BINARY/UNARY         op = 运算符，first/second = 操作数
+    //   FUNCTION_CALL        value = 被调函数，first/second = 实参在 lists 中的起始位置/个数
+    //   ASSIGNMENT/VARIABLE_DECLARATION  value = 变量，first = 值（无初始化时为 NONE）
+    //   EXPRESSION/RETURN    first = 表达式（return 无返回值时为 NONE）
+    //   IF                   first = 条件，second = lists 中 [then, else] 的起始位置，op = 是否有 else
+    //   WHILE                first = 条件，second = 循环体
+    //   BLOCK/COMPILATION_UNIT  first/second = 子节点在 lists 中的起始位置/个数
+    //   FUNCTION_DEFINITION  value = 函数名，op = 返回类型，first = 函数体，
+    //                        second = lists 中的起始位置：[参数个数, 参数的 SymbolId...]
+    struct Node {
+        uint8_t kind;   // ASTNode::Kind
+        uint8_t op;
+        uint16_t reserved;
+        int32_t value;
+        Index first;
+        Index second;
+    };
+    
+    std::vector<Node> nodes;
+    std::vector<Index> lists;
+    
+    static FlatAST fromTree(CompilationUnit& unit);
+    
+    size_t size() const { return nodes.size(); }
+    const Node& operator[](Index index) const { return nodes[index]; }
+    Node& operator[](Index index) { return nodes[index]; }
+    // 根节点（COMPILATION_UNIT）总在最后
+    Index root() const { return nodes.empty() ? NONE : (Index)nodes.size() - 1; }
+    size_t bytesUsed() const { return nodes.size() * sizeof(Node) + lists.size() * sizeof(Index); }
+    
+    const Index* children(const Node& node) const { return lists.data() + node.first; }
+    
+    // 按后序追加节点
+    void number(int value);
+    void identifier(SymbolId name);
+    void binary(BinaryExpression::Operator op);
+    void unary(UnaryExpression::Operator op);
+    void call(SymbolId callee, size_t argCount);
+    void assignment(SymbolId variable);
+    void declaration(SymbolId name, bool hasInitializer);
+    void expressionStatement();
+    void ifStatement(bool hasElse);
+    void whileStatement();
+    void breakStatement();
+    void continueStatement();
+    void returnStatement(bool hasValue);
+    void block(size_t count);
+    void function(SymbolId name, Expression::Type returnType, const ParameterList& params);
+    // 把栈上剩余的函数包成根节点，构造结束
+    void finish();
+    
+    // 顺序扫描的分析：
+    // 把操作数全为常量的二元、一元运算原地改写为字面量，返回改写个数；
+    // 被改写节点的子节点留在数组中但不再被引用。x*1、常量一侧的 && 等代数化简仍由 ConstantFolder 完成
+    int foldConstants();
+    // 检查每个调用的被调函数已定义且实参个数匹配，错误信息与语义分析一致
+    std::vector<std::string> checkCalls() const;
+    
+private:
+    std::vector<Index> stack;
+    
+    Index append(ASTNode::Kind kind, int op, int value, Index first, Index second);
+    Index pop();
+    // 把栈顶 count 个节点按原顺序移到 lists，返回起始位置
+    Index popList(size_t count);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "ast/flat_ast.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <ostream>
+
+class FastLexer;
+
+// 原地扫描内存中的输入时使用的扫描器：默认为手写的 FastLexer，Flex 生成的扫描器留作对照
+enum LexerKind { FAST_LEXER, FLEX_LEXER };
+
+// 流式分析时，每归约出一个函数定义就交给它处理，而不是追加到 root；返回 false 时中止分析
+typedef std::function<bool(std::unique_ptr<FunctionDefinition>)> FunctionHandler;
+
+// 一次语法分析的全部状态，取代扫描器和分析器原来的全局变量：
+// 可重入的 Flex 扫描器把它作为 extra 数据，纯 Bison 分析器通过参数取得它，
+// 因此不同线程可以同时分析各自的输入。
+struct ParseContext {
+    std::unique_ptr<CompilationUnit> root;
+    FlatAST* flatOutput;        // 非空时在归约的同时追加扁平 AST 节点，分析结束后由调用者执行 finish()
+    std::ostream& diagnostics;  // 词法、语法错误
+    size_t tokenOffset;         // 当前记号在输入中的字节偏移；扫描内存映射的文件时就是映射区中的下标
+    size_t scanOffset;
+    size_t inputSize;           // 原地扫描时输入内容的长度（不含结尾的 '\0'），读文件流时为 SIZE_MAX
+    const FunctionHandler* onFunction;  // 非空时逐个交出函数定义，root 始终为空
+    FastLexer* fastLexer;       // 非空时记号来自手写扫描器，不使用 Flex 的扫描器对象
+    
+    ParseContext(std::ostream& diag, FlatAST* flat, const FunctionHandler* handler = nullptr)
+        : flatOutput(flat), diagnostics(diag), tokenOffset(0), scanOffset(0), inputSize(SIZE_MAX), onFunction(handler),
+          fastLexer(nullptr) {}
+    
+    // FuncDef 归约完成时由分析器调用
+    bool addFunction(FunctionDefinition* function) {
+        std::unique_ptr<FunctionDefinition> owned(function);
+        if (onFunction) return (*onFunction)(std::move(owned));
+        root->addFunction(std::move(owned));
+        return true;
+    }
+};
+
+// 原地扫描内存中的输入，buffer 最后两个字节必须是 '\0'，size 包含它们（见 SourceFile）。
+// 失败时返回 nullptr，错误写入 diagnostics。节点从调用线程当前的 ASTArena（若已安装）分配。
+// 给出 onFunction 时为流式分析：各函数定义依次交给它，返回的编译单元不含函数
+std::unique_ptr<CompilationUnit> parseBuffer(char* buffer, size_t size, std::ostream& diagnostics, FlatAST* flat = nullptr,
+                                             const FunctionHandler* onFunction = nullptr, LexerKind lexer = FAST_LEXER);
+// 从文件流（如标准输入）读取并分析，总是使用 Flex 的扫描器
+std::unique_ptr<CompilationUnit> parseStream(FILE* input, std::ostream& diagnostics, FlatAST* flat = nullptr,
+                                             const FunctionHandler* onFunction = nullptr);
+// 只做词法分析，返回记号个数（基准测试用）；对 buffer 的要求与 parseBuffer 相同
+size_t lexBuffer(char* buffer, size_t size, std::ostream& diagnostics, LexerKind lexer = FAST_LEXER);
+// 只做词法分析，每个记号向 tokens 写一行 "行号 偏移 记号编号 文本"，数字和标识符另附记号值。
+// 用于对照两种扫描器（toyc_lexcheck）；返回记号个数
+size_t dumpTokens(char* buffer, size_t size, std::ostream& tokens, std::ostream& diagnostics, LexerKind lexer = FAST_LEXER);
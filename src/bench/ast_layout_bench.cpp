@@ -0,0 +1,331 @@
+// 指针树 AST 与扁平后序 AST 的遍历开销对比。
+// 生成一个大规模的 ToyC 程序，同一遍语法分析同时得到两种表示，然后分别重复执行两种遍历：
+//   checksum  访问每个节点一次（只读）
+//   constant  自底向上求出全常量的子表达式个数（常量折叠的分析部分）
+// 指针树分别测 arena 分配和逐个堆分配两种布局。
+//
+// 用法: ast_layout_bench [函数个数] [每个函数的语句数] [重复次数]
+#include "ast/ast.hpp"
+#include "ast/arena.hpp"
+#include "ast/flat_ast.hpp"
+#include "ast/parse.hpp"
+#include "opt/constant_folder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom() {
+    randomState = randomState * 1103515245u + 12345u;
+    return randomState >> 16;
+}
+
+// 深度有限的随机表达式，其中约一半的叶子是常量，使部分子树可以折叠
+static void generateExpression(std::ostream& out, int depth, int function) {
+    if (depth == 0 || nextRandom() % 4 == 0) {
+        switch (nextRandom() % 4) {
+            case 0: out << "a"; break;
+            case 1: out << "b"; break;
+            default: out << nextRandom() % 100; break;
+        }
+        return;
+    }
+    static const char* ops[] = {"+", "-", "*", "/", "<", "==", "&&", "||"};
+    unsigned choice = nextRandom() % 10;
+    if (choice == 8) {
+        out << "!(";
+        generateExpression(out, depth - 1, function);
+        out << ")";
+    } else if (choice == 9 && function > 0) {
+        out << "f" << function - 1 << "(";
+        generateExpression(out, depth - 1, function);
+        out << ", ";
+        generateExpression(out, depth - 1, function);
+        out << ")";
+    } else {
+        out << "(";
+        generateExpression(out, depth - 1, function);
+        out << " " << ops[choice % 8] << " ";
+        generateExpression(out, depth - 1, function);
+        out << ")";
+    }
+}
+
+static std::string generateProgram(int functions, int statements) {
+    std::ostringstream out;
+    for (int f = 0; f < functions; ++f) {
+        out << "int f" << f << "(int a, int b) {\n";
+        out << "    int s = 0;\n";
+        for (int i = 0; i < statements; ++i) {
+            if (i % 5 == 4) {
+                out << "    if (s > " << i << ") { s = ";
+                generateExpression(out, 3, f);
+                out << "; } else { s = s + 1; }\n";
+            } else {
+                out << "    s = s + ";
+                generateExpression(out, 5, f);
+                out << ";\n";
+            }
+        }
+        out << "    return s;\n}\n";
+    }
+    out << "int main() {\n    return f" << functions - 1 << "(1, 2);\n}\n";
+    return out.str();
+}
+
+static std::unique_ptr<CompilationUnit> parse(const std::string& source, bool useArena, FlatAST* flat) {
+    FILE* input = fmemopen((void*)source.data(), source.size(), "r");
+    if (!input) {
+        std::perror("fmemopen");
+        std::exit(1);
+    }
+    std::unique_ptr<CompilationUnit> root;
+    if (useArena) {
+        ASTArena::Scope scope(std::make_shared<ASTArena>());
+        root = parseStream(input, std::cerr, flat);
+    } else {
+        root = parseStream(input, std::cerr, flat);
+    }
+    std::fclose(input);
+    if (!root) {
+        std::cerr << "Error: generated program failed to parse" << std::endl;
+        std::exit(1);
+    }
+    if (flat) flat->finish();
+    return root;
+}
+
+// 每个节点贡献 kind * 7 + 值（字面量的值或标识符的 SymbolId），两种表示的结果应当相同
+class TreeChecksum : public ASTVisitor<TreeChecksum> {
+public:
+    uint32_t sum = 0;
+    size_t nodes = 0;
+    
+    void add(const ASTNode& node, int value) {
+        sum += (uint32_t)node.kind * 7u + (uint32_t)value;
+        nodes++;
+    }
+    void visit(BinaryExpression& node) { dispatch(*node.left); dispatch(*node.right); add(node, 0); }
+    void visit(UnaryExpression& node) { dispatch(*node.operand); add(node, 0); }
+    void visit(NumberLiteral& node) { add(node, node.value); }
+    void visit(Identifier& node) { add(node, (int)node.name.index()); }
+    void visit(FunctionCall& node) {
+        for (auto& arg : node.arguments) dispatch(*arg);
+        add(node, (int)node.functionName.index());
+    }
+    void visit(AssignmentStatement& node) { dispatch(*node.value); add(node, (int)node.variable.index()); }
+    void visit(VariableDeclaration& node) {
+        if (node.initializer) dispatch(*node.initializer);
+        add(node, (int)node.name.index());
+    }
+    void visit(Block& node) {
+        for (auto& stmt : node.statements) dispatch(*stmt);
+        add(node, 0);
+    }
+    void visit(IfStatement& node) {
+        dispatch(*node.condition);
+        dispatch(*node.thenStatement);
+        if (node.elseStatement) dispatch(*node.elseStatement);
+        add(node, 0);
+    }
+    void visit(WhileStatement& node) { dispatch(*node.condition); dispatch(*node.body); add(node, 0); }
+    void visit(BreakStatement& node) { add(node, 0); }
+    void visit(ContinueStatement& node) { add(node, 0); }
+    void visit(ReturnStatement& node) {
+        if (node.value) dispatch(*node.value);
+        add(node, 0);
+    }
+    void visit(ExpressionStatement& node) { dispatch(*node.expression); add(node, 0); }
+    void visit(FunctionDefinition& node) { dispatch(*node.body); add(node, (int)node.name.index()); }
+    void visit(CompilationUnit& node) {
+        for (auto& func : node.functions) dispatch(*func);
+        add(node, 0);
+    }
+};
+
+static uint32_t flatChecksum(const FlatAST& flat) {
+    uint32_t sum = 0;
+    for (const FlatAST::Node& node : flat.nodes) {
+        bool valued = node.kind == ASTNode::NUMBER_LITERAL || node.kind == ASTNode::IDENTIFIER ||
+                      node.kind == ASTNode::FUNCTION_CALL || node.kind == ASTNode::ASSIGNMENT_STATEMENT ||
+                      node.kind == ASTNode::VARIABLE_DECLARATION || node.kind == ASTNode::FUNCTION_DEFINITION;
+        sum += (uint32_t)node.kind * 7u + (valued ? (uint32_t)node.value : 0u);
+    }
+    return sum;
+}
+
+// 返回子表达式是否为常量（值放在 value 中），并统计可折叠的运算个数
+class TreeConstants : public ASTVisitor<TreeConstants, bool> {
+public:
+    int value = 0;
+    size_t foldable = 0;
+    
+    bool visit(BinaryExpression& node) {
+        bool left = dispatch(*node.left);
+        int lhs = value;
+        bool right = dispatch(*node.right);
+        if (!left || !right || !ConstantFolder::evaluate(node.op, lhs, value, value)) return false;
+        foldable++;
+        return true;
+    }
+    bool visit(UnaryExpression& node) {
+        if (!dispatch(*node.operand)) return false;
+        value = node.op == UnaryExpression::MINUS ? (int)(0u - (uint32_t)value) :
+                node.op == UnaryExpression::NOT ? !value : value;
+        foldable++;
+        return true;
+    }
+    bool visit(NumberLiteral& node) { value = node.value; return true; }
+    bool visit(Identifier&) { return false; }
+    bool visit(FunctionCall& node) {
+        for (auto& arg : node.arguments) dispatch(*arg);
+        return false;
+    }
+    bool visit(AssignmentStatement& node) { dispatch(*node.value); return false; }
+    bool visit(VariableDeclaration& node) {
+        if (node.initializer) dispatch(*node.initializer);
+        return false;
+    }
+    bool visit(Block& node) {
+        for (auto& stmt : node.statements) dispatch(*stmt);
+        return false;
+    }
+    bool visit(IfStatement& node) {
+        dispatch(*node.condition);
+        dispatch(*node.thenStatement);
+        if (node.elseStatement) dispatch(*node.elseStatement);
+        return false;
+    }
+    bool visit(WhileStatement& node) { dispatch(*node.condition); dispatch(*node.body); return false; }
+    bool visit(BreakStatement&) { return false; }
+    bool visit(ContinueStatement&) { return false; }
+    bool visit(ReturnStatement& node) {
+        if (node.value) dispatch(*node.value);
+        return false;
+    }
+    bool visit(ExpressionStatement& node) { dispatch(*node.expression); return false; }
+    bool visit(FunctionDefinition& node) { dispatch(*node.body); return false; }
+    bool visit(CompilationUnit& node) {
+        for (auto& func : node.functions) dispatch(*func);
+        return false;
+    }
+};
+
+// 扁平表示上的同一分析：顺序扫描，子节点的结果已在前面算好
+static size_t flatConstants(const FlatAST& flat, std::vector<uint8_t>& isConst, std::vector<int>& values) {
+    size_t n = flat.size();
+    isConst.assign(n, 0);
+    values.resize(n);
+    size_t foldable = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const FlatAST::Node& node = flat.nodes[i];
+        switch (node.kind) {
+            case ASTNode::NUMBER_LITERAL:
+                isConst[i] = 1;
+                values[i] = node.value;
+                break;
+            case ASTNode::BINARY_EXPRESSION:
+                if (isConst[node.first] && isConst[node.second] &&
+                    ConstantFolder::evaluate((BinaryExpression::Operator)node.op, values[node.first], values[node.second], values[i])) {
+                    isConst[i] = 1;
+                    foldable++;
+                }
+                break;
+            case ASTNode::UNARY_EXPRESSION:
+                if (isConst[node.first]) {
+                    int v = values[node.first];
+                    values[i] = node.op == UnaryExpression::MINUS ? (int)(0u - (uint32_t)v) :
+                                node.op == UnaryExpression::NOT ? !v : v;
+                    isConst[i] = 1;
+                    foldable++;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return foldable;
+}
+
+// 重复执行 body，返回单次的最短耗时（纳秒）
+template <typename Body>
+static double bestOf(int iterations, Body body) {
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 200;
+    int statements = argc > 2 ? std::atoi(argv[2]) : 100;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+    if (functions < 1 || statements < 1 || iterations < 1) {
+        std::cerr << "Usage: " << argv[0] << " [functions] [statements] [iterations]" << std::endl;
+        return 1;
+    }
+    
+    std::string source = generateProgram(functions, statements);
+    FlatAST flat;
+    std::unique_ptr<CompilationUnit> arenaTree = parse(source, true, &flat);
+    std::unique_ptr<CompilationUnit> heapTree = parse(source, false, nullptr);
+    
+    // 语法分析器直接产生的扁平表示应与从指针树转换的完全一致
+    FlatAST converted = FlatAST::fromTree(*arenaTree);
+    TreeChecksum reference;
+    reference.dispatch(*arenaTree);
+    if (converted.size() != flat.size() || flatChecksum(converted) != flatChecksum(flat) ||
+        reference.nodes != flat.size() || reference.sum != flatChecksum(flat)) {
+        std::cerr << "Error: flat AST does not match the pointer tree" << std::endl;
+        return 1;
+    }
+    
+    size_t nodes = flat.size();
+    std::cout << "source: " << source.size() << " bytes, " << functions << " functions, " << nodes << " nodes\n";
+    std::cout << "memory: arena tree " << arenaTree->arena->bytesUsed() << " bytes, flat "
+              << flat.bytesUsed() << " bytes\n\n";
+    
+    volatile uint32_t sink = 0;
+    double treeArena = bestOf(iterations, [&] { TreeChecksum c; c.dispatch(*arenaTree); sink = c.sum; });
+    double treeHeap = bestOf(iterations, [&] { TreeChecksum c; c.dispatch(*heapTree); sink = c.sum; });
+    double flatScan = bestOf(iterations, [&] { sink = flatChecksum(flat); });
+    
+    std::vector<uint8_t> isConst;
+    std::vector<int> values;
+    size_t treeFoldable = 0, flatFoldable = 0;
+    double constArena = bestOf(iterations, [&] { TreeConstants c; c.dispatch(*arenaTree); treeFoldable = c.foldable; });
+    double constHeap = bestOf(iterations, [&] { TreeConstants c; c.dispatch(*heapTree); treeFoldable = c.foldable; });
+    double constFlat = bestOf(iterations, [&] { flatFoldable = flatConstants(flat, isConst, values); });
+    if (treeFoldable != flatFoldable) {
+        std::cerr << "Error: constant analysis differs (" << treeFoldable << " vs " << flatFoldable << ")" << std::endl;
+        return 1;
+    }
+    (void)sink;
+    
+    // 顺序扫描的改写与检查：折叠个数应与上面的分析一致，生成的程序里没有错误调用
+    FlatAST folded = flat;
+    if (folded.foldConstants() != (int)flatFoldable || !flat.checkCalls().empty()) {
+        std::cerr << "Error: flat AST folding or call checking is inconsistent" << std::endl;
+        return 1;
+    }
+    
+    auto row = [nodes](const char* name, double heap, double arena, double flatTime) {
+        std::printf("%-10s heap %7.2f ns/node   arena %7.2f ns/node   flat %7.2f ns/node   (flat %.1fx vs heap)\n",
+                    name, heap / nodes, arena / nodes, flatTime / nodes, heap / flatTime);
+    };
+    row("checksum", treeHeap, treeArena, flatScan);
+    row("constant", constHeap, constArena, constFlat);
+    std::cout << "\nfoldable subexpressions: " << flatFoldable << "\n";
+    return 0;
+}
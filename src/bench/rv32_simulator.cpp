@@ -0,0 +1,354 @@
+#include "bench/rv32_simulator.hpp"
+#include "codegen/machine.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// main 返回到这里时结束执行
+static const int32_t EXIT_ADDRESS = -1;
+
+// 被调用者保存的寄存器（与 CallFrame::saved 的顺序一致），以及调用前后可能被改写的寄存器
+static const int CALLEE_SAVED[12] = {REG_FP, REG_S1, REG_S2, REG_S3, REG_S4, REG_S5,
+                                     REG_S6, REG_S7, REG_S8, REG_S9, REG_S10, REG_S11};
+static const int TEMPORARIES[7] = {REG_T0, REG_T1, REG_T2, REG_T3, REG_T4, REG_T5, REG_T6};
+static const int RETURN_CLOBBERED[14] = {REG_T0, REG_T1, REG_T2, REG_T3, REG_T4, REG_T5, REG_T6,
+                                         REG_A1, REG_A2, REG_A3, REG_A4, REG_A5, REG_A6, REG_A7};
+
+// ABI 名字（与 regName 相同，另外接受 s0）或 x0-x31
+static int registerNumber(const std::string& name) {
+    if (name == "s0") return REG_FP;
+    for (int i = 0; i < FIRST_VIRTUAL_REG; ++i) {
+        if (name == regName(i)) return i;
+    }
+    if (name.size() >= 2 && name[0] == 'x') {
+        char* end;
+        long number = std::strtol(name.c_str() + 1, &end, 10);
+        if (*end == '\0' && number >= 0 && number < 32) return (int)number;
+    }
+    return -1;
+}
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+static bool parseImmediate(const std::string& text, int32_t& value) {
+    if (text.empty()) return false;
+    char* end;
+    long long parsed = std::strtoll(text.c_str(), &end, 0);
+    if (*end != '\0' || parsed < INT32_MIN || parsed > UINT32_MAX) return false;
+    value = (int32_t)parsed;
+    return true;
+}
+
+bool RV32Simulator::load(const std::string& assembly, std::string& error) {
+    // 操作数格式
+    enum Format { R3, R2, RI, IMM, LOAD, STORE, B1, B2, JUMP, NONE };
+    struct Mnemonic {
+        const char* name;
+        Opcode op;
+        Format format;
+    };
+    static const Mnemonic MNEMONICS[] = {
+        {"li", LI, IMM}, {"lui", LUI, IMM}, {"mv", MV, R2}, {"neg", NEG, R2}, {"not", NOT, R2},
+        {"seqz", SEQZ, R2}, {"snez", SNEZ, R2},
+        {"add", ADD, R3}, {"sub", SUB, R3}, {"mul", MUL, R3}, {"mulh", MULH, R3}, {"mulhu", MULHU, R3},
+        {"div", DIV, R3}, {"divu", DIVU, R3}, {"rem", REM, R3}, {"remu", REMU, R3},
+        {"slt", SLT, R3}, {"sltu", SLTU, R3}, {"sll", SLL, R3}, {"srl", SRL, R3}, {"sra", SRA, R3},
+        {"xor", XOR, R3}, {"and", AND, R3}, {"or", OR, R3},
+        {"addi", ADDI, RI}, {"slti", SLTI, RI}, {"sltiu", SLTIU, RI}, {"xori", XORI, RI},
+        {"andi", ANDI, RI}, {"ori", ORI, RI}, {"slli", SLLI, RI}, {"srli", SRLI, RI}, {"srai", SRAI, RI},
+        {"lw", LW, LOAD}, {"sw", SW, STORE},
+        {"beqz", BEQZ, B1}, {"bnez", BNEZ, B1}, {"blez", BLEZ, B1}, {"bgez", BGEZ, B1},
+        {"bltz", BLTZ, B1}, {"bgtz", BGTZ, B1},
+        {"beq", BEQ, B2}, {"bne", BNE, B2}, {"blt", BLT, B2}, {"bge", BGE, B2},
+        {"bgt", BGT, B2}, {"ble", BLE, B2}, {"bltu", BLTU, B2}, {"bgeu", BGEU, B2},
+        {"j", J, JUMP}, {"call", CALL, JUMP}, {"tail", TAIL, JUMP}, {"ret", RET, NONE}, {"nop", NOP, NONE},
+    };
+    
+    program.clear();
+    labels.clear();
+    std::vector<std::string> targets;  // 与 program 一一对应的跳转目标名
+    std::istringstream in(assembly);
+    std::string text;
+    int line = 0;
+    auto fail = [&](const std::string& message) {
+        error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    };
+    
+    while (std::getline(in, text)) {
+        line++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.resize(comment);
+        text = trim(text);
+        // 行首的标签，可以有多个
+        for (size_t colon = text.find(':'); colon != std::string::npos && colon < text.find_first_of(" \t,");
+             colon = text.find(':')) {
+            labels[text.substr(0, colon)] = (int)program.size();
+            text = trim(text.substr(colon + 1));
+        }
+        if (text.empty() || text[0] == '.') continue;
+        
+        size_t space = text.find_first_of(" \t");
+        std::string name = text.substr(0, space);
+        std::vector<std::string> operands;
+        if (space != std::string::npos) {
+            std::istringstream fields(text.substr(space));
+            std::string field;
+            while (std::getline(fields, field, ',')) operands.push_back(trim(field));
+        }
+        
+        const Mnemonic* mnemonic = nullptr;
+        for (const Mnemonic& candidate : MNEMONICS) {
+            if (name == candidate.name) mnemonic = &candidate;
+        }
+        if (!mnemonic) return fail("unsupported instruction '" + name + "'");
+        
+        static const size_t OPERAND_COUNTS[] = {3, 2, 3, 2, 2, 2, 2, 3, 1, 0};
+        if (operands.size() != OPERAND_COUNTS[mnemonic->format]) {
+            return fail("wrong number of operands for '" + name + "'");
+        }
+        Instruction instr{mnemonic->op, 0, 0, 0, 0, -1, line};
+        std::string target;
+        auto reg = [&](size_t index, int& field) {
+            field = registerNumber(operands[index]);
+            return field >= 0;
+        };
+        // off(base)
+        auto address = [&](size_t index) {
+            const std::string& operand = operands[index];
+            size_t open = operand.find('(');
+            if (open == std::string::npos || operand.back() != ')') return false;
+            instr.imm = 0;
+            if (open > 0 && !parseImmediate(operand.substr(0, open), instr.imm)) return false;
+            instr.rs1 = registerNumber(operand.substr(open + 1, operand.size() - open - 2));
+            return instr.rs1 >= 0 && instr.imm >= -2048 && instr.imm <= 2047;
+        };
+        bool ok = true;
+        switch (mnemonic->format) {
+            case R3: ok = reg(0, instr.rd) && reg(1, instr.rs1) && reg(2, instr.rs2); break;
+            case R2: ok = reg(0, instr.rd) && reg(1, instr.rs1); break;
+            case RI:
+                ok = reg(0, instr.rd) && reg(1, instr.rs1) && parseImmediate(operands[2], instr.imm);
+                if (instr.op == SLLI || instr.op == SRLI || instr.op == SRAI) {
+                    ok = ok && instr.imm >= 0 && instr.imm <= 31;
+                } else {
+                    ok = ok && instr.imm >= -2048 && instr.imm <= 2047;
+                }
+                break;
+            case IMM: ok = reg(0, instr.rd) && parseImmediate(operands[1], instr.imm); break;
+            case LOAD: ok = reg(0, instr.rd) && address(1); break;
+            case STORE: ok = reg(0, instr.rs2) && address(1); break;
+            case B1: ok = reg(0, instr.rs1); target = operands[1]; break;
+            case B2: ok = reg(0, instr.rs1) && reg(1, instr.rs2); target = operands[2]; break;
+            case JUMP: target = operands[0]; break;
+            case NONE: break;
+        }
+        if (!ok) return fail("invalid operands in '" + text + "'");
+        program.push_back(instr);
+        targets.push_back(target);
+    }
+    
+    for (size_t i = 0; i < program.size(); ++i) {
+        if (targets[i].empty()) continue;
+        auto it = labels.find(targets[i]);
+        if (it == labels.end()) {
+            line = program[i].line;
+            return fail("undefined label '" + targets[i] + "'");
+        }
+        program[i].target = it->second;
+    }
+    if (!labels.count("main")) {
+        error = "no main function";
+        return false;
+    }
+    return true;
+}
+
+void RV32Simulator::clobber(int32_t* x, const int* regs, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        noise = noise * 1103515245u + 12345u;
+        x[regs[i]] = (int32_t)noise;
+    }
+}
+
+// 指令下标处的函数名（不是 .L 开头的局部标签），找不到时给出下标
+std::string RV32Simulator::functionAt(int index) const {
+    for (const auto& label : labels) {
+        if (label.second == index && label.first.rfind(".L", 0) != 0) return label.first;
+    }
+    return "#" + std::to_string(index);
+}
+
+bool RV32Simulator::run(int32_t& result, std::string& error, uint64_t stepLimit) {
+    memory.assign(MEMORY_SIZE, 0);
+    counters = Stats();
+    noise = 0x2545f491u;
+    int32_t x[32] = {0};
+    // 除 sp、ra 外的寄存器一开始都是随机值，s0-s11 的随机值在 main 返回时核对
+    for (int reg = 1; reg < 32; ++reg) {
+        clobber(x, &reg, 1);
+    }
+    x[REG_ZERO] = 0;
+    x[REG_RA] = EXIT_ADDRESS;
+    x[REG_SP] = (int32_t)(MEMORY_SIZE - 16);
+    int pc = labels["main"];
+    std::vector<CallFrame> frames;
+    auto pushFrame = [&](int returnPc, int callee, int line) {
+        CallFrame frame{returnPc, callee, line, x[REG_SP], {}};
+        for (int i = 0; i < 12; ++i) frame.saved[i] = x[CALLEE_SAVED[i]];
+        frames.push_back(frame);
+    };
+    pushFrame(EXIT_ADDRESS, pc, 0);
+    
+    auto fail = [&](const Instruction& instr, const std::string& message) {
+        error = "line " + std::to_string(instr.line) + ": " + message;
+        return false;
+    };
+    
+    while (true) {
+        if (pc < 0 || pc >= (int)program.size()) {
+            error = "jump outside the program";
+            return false;
+        }
+        if (++counters.instructions > stepLimit) {
+            error = "step limit of " + std::to_string(stepLimit) + " instructions exceeded";
+            return false;
+        }
+        const Instruction& instr = program[pc++];
+        int32_t a = x[instr.rs1], b = x[instr.rs2];
+        uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+        int32_t value = 0;
+        bool writes = true;
+        auto branch = [&](bool condition) {
+            writes = false;
+            counters.branches++;
+            if (condition) {
+                counters.takenBranches++;
+                pc = instr.target;
+            }
+        };
+        
+        switch (instr.op) {
+            case LI: value = instr.imm; break;
+            case LUI: value = (int32_t)((uint32_t)instr.imm << 12); break;
+            case MV: value = a; break;
+            case NEG: value = (int32_t)(0u - ua); break;
+            case NOT: value = ~a; break;
+            case SEQZ: value = a == 0; break;
+            case SNEZ: value = a != 0; break;
+            case ADD: value = (int32_t)(ua + ub); break;
+            case SUB: value = (int32_t)(ua - ub); break;
+            case MUL: value = (int32_t)(ua * ub); break;
+            case MULH: value = (int32_t)(((int64_t)a * (int64_t)b) >> 32); break;
+            case MULHU: value = (int32_t)(((uint64_t)ua * (uint64_t)ub) >> 32); break;
+            // 除零与溢出按 RISC-V 规定的结果，不产生异常
+            case DIV: value = b == 0 ? -1 : (a == INT32_MIN && b == -1) ? a : a / b; break;
+            case DIVU: value = b == 0 ? -1 : (int32_t)(ua / ub); break;
+            case REM: value = b == 0 ? a : (a == INT32_MIN && b == -1) ? 0 : a % b; break;
+            case REMU: value = b == 0 ? a : (int32_t)(ua % ub); break;
+            case SLT: value = a < b; break;
+            case SLTU: value = ua < ub; break;
+            case SLL: value = (int32_t)(ua << (ub & 31)); break;
+            case SRL: value = (int32_t)(ua >> (ub & 31)); break;
+            case SRA: value = a >> (ub & 31); break;
+            case XOR: value = a ^ b; break;
+            case AND: value = a & b; break;
+            case OR: value = a | b; break;
+            case ADDI: value = (int32_t)(ua + (uint32_t)instr.imm); break;
+            case SLTI: value = a < instr.imm; break;
+            case SLTIU: value = ua < (uint32_t)instr.imm; break;
+            case XORI: value = a ^ instr.imm; break;
+            case ANDI: value = a & instr.imm; break;
+            case ORI: value = a | instr.imm; break;
+            case SLLI: value = (int32_t)(ua << instr.imm); break;
+            case SRLI: value = (int32_t)(ua >> instr.imm); break;
+            case SRAI: value = a >> instr.imm; break;
+            case LW:
+            case SW: {
+                uint32_t address = ua + (uint32_t)instr.imm;
+                if (address % 4 != 0 || address < 4096 || address > MEMORY_SIZE - 4) {
+                    return fail(instr, "invalid memory access at address " + std::to_string(address));
+                }
+                if (instr.op == LW) {
+                    std::memcpy(&value, &memory[address], 4);
+                    counters.loads++;
+                } else {
+                    std::memcpy(&memory[address], &b, 4);
+                    counters.stores++;
+                    writes = false;
+                }
+                break;
+            }
+            case BEQZ: branch(a == 0); break;
+            case BNEZ: branch(a != 0); break;
+            case BLEZ: branch(a <= 0); break;
+            case BGEZ: branch(a >= 0); break;
+            case BLTZ: branch(a < 0); break;
+            case BGTZ: branch(a > 0); break;
+            case BEQ: branch(a == b); break;
+            case BNE: branch(a != b); break;
+            case BLT: branch(a < b); break;
+            case BGE: branch(a >= b); break;
+            case BGT: branch(a > b); break;
+            case BLE: branch(a <= b); break;
+            case BLTU: branch(ua < ub); break;
+            case BGEU: branch(ua >= ub); break;
+            case J:
+                writes = false;
+                counters.jumps++;
+                pc = instr.target;
+                break;
+            case TAIL:
+                // 被调函数直接返回到当前函数的调用者，沿用当前的调用记录
+                writes = false;
+                counters.jumps++;
+                pc = instr.target;
+                clobber(x, TEMPORARIES, 7);
+                break;
+            case CALL:
+                counters.calls++;
+                x[REG_RA] = pc;
+                pushFrame(pc, instr.target, instr.line);
+                pc = instr.target;
+                clobber(x, TEMPORARIES, 7);
+                writes = false;
+                break;
+            case RET: {
+                const CallFrame& frame = frames.back();
+                std::string callee = functionAt(frame.callee);
+                std::string site = frame.callLine > 0 ? " (called at line " + std::to_string(frame.callLine) + ")" : "";
+                if (x[REG_RA] != frame.returnPc) {
+                    return fail(instr, callee + " returns to the wrong address: ra was not preserved" + site);
+                }
+                if (x[REG_SP] != frame.sp) {
+                    return fail(instr, callee + " returns with sp changed by " + std::to_string(x[REG_SP] - frame.sp) + site);
+                }
+                for (int i = 0; i < 12; ++i) {
+                    if (x[CALLEE_SAVED[i]] != frame.saved[i]) {
+                        return fail(instr, callee + " does not preserve callee-saved " +
+                                    (i == 0 ? std::string("s0") : regName(CALLEE_SAVED[i])) + site);
+                    }
+                }
+                frames.pop_back();
+                if (frame.returnPc == EXIT_ADDRESS) {
+                    result = x[REG_A0];
+                    return true;
+                }
+                pc = frame.returnPc;
+                clobber(x, RETURN_CLOBBERED, 14);
+                writes = false;
+                break;
+            }
+            case NOP: writes = false; break;
+        }
+        if (writes && instr.rd != 0) x[instr.rd] = value;
+        if ((uint32_t)x[REG_SP] < 4096 + 64 * 1024) {
+            return fail(instr, "stack overflow");
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 运行 toyc 输出的 RV32IM 解释器：直接解析汇编文本（toyc 生成的指令、伪指令和标签，外加少量常见的
+// RV32IM 指令），从 main 开始执行到 main 返回，统计动态指令数、访存与分支。
+// 只有一块连续内存，栈从顶端向下增长；没有系统调用，程序的结果就是 main 返回的 a0。
+// 同时检查调用约定：call 和 tail 进入被调函数时 t0-t6 换成随机值，返回时 t0-t6、a1-a7 换成随机值，
+// 调用者依赖调用前后不变的临时寄存器会得到错误的结果；ret 时要求 ra 是调用时的返回地址，
+// sp 和 s0-s11 与调用时相同，否则报告违反调用约定的函数并停止执行
+class RV32Simulator {
+public:
+    struct Stats {
+        uint64_t instructions;
+        uint64_t loads;
+        uint64_t stores;
+        uint64_t branches;       // 条件分支
+        uint64_t takenBranches;
+        uint64_t jumps;          // j、tail
+        uint64_t calls;
+    };
+    
+    static const uint32_t MEMORY_SIZE = 8 * 1024 * 1024;
+    
+    RV32Simulator() : counters(), noise(0) {}
+    
+    // 解析汇编，失败时 error 给出行号和原因
+    bool load(const std::string& assembly, std::string& error);
+    // 从 main 执行到它返回，结果放在 result；执行超过 stepLimit 条指令、越界访存等情况返回 false
+    bool run(int32_t& result, std::string& error, uint64_t stepLimit = 500000000);
+    
+    const Stats& stats() const { return counters; }
+    
+private:
+    enum Opcode {
+        LI, LUI, MV, NEG, NOT, SEQZ, SNEZ,
+        ADD, SUB, MUL, MULH, MULHU, DIV, DIVU, REM, REMU, SLT, SLTU, SLL, SRL, SRA, XOR, AND, OR,
+        ADDI, SLTI, SLTIU, XORI, ANDI, ORI, SLLI, SRLI, SRAI,
+        LW, SW,
+        BEQZ, BNEZ, BLEZ, BGEZ, BLTZ, BGTZ, BEQ, BNE, BLT, BGE, BGT, BLE, BLTU, BGEU,
+        J, CALL, TAIL, RET, NOP
+    };
+    
+    struct Instruction {
+        Opcode op;
+        int rd;
+        int rs1;
+        int rs2;
+        int32_t imm;
+        int target;   // 跳转目标的指令下标
+        int line;     // 源汇编中的行号
+    };
+    
+    // 一次 call 记下的调用者状态，被调函数返回时核对
+    struct CallFrame {
+        int returnPc;
+        int callee;     // 被调函数入口的指令下标
+        int callLine;
+        int32_t sp;
+        int32_t saved[12];  // s0-s11
+    };
+    
+    std::vector<Instruction> program;
+    std::unordered_map<std::string, int> labels;
+    std::vector<uint8_t> memory;
+    Stats counters;
+    uint32_t noise;  // 随机值的线性同余发生器状态，每次运行从同一个种子开始
+    
+    void clobber(int32_t* x, const int* regs, size_t count);
+    std::string functionAt(int index) const;
+};
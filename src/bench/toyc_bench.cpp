@@ -0,0 +1,383 @@
+// 编译器吞吐量基准。按五个维度缩放生成 ToyC 程序：
+//   functions    函数个数
+//   depth        if/while 的嵌套深度
+//   width        每个表达式的项数
+//   identifiers  每个函数的局部变量个数（名字带函数编号，全程序互不相同）
+//   comments     每个函数之前的注释行数（单行注释与块注释交替）
+// 每组参数分别测量词法分析、语法分析（含词法）、语义分析、代码生成和 -opt 代码生成，
+// 词法和语法分析另用 Flex 生成的扫描器各测一次（lex-flex、parse-flex）作为对照，
+// 给出每秒行数、每秒字节数以及单次运行的堆分配次数与字节数。每项取多次运行中最快的一次。
+//
+// 用法: toyc_bench [--quick] [--json] [场景名...]
+//   --quick  缩小规模并缩短计时（CI 冒烟测试）
+//   --json   输出 JSON 数组而不是表格，便于跟踪回归
+//   场景名   只运行名字以给出的前缀开头的场景，如 width
+#include "ast/ast.hpp"
+#include "ast/arena.hpp"
+#include "ast/parse.hpp"
+#include "common/output_sink.hpp"
+#include "common/time_report.hpp"
+#include "common/types.hpp"
+#include "semantic/analyzer.hpp"
+#include "codegen/riscv.hpp"
+#include "ir/lowering.hpp"
+#include "opt/passes.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Shape {
+    std::string name;
+    int functions;
+    int depth;
+    int width;
+    int identifiers;
+    int comments;
+};
+
+static uint32_t randomState = 12345;
+
+static uint32_t nextRandom() {
+    randomState = randomState * 1103515245u + 12345u;
+    return randomState >> 16;
+}
+
+class ProgramGenerator {
+public:
+    explicit ProgramGenerator(const Shape& shape) : shape(shape), function(0) {}
+    
+    std::string generate() {
+        randomState = 12345;
+        for (function = 0; function < shape.functions; ++function) {
+            generateFunction();
+        }
+        out << "int main() {\n    return f" << shape.functions - 1 << "(1, 2);\n}\n";
+        return out.str();
+    }
+    
+private:
+    const Shape& shape;
+    std::ostringstream out;
+    int function;
+    
+    void local(int index) { out << "x" << function << "_" << index; }
+    
+    void indent(int level) {
+        for (int i = 0; i <= level; ++i) out << "    ";
+    }
+    
+    void term() {
+        unsigned choice = nextRandom() % 8;
+        if (choice < 5) {
+            local((int)(nextRandom() % shape.identifiers));
+        } else if (choice == 5 && function > 0) {
+            out << "f" << function - 1 << "(";
+            local(0);
+            out << ", " << nextRandom() % 10 << ")";
+        } else {
+            out << nextRandom() % 100;
+        }
+    }
+    
+    // width 项的表达式，每四项加一层括号
+    void expression() {
+        static const char* ops[] = {" + ", " - ", " * ", " + "};
+        int open = 0;
+        for (int i = 0; i < shape.width; ++i) {
+            if (i) out << ops[nextRandom() % 4];
+            if (i % 4 == 0 && i + 1 < shape.width) {
+                out << "(";
+                open++;
+            }
+            term();
+            if (i % 4 == 3 && open > 0) {
+                out << ")";
+                open--;
+            }
+        }
+        for (; open > 0; --open) out << ")";
+    }
+    
+    void assignment(int level) {
+        indent(level);
+        local((int)(nextRandom() % shape.identifiers));
+        out << " = ";
+        expression();
+        out << ";\n";
+    }
+    
+    // 只有一条分支继续向下嵌套，语句数与深度成正比
+    void nest(int level) {
+        if (level == shape.depth) {
+            assignment(level);
+            return;
+        }
+        indent(level);
+        if (level % 2 == 0) {
+            out << "if (";
+            local(level % shape.identifiers);
+            out << " < " << nextRandom() % 100 << ") {\n";
+            indent(level + 1);
+            out << "int n" << level << " = ";
+            local(0);
+            out << ";\n";
+            nest(level + 1);
+            indent(level);
+            out << "} else {\n";
+            assignment(level + 1);
+            indent(level);
+            out << "}\n";
+        } else {
+            out << "while (";
+            local(level % shape.identifiers);
+            out << " > " << nextRandom() % 100 << ") {\n";
+            nest(level + 1);
+            indent(level + 1);
+            local(level % shape.identifiers);
+            out << " = ";
+            local(level % shape.identifiers);
+            out << " - 1;\n";
+            indent(level);
+            out << "}\n";
+        }
+    }
+    
+    void generateFunction() {
+        for (int i = 0; i < shape.comments; ++i) {
+            if (i % 2 == 0) {
+                out << "// f" << function << ": line comment " << i << " describing the function below\n";
+            } else {
+                out << "/* f" << function << ": block comment " << i << "\n * that spans two lines */\n";
+            }
+        }
+        out << "int f" << function << "(int a, int b) {\n";
+        for (int i = 0; i < shape.identifiers; ++i) {
+            indent(0);
+            out << "int ";
+            local(i);
+            out << " = ";
+            if (i == 0) {
+                out << "a + b";
+            } else {
+                local(i - 1);
+                out << " + " << i;
+            }
+            out << ";\n";
+        }
+        for (int i = 0; i < 4; ++i) {
+            nest(0);
+        }
+        indent(0);
+        out << "return ";
+        local(shape.identifiers - 1);
+        out << ";\n}\n";
+    }
+};
+
+// 输入的原地扫描副本：内容之后两个 '\0'
+static std::vector<char> scanBuffer(const std::string& source) {
+    std::vector<char> buffer(source.begin(), source.end());
+    buffer.push_back('\0');
+    buffer.push_back('\0');
+    return buffer;
+}
+
+struct Measurement {
+    double seconds;        // 最快一次
+    uint64_t allocations;  // 单次运行的堆分配
+    uint64_t allocatedBytes;
+};
+
+// 重复执行 setup + body 至少 3 次且总计时不少于 minSeconds，只计 body 的时间
+template <typename Setup, typename Body>
+static Measurement measure(double minSeconds, Setup setup, Body body) {
+    Measurement result{1e30, 0, 0};
+    double total = 0;
+    for (int run = 0; run < 3 || total < minSeconds; ++run) {
+        setup();
+        uint64_t allocations = heapAllocations();
+        uint64_t allocatedBytes = heapAllocatedBytes();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0) {
+            result.allocations = heapAllocations() - allocations;
+            result.allocatedBytes = heapAllocatedBytes() - allocatedBytes;
+        }
+        result.seconds = std::min(result.seconds, seconds);
+        total += seconds;
+    }
+    return result;
+}
+
+static std::unordered_map<std::string, FunctionInfo> functionTable(CompilationUnit& unit) {
+    std::unordered_map<std::string, FunctionInfo> table;
+    for (const auto& func : unit.functions) {
+        std::vector<Expression::Type> paramTypes;
+        for (const auto& param : func->parameters) {
+            paramTypes.push_back(param.type);
+        }
+        table[func->name.str()] = FunctionInfo(func->name.str(), func->returnType, paramTypes, true);
+    }
+    return table;
+}
+
+// AST -> IR ->（可选的优化）-> 汇编，返回汇编的字节数
+static size_t generateCode(CompilationUnit& unit, const std::unordered_map<std::string, FunctionInfo>& table, bool optimize) {
+    IRBuilder builder;
+    std::unique_ptr<IRModule> module = builder.build(unit);
+    RISCVCodeGenerator generator;
+    if (optimize) {
+        PassManager passManager;
+        passManager.addDefaultPipeline();
+        passManager.run(*module);
+        generator.enableOptimizations();
+    }
+    OutputSink sink;
+    generator.generate(*module, table, sink);
+    return sink.str().size();
+}
+
+struct Row {
+    std::string scenario;
+    const char* phase;
+    size_t lines;
+    size_t bytes;
+    Measurement measurement;
+};
+
+static void printTable(const std::vector<Row>& rows) {
+    std::printf("%-16s %-12s %9s %13s %10s %12s %14s\n",
+                "scenario", "phase", "lines", "lines/s", "MB/s", "allocs", "alloc bytes");
+    for (const Row& row : rows) {
+        const Measurement& m = row.measurement;
+        std::printf("%-16s %-12s %9zu %13.0f %10.2f %12llu %14llu\n", row.scenario.c_str(), row.phase, row.lines,
+                    row.lines / m.seconds, row.bytes / m.seconds / 1e6,
+                    (unsigned long long)m.allocations, (unsigned long long)m.allocatedBytes);
+    }
+}
+
+static void printJSON(const std::vector<Row>& rows) {
+    std::printf("[\n");
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Row& row = rows[i];
+        const Measurement& m = row.measurement;
+        std::printf("  {\"scenario\": \"%s\", \"phase\": \"%s\", \"lines\": %zu, \"bytes\": %zu, \"seconds\": %.9f, "
+                    "\"lines_per_second\": %.0f, \"allocations\": %llu, \"allocated_bytes\": %llu}%s\n",
+                    row.scenario.c_str(), row.phase, row.lines, row.bytes, m.seconds, row.lines / m.seconds,
+                    (unsigned long long)m.allocations, (unsigned long long)m.allocatedBytes,
+                    i + 1 < rows.size() ? "," : "");
+    }
+    std::printf("]\n");
+}
+
+int main(int argc, char* argv[]) {
+    bool quick = false, json = false;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--json] [scenario...]" << std::endl;
+            return 1;
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+    
+    // 基准形状 200 个函数、深度 3、宽度 8、8 个局部变量，每组场景只改变其中一个维度
+    int scale = quick ? 10 : 1;
+    std::vector<Shape> shapes;
+    for (int functions : {100, 1000, 4000}) {
+        shapes.push_back(Shape{"functions-" + std::to_string(functions / scale), functions / scale, 3, 8, 8, 0});
+    }
+    for (int depth : {4, 16, 64}) {
+        shapes.push_back(Shape{"depth-" + std::to_string(depth), 200 / scale, depth, 8, 8, 0});
+    }
+    for (int width : {4, 64, 512}) {
+        shapes.push_back(Shape{"width-" + std::to_string(width), 200 / scale, 3, width, 8, 0});
+    }
+    for (int identifiers : {4, 64, 512}) {
+        shapes.push_back(Shape{"identifiers-" + std::to_string(identifiers), 200 / scale, 3, 8, identifiers, 0});
+    }
+    for (int comments : {4, 32}) {
+        shapes.push_back(Shape{"comments-" + std::to_string(comments), 200 / scale, 3, 8, 8, comments});
+    }
+    double minSeconds = quick ? 0.02 : 0.3;
+    
+    enableAllocationCounting();
+    std::vector<Row> rows;
+    for (const Shape& shape : shapes) {
+        if (!filters.empty() && std::none_of(filters.begin(), filters.end(),
+                [&shape](const std::string& prefix) { return shape.name.rfind(prefix, 0) == 0; })) {
+            continue;
+        }
+        
+        std::string source = ProgramGenerator(shape).generate();
+        size_t lines = (size_t)std::count(source.begin(), source.end(), '\n');
+        
+        // 生成的程序必须能通过语法和语义分析，否则测到的只是出错路径
+        std::vector<char> buffer = scanBuffer(source);
+        std::unique_ptr<CompilationUnit> unit;
+        {
+            ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+            unit = parseBuffer(buffer.data(), buffer.size(), std::cerr);
+        }
+        SemanticAnalyzer check;
+        if (!unit || !check.analyze(*unit)) {
+            std::cerr << "Error: generated program '" << shape.name << "' does not compile" << std::endl;
+            for (const auto& error : check.getErrors()) std::cerr << "  " << error << std::endl;
+            return 1;
+        }
+        std::unordered_map<std::string, FunctionInfo> table = functionTable(*unit);
+        
+        auto add = [&](const char* phase, const Measurement& m) {
+            rows.push_back(Row{shape.name, phase, lines, source.size(), m});
+        };
+        auto refill = [&] { buffer = scanBuffer(source); };
+        
+        size_t tokens = 0;
+        size_t flexTokens = 0;
+        add("lex", measure(minSeconds, refill, [&] { tokens = lexBuffer(buffer.data(), buffer.size(), std::cerr); }));
+        add("lex-flex", measure(minSeconds, refill, [&] {
+            flexTokens = lexBuffer(buffer.data(), buffer.size(), std::cerr, FLEX_LEXER);
+        }));
+        std::unique_ptr<CompilationUnit> parsed, flexParsed;
+        add("parse", measure(minSeconds, [&] { refill(); parsed.reset(); }, [&] {
+            ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+            parsed = parseBuffer(buffer.data(), buffer.size(), std::cerr);
+        }));
+        add("parse-flex", measure(minSeconds, [&] { refill(); flexParsed.reset(); }, [&] {
+            ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+            flexParsed = parseBuffer(buffer.data(), buffer.size(), std::cerr, nullptr, nullptr, FLEX_LEXER);
+        }));
+        bool analyzed = true;
+        add("analyze", measure(minSeconds, [] {}, [&] {
+            SemanticAnalyzer analyzer;
+            analyzed = analyzer.analyze(*unit) && analyzed;
+        }));
+        size_t assembly = 0;
+        add("codegen", measure(minSeconds, [] {}, [&] { assembly = generateCode(*unit, table, false); }));
+        add("codegen-opt", measure(minSeconds, [] {}, [&] { assembly = generateCode(*unit, table, true); }));
+        if (tokens == 0 || tokens != flexTokens || !parsed || !flexParsed || !analyzed || assembly == 0) {
+            std::cerr << "Error: benchmark run for '" << shape.name << "' failed" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (json) {
+        printJSON(rows);
+    } else {
+        printTable(rows);
+    }
+    return 0;
+}
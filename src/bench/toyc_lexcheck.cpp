@@ -0,0 +1,86 @@
+// 分别用手写扫描器（FastLexer）和 Flex 生成的扫描器扫描源文件，比较两者的记号流（记号、取值、行号、偏移）
+// 和诊断信息，不同时给出第一处差异并以 1 退出。lexer_tests.sh 用它检查 FastLexer。
+//
+// 用法: toyc_lexcheck [--dump] file...
+//   --dump  另外把 FastLexer 的记号流写到 stdout，每个记号一行 "行号 偏移 记号编号 文本 [取值]"
+#include "ast/parse.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TokenStream {
+    std::string tokens;
+    std::string diagnostics;
+};
+
+static TokenStream scan(const std::string& source, LexerKind lexer) {
+    std::vector<char> buffer(source.begin(), source.end());
+    buffer.push_back('\0');
+    buffer.push_back('\0');
+    std::ostringstream tokens, diagnostics;
+    dumpTokens(buffer.data(), buffer.size(), tokens, diagnostics, lexer);
+    return TokenStream{tokens.str(), diagnostics.str()};
+}
+
+// 逐行比较，报告第一处不同的行
+static bool sameLines(const std::string& path, const char* what, const std::string& fast, const std::string& flex) {
+    if (fast == flex) return true;
+    std::istringstream a(fast), b(flex);
+    std::string lineA, lineB;
+    for (int line = 1;; ++line) {
+        bool moreA = (bool)std::getline(a, lineA);
+        bool moreB = (bool)std::getline(b, lineB);
+        if (!moreA) lineA = "<end>";
+        if (!moreB) lineB = "<end>";
+        if (lineA != lineB || !moreA || !moreB) {
+            std::cerr << path << ": " << what << " differ at line " << line << std::endl
+                      << "  fast: " << lineA << std::endl
+                      << "  flex: " << lineB << std::endl;
+            return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool dump = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dump") {
+            dump = true;
+        } else if (arg[0] == '-') {
+            paths.clear();
+            break;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--dump] file..." << std::endl;
+        return 1;
+    }
+    
+    int status = 0;
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: cannot open '" << path << "'" << std::endl;
+            status = 1;
+            continue;
+        }
+        std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        TokenStream fast = scan(source, FAST_LEXER);
+        TokenStream flex = scan(source, FLEX_LEXER);
+        if (!sameLines(path, "tokens", fast.tokens, flex.tokens) ||
+            !sameLines(path, "diagnostics", fast.diagnostics, flex.diagnostics)) {
+            status = 1;
+        }
+        if (dump) {
+            std::cout << fast.tokens << fast.diagnostics;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,143 @@
+// 生成代码的性能：把每个程序分别按默认选项和 -opt 编译，在内置的 RV32IM 解释器上运行，
+// 比较动态指令数、访存和分支次数。两种编译结果的返回值必须相同，否则视为失败。
+//
+// 用法: toyc_perf [--json] [-inline-threshold=N] program.tc...
+#include "ast/arena.hpp"
+#include "ast/parse.hpp"
+#include "bench/rv32_simulator.hpp"
+#include "common/output_sink.hpp"
+#include "common/source_file.hpp"
+#include "driver/compiler.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Run {
+    bool ok;
+    int32_t result;
+    RV32Simulator::Stats stats;
+    std::string error;
+};
+
+// 编译并运行一次；每次都重新分析源文件，因为编译会改写 AST（常量折叠等）
+static Run compileAndRun(const std::string& path, const CompileOptions& options) {
+    Run run{false, 0, RV32Simulator::Stats(), ""};
+    std::string error;
+    std::unique_ptr<SourceFile> source = SourceFile::open(path, error);
+    if (!source) {
+        run.error = error;
+        return run;
+    }
+    std::ostringstream log;
+    std::unique_ptr<CompilationUnit> unit;
+    {
+        ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+        unit = parseBuffer(source->buffer(), source->bufferSize(), log);
+    }
+    OutputSink assembly;
+    if (!unit || !compileUnit(*unit, options, assembly, log)) {
+        run.error = "compilation failed: " + log.str();
+        return run;
+    }
+    
+    RV32Simulator simulator;
+    if (!simulator.load(assembly.str(), run.error) || !simulator.run(run.result, run.error)) {
+        return run;
+    }
+    run.stats = simulator.stats();
+    run.ok = true;
+    return run;
+}
+
+static double ratio(uint64_t optimized, uint64_t baseline) {
+    return baseline == 0 ? 1.0 : (double)optimized / (double)baseline;
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    CompileOptions baseline;
+    std::vector<std::string> programs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg.rfind("-inline-threshold=", 0) == 0) {
+            baseline.inlineThreshold = std::atoi(arg.c_str() + 18);
+        } else if (arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [--json] [-inline-threshold=N] program.tc..." << std::endl;
+            return 1;
+        } else {
+            programs.push_back(arg);
+        }
+    }
+    if (programs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--json] [-inline-threshold=N] program.tc..." << std::endl;
+        return 1;
+    }
+    CompileOptions optimized = baseline;
+    optimized.optimize = true;
+    
+    if (json) {
+        std::printf("[\n");
+    } else {
+        std::printf("%-20s %8s %12s %12s %7s %10s %10s %10s %10s %10s %10s\n", "program", "result",
+                    "instrs", "instrs -opt", "ratio", "loads", "-opt", "stores", "-opt", "branches", "-opt");
+    }
+    int failures = 0;
+    double logRatioSum = 0;
+    int measured = 0;
+    for (size_t i = 0; i < programs.size(); ++i) {
+        const std::string& path = programs[i];
+        Run base = compileAndRun(path, baseline);
+        Run opt = compileAndRun(path, optimized);
+        std::string problem;
+        if (!base.ok) {
+            problem = "default: " + base.error;
+        } else if (!opt.ok) {
+            problem = "-opt: " + opt.error;
+        } else if (base.result != opt.result) {
+            problem = "result differs: " + std::to_string(base.result) + " vs " + std::to_string(opt.result) + " with -opt";
+        }
+        if (!problem.empty()) {
+            failures++;
+            std::cerr << path << ": " << problem << std::endl;
+        } else {
+            logRatioSum += std::log(ratio(opt.stats.instructions, base.stats.instructions));
+            measured++;
+        }
+        
+        const RV32Simulator::Stats& b = base.stats;
+        const RV32Simulator::Stats& o = opt.stats;
+        if (json) {
+            std::printf("  {\"program\": \"%s\", \"ok\": %s, \"result\": %d, "
+                        "\"default\": {\"instructions\": %llu, \"loads\": %llu, \"stores\": %llu, \"branches\": %llu, \"taken_branches\": %llu, \"calls\": %llu}, "
+                        "\"opt\": {\"instructions\": %llu, \"loads\": %llu, \"stores\": %llu, \"branches\": %llu, \"taken_branches\": %llu, \"calls\": %llu}}%s\n",
+                        path.c_str(), problem.empty() ? "true" : "false", opt.result,
+                        (unsigned long long)b.instructions, (unsigned long long)b.loads, (unsigned long long)b.stores,
+                        (unsigned long long)b.branches, (unsigned long long)b.takenBranches, (unsigned long long)b.calls,
+                        (unsigned long long)o.instructions, (unsigned long long)o.loads, (unsigned long long)o.stores,
+                        (unsigned long long)o.branches, (unsigned long long)o.takenBranches, (unsigned long long)o.calls,
+                        i + 1 < programs.size() ? "," : "");
+        } else if (problem.empty()) {
+            std::string name = path.substr(path.find_last_of('/') + 1);
+            std::printf("%-20s %8d %12llu %12llu %7.3f %10llu %10llu %10llu %10llu %10llu %10llu\n", name.c_str(), opt.result,
+                        (unsigned long long)b.instructions, (unsigned long long)o.instructions,
+                        ratio(o.instructions, b.instructions),
+                        (unsigned long long)b.loads, (unsigned long long)o.loads,
+                        (unsigned long long)b.stores, (unsigned long long)o.stores,
+                        (unsigned long long)b.branches, (unsigned long long)o.branches);
+        }
+    }
+    if (json) {
+        std::printf("]\n");
+    } else if (measured > 0) {
+        std::printf("\ngeometric mean instruction ratio (-opt / default): %.3f over %d programs\n",
+                    std::exp(logRatioSum / measured), measured);
+    }
+    return failures == 0 ? 0 : 1;
+}
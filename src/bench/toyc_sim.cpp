@@ -0,0 +1,54 @@
+// 在内置的 RV32IM 解释器上运行一个 toyc 生成的汇编文件（不给出文件时读 stdin），
+// 把 main 的返回值写到 stdout；违反调用约定、越界访存等错误写到 stderr 并以 1 退出。run_tests.sh 用它检查生成代码。
+//
+// 用法: toyc_sim [--stats] [file.s]
+#include "bench/rv32_simulator.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    bool stats = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            stats = true;
+        } else if (arg[0] == '-' || !path.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [--stats] [file.s]" << std::endl;
+            return 1;
+        } else {
+            path = arg;
+        }
+    }
+    
+    std::string assembly;
+    if (path.empty()) {
+        assembly.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: cannot open '" << path << "'" << std::endl;
+            return 1;
+        }
+        assembly.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    
+    RV32Simulator simulator;
+    std::string error;
+    int32_t result;
+    if (!simulator.load(assembly, error) || !simulator.run(result, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    std::printf("%d\n", result);
+    if (stats) {
+        const RV32Simulator::Stats& s = simulator.stats();
+        std::fprintf(stderr, "instructions=%llu loads=%llu stores=%llu branches=%llu taken=%llu calls=%llu\n",
+                     (unsigned long long)s.instructions, (unsigned long long)s.loads, (unsigned long long)s.stores,
+                     (unsigned long long)s.branches, (unsigned long long)s.takenBranches, (unsigned long long)s.calls);
+    }
+    return 0;
+}
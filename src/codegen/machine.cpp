@@ -0,0 +1,179 @@
+#include "codegen/machine.hpp"
+
+static const char* const physicalRegNames[] = {
+    "zero", "ra", "sp", "gp", "tp",
+    "t0", "t1", "t2",
+    "fp", "s1",
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
+    "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
+    "t3", "t4", "t5", "t6"
+};
+
+bool isCallerSaved(int reg) {
+    return (reg >= REG_T0 && reg <= REG_T2) || (reg >= REG_A0 && reg <= REG_A7) ||
+           (reg >= REG_T3 && reg <= REG_T6) || reg == REG_RA;
+}
+
+bool isCalleeSaved(int reg) {
+    return reg == REG_S1 || (reg >= REG_S2 && reg <= REG_S11);
+}
+
+std::string regName(int reg) {
+    if (isVirtualReg(reg)) {
+        return "v" + std::to_string(reg - FIRST_VIRTUAL_REG);
+    }
+    if (reg >= 0 && reg < FIRST_VIRTUAL_REG) {
+        return physicalRegNames[reg];
+    }
+    return "?";
+}
+
+std::vector<int> MachineInstr::defs() const {
+    switch (op) {
+        case SW: case BEQZ: case BNEZ: case BEQ: case BNE: case BLT: case BGE:
+        case J: case RET: case TAIL: case LABEL:
+            return {};
+        case CALL: {
+            // 调用会破坏所有调用者保存寄存器，这里只列出显式的返回值 a0
+            return {REG_A0};
+        }
+        default:
+            return rd == NO_REG ? std::vector<int>() : std::vector<int>{rd};
+    }
+}
+
+std::vector<int> MachineInstr::uses() const {
+    switch (op) {
+        case LI: case LA: case J: case LABEL:
+            return {};
+        case CALL: case TAIL: {
+            std::vector<int> args;
+            for (int i = 0; i < imm; ++i) {
+                args.push_back(REG_A0 + i);
+            }
+            return args;
+        }
+        case RET:
+            return {REG_A0};
+        case SW:
+            return {rs2, rs1};
+        case ADD: case SUB: case MUL: case MULH: case DIV: case REM:
+        case SLT: case XOR: case AND: case OR:
+        case BEQ: case BNE: case BLT: case BGE:
+            return {rs1, rs2};
+        default:
+            return rs1 == NO_REG ? std::vector<int>() : std::vector<int>{rs1};
+    }
+}
+
+void printReg(OutputSink& out, int reg) {
+    if (isVirtualReg(reg)) {
+        out.put('v');
+        out.writeInt(reg - FIRST_VIRTUAL_REG);
+    } else if (reg >= 0 && reg < FIRST_VIRTUAL_REG) {
+        out.write(physicalRegNames[reg]);
+    } else {
+        out.put('?');
+    }
+}
+
+void MachineInstr::print(OutputSink& out) const {
+    auto regs = [&out](const char* name, int first, int second) {
+        out.write(name);
+        out.put(' ');
+        printReg(out, first);
+        out.write(", ", 2);
+        printReg(out, second);
+    };
+    auto r3 = [&](const char* name) {
+        regs(name, rd, rs1);
+        out.write(", ", 2);
+        printReg(out, rs2);
+    };
+    auto r2i = [&](const char* name) {
+        regs(name, rd, rs1);
+        out.write(", ", 2);
+        out.writeInt(imm);
+    };
+    auto r1l = [&](const char* name, int reg) {
+        out.write(name);
+        out.put(' ');
+        printReg(out, reg);
+        out.write(", ", 2);
+        out.write(label);
+    };
+    auto r2l = [&](const char* name) {
+        regs(name, rs1, rs2);
+        out.write(", ", 2);
+        out.write(label);
+    };
+    auto mem = [&](const char* name, int reg) {
+        out.write(name);
+        out.put(' ');
+        printReg(out, reg);
+        out.write(", ", 2);
+        out.writeInt(imm);
+        out.put('(');
+        printReg(out, rs1);
+        out.put(')');
+    };
+    auto jump = [&](const char* name) {
+        out.write(name);
+        out.put(' ');
+        out.write(label);
+    };
+    
+    switch (op) {
+        case LI:
+            out.write("li ");
+            printReg(out, rd);
+            out.write(", ", 2);
+            out.writeInt(imm);
+            break;
+        case LA: r1l("la", rd); break;
+        case MV: regs("mv", rd, rs1); break;
+        case NEG: regs("neg", rd, rs1); break;
+        case SEQZ: regs("seqz", rd, rs1); break;
+        case SNEZ: regs("snez", rd, rs1); break;
+        case ADD: r3("add"); break;
+        case SUB: r3("sub"); break;
+        case MUL: r3("mul"); break;
+        case MULH: r3("mulh"); break;
+        case DIV: r3("div"); break;
+        case REM: r3("rem"); break;
+        case SLT: r3("slt"); break;
+        case XOR: r3("xor"); break;
+        case AND: r3("and"); break;
+        case OR: r3("or"); break;
+        case ADDI: r2i("addi"); break;
+        case SLTI: r2i("slti"); break;
+        case XORI: r2i("xori"); break;
+        case ANDI: r2i("andi"); break;
+        case ORI: r2i("ori"); break;
+        case SLLI: r2i("slli"); break;
+        case SRLI: r2i("srli"); break;
+        case SRAI: r2i("srai"); break;
+        case LW: mem("lw", rd); break;
+        case SW: mem("sw", rs2); break;
+        case BEQZ: r1l("beqz", rs1); break;
+        case BNEZ: r1l("bnez", rs1); break;
+        case BEQ: r2l("beq"); break;
+        case BNE: r2l("bne"); break;
+        case BLT: r2l("blt"); break;
+        case BGE: r2l("bge"); break;
+        case J: jump("j"); break;
+        case CALL: jump("call"); break;
+        case RET: out.write("ret", 3); break;
+        case TAIL: jump("tail"); break;
+        case LABEL:
+            out.write(label);
+            out.put(':');
+            break;
+    }
+}
+
+std::string MachineInstr::toString() const {
+    OutputSink out;
+    print(out);
+    return out.str();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "common/output_sink.hpp"
+#include <string>
+#include <vector>
+
+// 物理寄存器编号（与 RISC-V 的 x0-x31 一致）
+enum PhysicalRegister {
+    REG_ZERO = 0, REG_RA, REG_SP, REG_GP, REG_TP,
+    REG_T0, REG_T1, REG_T2,
+    REG_FP, REG_S1,
+    REG_A0, REG_A1, REG_A2, REG_A3, REG_A4, REG_A5, REG_A6, REG_A7,
+    REG_S2, REG_S3, REG_S4, REG_S5, REG_S6, REG_S7, REG_S8, REG_S9, REG_S10, REG_S11,
+    REG_T3, REG_T4, REG_T5, REG_T6
+};
+
+// 编号不小于 FIRST_VIRTUAL_REG 的寄存器是虚拟寄存器，由寄存器分配器映射到物理寄存器
+const int FIRST_VIRTUAL_REG = 32;
+const int NO_REG = -1;
+// RV32 调用约定：前 8 个参数经 a0-a7 传递，其余自左向右放在调用者栈顶 0(sp)、4(sp)...
+const int NUM_ARG_REGS = 8;
+
+inline bool isVirtualReg(int reg) { return reg >= FIRST_VIRTUAL_REG; }
+bool isCallerSaved(int reg);
+bool isCalleeSaved(int reg);
+std::string regName(int reg);
+void printReg(OutputSink& out, int reg);
+
+// 一条机器指令（RISC-V 汇编级别，操作数可以是虚拟寄存器）
+class MachineInstr {
+public:
+    enum Opcode {
+        LI, LA, MV, NEG, SEQZ, SNEZ,
+        ADD, SUB, MUL, MULH, DIV, REM, SLT, XOR, AND, OR,
+        ADDI, SLTI, XORI, ANDI, ORI, SLLI, SRLI, SRAI,
+        LW, SW,
+        BEQZ, BNEZ, BEQ, BNE, BLT, BGE, J,
+        CALL, RET, TAIL,  // TAIL：拆除栈帧后跳转到被调函数（尾调用）
+        LABEL
+    };
+    
+    Opcode op;
+    int rd;
+    int rs1;
+    int rs2;
+    int imm;            // 立即数 / 访存偏移；CALL、TAIL 时为寄存器传参的个数
+    std::string label;  // 跳转目标 / 标签名 / 被调函数名
+    
+    MachineInstr(Opcode o, int d = NO_REG, int s1 = NO_REG, int s2 = NO_REG, int i = 0, const std::string& l = "")
+        : op(o), rd(d), rs1(s1), rs2(s2), imm(i), label(l) {}
+    
+    // 该指令写入 / 读取的寄存器（含 CALL、TAIL、RET 隐含的 a0-a7）
+    std::vector<int> defs() const;
+    std::vector<int> uses() const;
+    
+    bool isBranch() const { return op == BEQZ || op == BNEZ || op == BEQ || op == BNE || op == BLT || op == BGE; }
+    bool isTerminator() const { return isBranch() || op == J || op == RET || op == TAIL; }
+    
+    // 打印为一行汇编（不含换行）
+    void print(OutputSink& out) const;
+    std::string toString() const;
+};
+
+// 一个函数的机器指令序列及栈帧信息
+class MachineFunction {
+public:
+    std::string name;
+    std::vector<MachineInstr> instructions;
+    int nextVirtualReg;
+    int localSize;                     // 局部变量占用的字节数（位于 ra/fp 之下）
+    int spillSlots;                    // 寄存器分配产生的溢出槽个数
+    std::vector<int> usedCalleeSaved;  // 需要在序言/尾声中保存的 s1-s11
+    int outgoingArgSize;               // 栈传参（第 9 个起）的传出参数区，位于栈帧底部
+    bool savesRA;                      // 为 false 时是叶函数（没有 call），不保存 ra
+    bool usesFP;                       // 为 false 时不设置 fp，函数体中相对 fp 的访存在生成序言时改为相对 sp
+    
+    explicit MachineFunction(const std::string& n = "")
+        : name(n), nextVirtualReg(FIRST_VIRTUAL_REG), localSize(0), spillSlots(0), outgoingArgSize(0),
+          savesRA(true), usesFP(true) {}
+    
+    int newVirtualReg() { return nextVirtualReg++; }
+    void append(const MachineInstr& instr) { instructions.push_back(instr); }
+    
+    // 栈帧顶部保存 ra、fp 的区域大小
+    int saveAreaSize() const { return 4 * ((int)savesRA + (int)usesFP); }
+    
+    // 溢出槽相对 fp（即进入函数时的 sp）的偏移（位于局部变量区之下）
+    int spillSlotOffset(int slot) const { return -saveAreaSize() - localSize - 4 * (slot + 1); }
+    
+    // 栈帧布局（自进入函数时的 sp 向下）：ra、fp（各自只在需要时保存）、局部变量、溢出槽、被调用者保存寄存器，
+    // sp 之上是传出参数区；总大小按 16 字节对齐，叶函数没有任何需要保存的内容时为 0
+    int frameSize() const {
+        int size = saveAreaSize() + localSize + 4 * spillSlots + 4 * (int)usedCalleeSaved.size() + outgoingArgSize;
+        return (size + 15) / 16 * 16;
+    }
+};
@@ -0,0 +1,215 @@
+#include "codegen/peephole.hpp"
+#include <cstdint>
+#include <unordered_map>
+
+static bool isAddImm(const MachineInstr& instr, int reg) {
+    return instr.op == MachineInstr::ADDI && instr.rd == reg && instr.rs1 == reg;
+}
+
+static bool isStackAdjust(const MachineInstr& instr, int delta) {
+    return isAddImm(instr, REG_SP) && instr.imm == delta;
+}
+
+void PeepholeOptimizer::run(MachineFunction& function) {
+    std::vector<MachineInstr> out;
+    out.reserve(function.instructions.size());
+    for (const auto& instr : function.instructions) {
+        out.push_back(instr);
+        while (simplifyTail(out)) {
+        }
+    }
+    foldMoves(out);
+    function.instructions = std::move(out);
+}
+
+static uint32_t regMask(const std::vector<int>& regs) {
+    uint32_t mask = 0;
+    for (int reg : regs) {
+        if (reg >= 0 && reg < FIRST_VIRTUAL_REG) mask |= 1u << reg;
+    }
+    return mask;
+}
+
+// 按标签和终结指令划分基本块，求各块出口处活跃的物理寄存器，再在块内自后向前确定每条 mv 之后活跃的寄存器。
+// 只折叠调用者保存的临时寄存器（t0-t6、a0-a7）：ra、sp、fp 和 s1-s11 在函数出口处隐含地活跃。
+// call 只列出显式的 a0 为结果、不把其余调用者保存寄存器算作被写，活跃性因此只会偏大，折叠仍然安全
+void PeepholeOptimizer::foldMoves(std::vector<MachineInstr>& code) {
+    struct Block {
+        size_t first, last;
+        std::vector<size_t> successors;
+        uint32_t liveIn, liveOut;
+    };
+    std::vector<Block> blocks;
+    std::unordered_map<std::string, size_t> labelBlock;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (i == 0 || code[i].op == MachineInstr::LABEL || code[i - 1].isTerminator()) {
+            blocks.push_back(Block{i, i, {}, 0, 0});
+        }
+        blocks.back().last = i;
+        if (code[i].op == MachineInstr::LABEL) labelBlock[code[i].label] = blocks.size() - 1;
+    }
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const MachineInstr& term = code[blocks[b].last];
+        if (term.op == MachineInstr::J || term.isBranch()) {
+            auto it = labelBlock.find(term.label);
+            if (it == labelBlock.end()) return;  // 跳到函数之外：不做折叠
+            blocks[b].successors.push_back(it->second);
+        }
+        if (term.op != MachineInstr::J && term.op != MachineInstr::RET && term.op != MachineInstr::TAIL &&
+            b + 1 < blocks.size()) {
+            blocks[b].successors.push_back(b + 1);
+        }
+    }
+    
+    auto transfer = [&](const MachineInstr& instr, uint32_t live) {
+        return (live & ~regMask(instr.defs())) | regMask(instr.uses());
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            Block& block = blocks[b];
+            uint32_t live = 0;
+            for (size_t succ : block.successors) live |= blocks[succ].liveIn;
+            block.liveOut = live;
+            for (size_t i = block.last + 1; i-- > block.first;) live = transfer(code[i], live);
+            if (live != block.liveIn) {
+                block.liveIn = live;
+                changed = true;
+            }
+        }
+    }
+    
+    std::vector<bool> removed(code.size(), false);
+    for (const Block& block : blocks) {
+        uint32_t live = block.liveOut;
+        for (size_t i = block.last + 1; i-- > block.first;) {
+            MachineInstr& move = code[i];
+            if (move.op == MachineInstr::MV && i > block.first && move.rd != move.rs1) {
+                MachineInstr& producer = code[i - 1];
+                int temp = move.rs1;
+                bool scratch = isCallerSaved(temp) && temp != REG_RA;
+                if (scratch && !(live & (1u << temp)) && producer.op != MachineInstr::CALL &&
+                    producer.op != MachineInstr::LABEL && producer.defs() == std::vector<int>{temp}) {
+                    // producer 改为直接写 x，它之前的活跃性与改写前相同
+                    producer.rd = move.rd;
+                    removed[i] = true;
+                    counts[FOLD_MOVE]++;
+                    live = transfer(producer, live);
+                    --i;
+                    continue;
+                }
+            }
+            live = transfer(move, live);
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (!removed[i]) code[kept++] = code[i];
+    }
+    code.erase(code.begin() + kept, code.end());
+}
+
+bool PeepholeOptimizer::simplifyTail(std::vector<MachineInstr>& out) {
+    size_t n = out.size();
+    const MachineInstr& last = out[n - 1];
+    
+    if ((last.op == MachineInstr::MV && last.rd == last.rs1) || (isAddImm(last, last.rd) && last.imm == 0)) {
+        out.pop_back();
+        counts[REDUNDANT_MOVE]++;
+        return true;
+    }
+    
+    // 标签之前（可越过其他标签）跳向它自己的 j / 条件分支都是多余的
+    if (last.op == MachineInstr::LABEL) {
+        size_t i = n - 1;
+        while (i > 0 && out[i - 1].op == MachineInstr::LABEL) --i;
+        if (i > 0) {
+            const MachineInstr& prev = out[i - 1];
+            for (size_t k = i; k < n; ++k) {
+                if ((prev.op == MachineInstr::J || prev.isBranch()) && prev.label == out[k].label) {
+                    counts[prev.op == MachineInstr::J ? JUMP_TO_NEXT : BRANCH_TO_NEXT]++;
+                    out.erase(out.begin() + (i - 1));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    
+    if (n < 2) return false;
+    MachineInstr& prev = out[n - 2];
+    
+    if (prev.op == MachineInstr::SW && last.op == MachineInstr::LW &&
+        prev.rs1 == last.rs1 && prev.imm == last.imm) {
+        int loaded = last.rd;
+        int stored = prev.rs2;
+        out.pop_back();
+        if (loaded != stored) {
+            out.push_back(MachineInstr(MachineInstr::MV, loaded, stored));
+        }
+        counts[STORE_LOAD]++;
+        return true;
+    }
+    
+    if (last.op == MachineInstr::ADDI && isAddImm(prev, last.rd) && isAddImm(last, last.rd)) {
+        int sum = prev.imm + last.imm;
+        if (sum >= -2048 && sum <= 2047) {
+            out.pop_back();
+            out.back().imm = sum;
+            counts[ADJUST_MERGE]++;
+            return true;
+        }
+    }
+    
+    // 压栈后立即出栈：栈顶以下的内存已无效，存储本身也可以删除
+    if (isStackAdjust(last, 4) && n >= 3) {
+        bool withMove = n >= 4 && out[n - 2].op == MachineInstr::MV;
+        size_t push = n - (withMove ? 4 : 3);
+        const MachineInstr& store = out[push + 1];
+        if (isStackAdjust(out[push], -4) && store.op == MachineInstr::SW && store.rs1 == REG_SP && store.imm == 0 &&
+            (!withMove || out[n - 2].rs1 == store.rs2)) {
+            std::vector<MachineInstr> kept;
+            if (withMove) kept.push_back(out[n - 2]);
+            out.erase(out.begin() + push, out.end());
+            out.insert(out.end(), kept.begin(), kept.end());
+            counts[PUSH_POP]++;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+int PeepholeOptimizer::totalHits() const {
+    int total = 0;
+    for (int count : counts) total += count;
+    return total;
+}
+
+void PeepholeOptimizer::merge(const PeepholeOptimizer& other) {
+    for (int i = 0; i < NUM_PATTERNS; ++i) counts[i] += other.counts[i];
+}
+
+const char* PeepholeOptimizer::patternName(Pattern pattern) {
+    switch (pattern) {
+        case STORE_LOAD: return "store-load";
+        case PUSH_POP: return "push-pop";
+        case ADJUST_MERGE: return "adjust-merge";
+        case JUMP_TO_NEXT: return "jump-to-next";
+        case BRANCH_TO_NEXT: return "branch-to-next";
+        case REDUNDANT_MOVE: return "redundant-move";
+        case FOLD_MOVE: return "fold-move";
+        case NUM_PATTERNS: break;
+    }
+    return "?";
+}
+
+std::string PeepholeOptimizer::report() const {
+    std::string text;
+    for (int i = 0; i < NUM_PATTERNS; ++i) {
+        if (i) text += ", ";
+        text += std::string(patternName((Pattern)i)) + " " + std::to_string(counts[i]);
+    }
+    return text;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "codegen/machine.hpp"
+#include <string>
+#include <vector>
+
+// 窥孔优化：在分配完寄存器、补好序言尾声的机器指令序列上做局部改写。
+// 每条指令追加到输出末尾后，反复尝试用末尾的几条指令匹配下列模式，
+// 因此一次改写暴露出来的新机会（如压栈/弹栈对）会被立即处理。
+// FOLD_MOVE 需要知道寄存器此后是否还会被读取，在上述改写之后按物理寄存器的活跃性另做一遍。
+class PeepholeOptimizer {
+public:
+    enum Pattern {
+        STORE_LOAD,      // sw x, o(b); lw y, o(b)         => sw x, o(b); mv y, x
+        PUSH_POP,        // addi sp,-4; sw x,0(sp); [mv y,x]; addi sp,4  => [mv y,x]
+        ADJUST_MERGE,    // addi r, r, a; addi r, r, b     => addi r, r, a+b
+        JUMP_TO_NEXT,    // j L; L:                        => L:
+        BRANCH_TO_NEXT,  // beqz/bnez x, L; L:             => L:
+        REDUNDANT_MOVE,  // mv r, r / addi r, r, 0         => （删除）
+        FOLD_MOVE,       // op t, ...; mv x, t（t 此后不再活跃） => op x, ...
+        NUM_PATTERNS
+    };
+    
+    PeepholeOptimizer() : counts() {}
+    
+    void run(MachineFunction& function);
+    
+    int hits(Pattern pattern) const { return counts[pattern]; }
+    int totalHits() const;
+    // 累加另一个优化器的统计（各函数分别生成时汇总）
+    void merge(const PeepholeOptimizer& other);
+    static const char* patternName(Pattern pattern);
+    // 形如 "store-load 3, push-pop 1, ..." 的统计
+    std::string report() const;
+    
+private:
+    int counts[NUM_PATTERNS];
+    
+    bool simplifyTail(std::vector<MachineInstr>& out);
+    void foldMoves(std::vector<MachineInstr>& code);
+};
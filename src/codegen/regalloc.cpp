@@ -0,0 +1,335 @@
+#include "codegen/regalloc.hpp"
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+// 不跨越调用的区间优先使用这些调用者保存寄存器（t5/t6 保留给溢出代码）
+const int callerSavedPool[] = {
+    REG_T0, REG_T1, REG_T2, REG_T3, REG_T4,
+    REG_A7, REG_A6, REG_A5, REG_A4, REG_A3, REG_A2, REG_A1, REG_A0
+};
+
+const int calleeSavedPool[] = {
+    REG_S1, REG_S2, REG_S3, REG_S4, REG_S5, REG_S6,
+    REG_S7, REG_S8, REG_S9, REG_S10, REG_S11
+};
+
+const int SPILL_SCRATCH_0 = REG_T5;
+const int SPILL_SCRATCH_1 = REG_T6;
+
+bool testBit(const std::vector<uint64_t>& bits, int index) {
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+void setBit(std::vector<uint64_t>& bits, int index) {
+    bits[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+template <typename F>
+void forEachBit(const std::vector<uint64_t>& bits, F f) {
+    for (size_t w = 0; w < bits.size(); ++w) {
+        uint64_t word = bits[w];
+        while (word) {
+            int bit = __builtin_ctzll(word);
+            f(int(w * 64 + bit));
+            word &= word - 1;
+        }
+    }
+}
+
+} // namespace
+
+void LinearScanAllocator::run() {
+    if (numVirtualRegs() == 0) {
+        return;
+    }
+    buildBlocks();
+    computeLiveness();
+    buildIntervals();
+    buildFixedRanges();
+    allocate();
+    rewrite();
+}
+
+void LinearScanAllocator::buildBlocks() {
+    blocks.clear();
+    const auto& instrs = mf.instructions;
+    std::unordered_map<std::string, int> labelBlock;
+    
+    for (int i = 0; i < (int)instrs.size(); ++i) {
+        bool leader = i == 0 || instrs[i].op == MachineInstr::LABEL || instrs[i - 1].isTerminator();
+        if (leader) {
+            blocks.push_back(BlockInfo{i, i, {}, {}, {}, {}, {}});
+        }
+        blocks.back().last = i;
+        if (instrs[i].op == MachineInstr::LABEL) {
+            labelBlock[instrs[i].label] = (int)blocks.size() - 1;
+        }
+    }
+    
+    for (int b = 0; b < (int)blocks.size(); ++b) {
+        const MachineInstr& term = instrs[blocks[b].last];
+        bool fallsThrough = term.op != MachineInstr::J && term.op != MachineInstr::RET && term.op != MachineInstr::TAIL;
+        if (term.op == MachineInstr::J || term.isBranch()) {
+            auto it = labelBlock.find(term.label);
+            if (it != labelBlock.end()) {
+                blocks[b].successors.push_back(it->second);
+            }
+        }
+        if (fallsThrough && b + 1 < (int)blocks.size()) {
+            blocks[b].successors.push_back(b + 1);
+        }
+    }
+}
+
+void LinearScanAllocator::computeLiveness() {
+    size_t words = (numVirtualRegs() + 63) / 64;
+    const auto& instrs = mf.instructions;
+    
+    for (auto& block : blocks) {
+        block.use.assign(words, 0);
+        block.def.assign(words, 0);
+        block.liveIn.assign(words, 0);
+        block.liveOut.assign(words, 0);
+        for (int i = block.first; i <= block.last; ++i) {
+            for (int reg : instrs[i].uses()) {
+                if (isVirtualReg(reg) && !testBit(block.def, reg - FIRST_VIRTUAL_REG)) {
+                    setBit(block.use, reg - FIRST_VIRTUAL_REG);
+                }
+            }
+            for (int reg : instrs[i].defs()) {
+                if (isVirtualReg(reg)) {
+                    setBit(block.def, reg - FIRST_VIRTUAL_REG);
+                }
+            }
+        }
+    }
+    
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = (int)blocks.size() - 1; b >= 0; --b) {
+            BlockInfo& block = blocks[b];
+            for (int succ : block.successors) {
+                for (size_t w = 0; w < words; ++w) {
+                    block.liveOut[w] |= blocks[succ].liveIn[w];
+                }
+            }
+            for (size_t w = 0; w < words; ++w) {
+                uint64_t in = block.use[w] | (block.liveOut[w] & ~block.def[w]);
+                if (in != block.liveIn[w]) {
+                    block.liveIn[w] = in;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void LinearScanAllocator::buildIntervals() {
+    int count = numVirtualRegs();
+    std::vector<int> start(count, INT_MAX), end(count, -1);
+    auto extend = [&](int index, int pos) {
+        start[index] = std::min(start[index], pos);
+        end[index] = std::max(end[index], pos);
+    };
+    
+    const auto& instrs = mf.instructions;
+    callPositions.clear();
+    for (const auto& block : blocks) {
+        forEachBit(block.liveIn, [&](int index) { extend(index, block.first); });
+        forEachBit(block.liveOut, [&](int index) { extend(index, block.last); });
+        for (int i = block.first; i <= block.last; ++i) {
+            for (int reg : instrs[i].uses()) {
+                if (isVirtualReg(reg)) extend(reg - FIRST_VIRTUAL_REG, i);
+            }
+            for (int reg : instrs[i].defs()) {
+                if (isVirtualReg(reg)) extend(reg - FIRST_VIRTUAL_REG, i);
+            }
+            if (instrs[i].op == MachineInstr::CALL) {
+                callPositions.push_back(i);
+            }
+        }
+    }
+    
+    intervals.clear();
+    for (int index = 0; index < count; ++index) {
+        if (end[index] < 0) continue;
+        intervals.push_back(LiveInterval{index + FIRST_VIRTUAL_REG, start[index], end[index],
+                                         crossesCall(start[index], end[index]), NO_REG, -1});
+    }
+    std::sort(intervals.begin(), intervals.end(), [](const LiveInterval& a, const LiveInterval& b) {
+        return a.start < b.start || (a.start == b.start && a.vreg < b.vreg);
+    });
+}
+
+void LinearScanAllocator::buildFixedRanges() {
+    fixedRanges.clear();
+    std::unordered_map<int, int> lastDef;
+    const auto& instrs = mf.instructions;
+    
+    for (int i = 0; i < (int)instrs.size(); ++i) {
+        for (int reg : instrs[i].uses()) {
+            if (isVirtualReg(reg) || reg == NO_REG) continue;
+            auto it = lastDef.find(reg);
+            fixedRanges[reg].push_back(FixedRange{it == lastDef.end() ? -1 : it->second, i});
+        }
+        for (int reg : instrs[i].defs()) {
+            if (!isVirtualReg(reg) && reg != NO_REG) {
+                lastDef[reg] = i;
+            }
+        }
+    }
+}
+
+bool LinearScanAllocator::crossesCall(int start, int end) const {
+    auto it = std::upper_bound(callPositions.begin(), callPositions.end(), start);
+    return it != callPositions.end() && *it < end;
+}
+
+bool LinearScanAllocator::conflictsWithFixed(const LiveInterval& interval, int reg) const {
+    auto it = fixedRanges.find(reg);
+    if (it == fixedRanges.end()) return false;
+    for (const auto& range : it->second) {
+        // 首尾相接（同一条指令先读后写）不算冲突
+        if (std::max(interval.start, range.start) < std::min(interval.end, range.end)) return true;
+        if (range.start < interval.start && interval.start < range.end) return true;
+    }
+    return false;
+}
+
+bool LinearScanAllocator::canUse(const LiveInterval& interval, int reg) const {
+    if (interval.crossesCall && !isCalleeSaved(reg)) return false;
+    return !conflictsWithFixed(interval, reg);
+}
+
+void LinearScanAllocator::allocate() {
+    std::vector<bool> busy(FIRST_VIRTUAL_REG, false);
+    std::vector<int> active;  // intervals 下标
+    int nextSlot = mf.spillSlots;
+    
+    auto spill = [&](LiveInterval& interval) {
+        interval.physReg = NO_REG;
+        interval.spillSlot = nextSlot++;
+    };
+    
+    for (int current = 0; current < (int)intervals.size(); ++current) {
+        LiveInterval& cur = intervals[current];
+        
+        // 释放已经结束的区间
+        active.erase(std::remove_if(active.begin(), active.end(), [&](int idx) {
+            if (intervals[idx].end <= cur.start) {
+                busy[intervals[idx].physReg] = false;
+                return true;
+            }
+            return false;
+        }), active.end());
+        
+        int chosen = NO_REG;
+        if (!cur.crossesCall) {
+            for (int reg : callerSavedPool) {
+                if (!busy[reg] && canUse(cur, reg)) { chosen = reg; break; }
+            }
+        }
+        if (chosen == NO_REG) {
+            for (int reg : calleeSavedPool) {
+                if (!busy[reg] && canUse(cur, reg)) { chosen = reg; break; }
+            }
+        }
+        
+        if (chosen != NO_REG) {
+            cur.physReg = chosen;
+            busy[chosen] = true;
+            active.push_back(current);
+            continue;
+        }
+        
+        // 没有空闲寄存器：溢出结束最晚的区间
+        int victim = -1;
+        for (int idx : active) {
+            if (canUse(cur, intervals[idx].physReg) &&
+                (victim < 0 || intervals[idx].end > intervals[victim].end)) {
+                victim = idx;
+            }
+        }
+        if (victim >= 0 && intervals[victim].end > cur.end) {
+            cur.physReg = intervals[victim].physReg;
+            spill(intervals[victim]);
+            active.erase(std::find(active.begin(), active.end(), victim));
+            active.push_back(current);
+        } else {
+            spill(cur);
+        }
+    }
+    
+    mf.spillSlots = nextSlot;
+    assignment.assign(numVirtualRegs(), NO_REG);
+    std::vector<bool> calleeUsed(FIRST_VIRTUAL_REG, false);
+    for (const auto& interval : intervals) {
+        int index = interval.vreg - FIRST_VIRTUAL_REG;
+        if (interval.physReg != NO_REG) {
+            assignment[index] = interval.physReg;
+            calleeUsed[interval.physReg] = calleeUsed[interval.physReg] || isCalleeSaved(interval.physReg);
+        } else {
+            assignment[index] = -(interval.spillSlot + 1);
+        }
+    }
+    for (int reg : calleeSavedPool) {
+        if (calleeUsed[reg] &&
+            std::find(mf.usedCalleeSaved.begin(), mf.usedCalleeSaved.end(), reg) == mf.usedCalleeSaved.end()) {
+            mf.usedCalleeSaved.push_back(reg);
+        }
+    }
+}
+
+void LinearScanAllocator::rewrite() {
+    std::vector<MachineInstr> result;
+    result.reserve(mf.instructions.size());
+    
+    for (MachineInstr instr : mf.instructions) {
+        int reloadedSlot = -1;
+        int reloadedReg = NO_REG;
+        auto mapUse = [&](int& reg, int scratch) {
+            if (!isVirtualReg(reg)) return;
+            int target = assignment[reg - FIRST_VIRTUAL_REG];
+            if (target >= 0) {
+                reg = target;
+                return;
+            }
+            int slot = -target - 1;
+            if (slot == reloadedSlot) {
+                reg = reloadedReg;
+                return;
+            }
+            result.emplace_back(MachineInstr::LW, scratch, REG_FP, NO_REG, mf.spillSlotOffset(slot));
+            reloadedSlot = slot;
+            reloadedReg = scratch;
+            reg = scratch;
+        };
+        
+        bool isStore = instr.op == MachineInstr::SW;
+        mapUse(instr.rs1, SPILL_SCRATCH_0);
+        mapUse(instr.rs2, SPILL_SCRATCH_1);
+        
+        int spillAfter = -1;
+        if (!isStore && isVirtualReg(instr.rd)) {
+            int target = assignment[instr.rd - FIRST_VIRTUAL_REG];
+            if (target >= 0) {
+                instr.rd = target;
+            } else {
+                spillAfter = -target - 1;
+                instr.rd = SPILL_SCRATCH_0;
+            }
+        }
+        
+        if (instr.op != MachineInstr::MV || instr.rd != instr.rs1) {
+            result.push_back(instr);
+        }
+        if (spillAfter >= 0) {
+            result.emplace_back(MachineInstr::SW, NO_REG, REG_FP, SPILL_SCRATCH_0, mf.spillSlotOffset(spillAfter));
+        }
+    }
+    
+    mf.instructions = std::move(result);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "codegen/machine.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 线性扫描寄存器分配（Poletto & Sarkar）
+// 在机器指令序列上建立基本块和活跃性，为每个虚拟寄存器计算一个活跃区间，
+// 按起点顺序分配到 t0-t4 / a0-a7 / s1-s11。跨越 call 的区间只能使用 s1-s11，
+// 寄存器不够时把结束最晚的区间溢出到栈帧，溢出值通过保留的 t5/t6 读写。
+class LinearScanAllocator {
+public:
+    explicit LinearScanAllocator(MachineFunction& function) : mf(function) {}
+    
+    void run();
+    
+private:
+    struct LiveInterval {
+        int vreg;
+        int start;
+        int end;
+        bool crossesCall;
+        int physReg;
+        int spillSlot;
+    };
+    
+    struct BlockInfo {
+        int first;
+        int last;
+        std::vector<int> successors;
+        std::vector<uint64_t> use, def, liveIn, liveOut;
+    };
+    
+    // 物理寄存器被显式使用的区间（如调用前后的 a0-a7）
+    struct FixedRange {
+        int start;
+        int end;
+    };
+    
+    MachineFunction& mf;
+    std::vector<BlockInfo> blocks;
+    std::vector<LiveInterval> intervals;
+    std::unordered_map<int, std::vector<FixedRange>> fixedRanges;
+    std::vector<int> callPositions;
+    std::vector<int> assignment;  // vreg 下标 -> 物理寄存器，或 -(溢出槽 + 1)
+    
+    int numVirtualRegs() const { return mf.nextVirtualReg - FIRST_VIRTUAL_REG; }
+    
+    void buildBlocks();
+    void computeLiveness();
+    void buildIntervals();
+    void buildFixedRanges();
+    void allocate();
+    void rewrite();
+    
+    bool crossesCall(int start, int end) const;
+    bool conflictsWithFixed(const LiveInterval& interval, int reg) const;
+    bool canUse(const LiveInterval& interval, int reg) const;
+};
@@ -1,378 +1,1055 @@
-#include "codegen/riscv.hpp"
-#include <iostream>
-#include <sstream>
-
-// 在RISCVCodeGenerator类中添加这些方法
-
-void RISCVCodeGenerator::optimizeConstantFolding(BinaryExpression& node) {
-    if (!optimizationsEnabled) return;
-    
-    // 检查是否可以进行常量折叠
-    if (isConstantExpression(node.left.get()) && isConstantExpression(node.right.get())) {
-        int leftVal = evaluateConstantExpression(node.left.get());
-        int rightVal = evaluateConstantExpression(node.right.get());
-        int result = 0;
-        
-        switch (node.op) {
-            case BinaryExpression::ADD: result = leftVal + rightVal; break;
-            case BinaryExpression::SUB: result = leftVal - rightVal; break;
-            case BinaryExpression::MUL: result = leftVal * rightVal; break;
-            case BinaryExpression::DIV: 
-                if (rightVal != 0) result = leftVal / rightVal; 
-                else return; // 避免除零
-                break;
-            case BinaryExpression::MOD: 
-                if (rightVal != 0) result = leftVal % rightVal; 
-                else return;
-                break;
-            default: return; // 其他操作不优化
-        }
-        
-        // 直接加载常量结果
-        emit("li t0, " + std::to_string(result));
-        emit("addi sp, sp, -4");
-        emit("sw t0, 0(sp)");
-        return;
-    }
-    
-    // 如果不能完全折叠，检查是否有简单优化
-    if (isConstantExpression(node.right.get())) {
-        int rightVal = evaluateConstantExpression(node.right.get());
-        
-        // 优化加0、乘1等
-        if (node.op == BinaryExpression::ADD && rightVal == 0) {
-            node.left->accept(*this);
-            return;
-        }
-        if (node.op == BinaryExpression::MUL && rightVal == 1) {
-            node.left->accept(*this);
-            return;
-        }
-        if (node.op == BinaryExpression::MUL && rightVal == 0) {
-            emit("li t0, 0");
-            emit("addi sp, sp, -4");
-            emit("sw t0, 0(sp)");
-            return;
-        }
-    }
-}
-
-bool RISCVCodeGenerator::isConstantExpression(Expression* expr) {
-    if (!expr) return false;
-    
-    // 检查是否是数字字面量
-    if (dynamic_cast<NumberLiteral*>(expr)) {
-        return true;
-    }
-    
-    // 检查是否是已知常量变量
-    if (auto ident = dynamic_cast<Identifier*>(expr)) {
-        return constantValues.find(ident->name) != constantValues.end();
-    }
-    
-    return false;
-}
-
-int RISCVCodeGenerator::evaluateConstantExpression(Expression* expr) {
-    if (auto numLit = dynamic_cast<NumberLiteral*>(expr)) {
-        return numLit->value;
-    }
-    
-    if (auto ident = dynamic_cast<Identifier*>(expr)) {
-        auto it = constantValues.find(ident->name);
-        if (it != constantValues.end()) {
-            return it->second;
-        }
-    }
-    
-    return 0;
-}
-
-void RISCVCodeGenerator::visit(BinaryExpression& node) {
-    // 尝试优化
-    if (optimizationsEnabled) {
-        optimizeConstantFolding(node);
-        return;
-    }
-    
-    // 原有的代码生成逻辑
-    node.left->accept(*this);
-    node.right->accept(*this);
-    
-    emit("lw t1, 0(sp)");
-    emit("addi sp, sp, 4");
-    emit("lw t0, 0(sp)");
-    
-    switch (node.op) {
-        case BinaryExpression::ADD:
-            emit("add t0, t0, t1");
-            break;
-        case BinaryExpression::SUB:
-            emit("sub t0, t0, t1");
-            break;
-        case BinaryExpression::MUL:
-            emit("mul t0, t0, t1");
-            break;
-        case BinaryExpression::DIV:
-            emit("div t0, t0, t1");
-            break;
-        case BinaryExpression::MOD:
-            emit("rem t0, t0, t1");
-            break;
-        case BinaryExpression::LT:
-            emit("slt t0, t0, t1");
-            break;
-        case BinaryExpression::LE:
-            emit("slt t2, t1, t0");
-            emit("xori t0, t2, 1");
-            break;
-        case BinaryExpression::GT:
-            emit("slt t0, t1, t0");
-            break;
-        case BinaryExpression::GE:
-            emit("slt t2, t0, t1");
-            emit("xori t0, t2, 1");
-            break;
-        case BinaryExpression::EQ:
-            emit("sub t0, t0, t1");
-            emit("seqz t0, t0");
-            break;
-        case BinaryExpression::NE:
-            emit("sub t0, t0, t1");
-            emit("snez t0, t0");
-            break;
-        case BinaryExpression::AND:
-            emit("and t0, t0, t1");
-            break;
-        case BinaryExpression::OR:
-            emit("or t0, t0, t1");
-            break;
-    }
-    
-    emit("sw t0, 0(sp)");
-}
-
-// 添加所有缺失的方法实现
-std::string RISCVCodeGenerator::generate(CompilationUnit& unit, const std::unordered_map<std::string, FunctionInfo>& funcTable) {
-    output.clear();
-    functions = funcTable;
-    stackOffset = 0;
-    labelCounter = 0;
-    
-    // 生成数据段
-    emit(".data");
-    emit(".text");
-    emit(".global main");
-    
-    // 访问编译单元
-    unit.accept(*this);
-    
-    return output;
-}
-
-void RISCVCodeGenerator::emit(const std::string& instruction) {
-    output += instruction + "\n";
-}
-
-void RISCVCodeGenerator::emitLabel(const std::string& label) {
-    output += label + ":\n";
-}
-
-std::string RISCVCodeGenerator::newLabel(const std::string& prefix) {
-    return prefix + std::to_string(labelCounter++);
-}
-
-void RISCVCodeGenerator::generatePrologue(const std::string& funcName, int localSize) {
-    emitLabel(funcName);
-    emit("addi sp, sp, -" + std::to_string(localSize));
-    emit("sw ra, " + std::to_string(localSize - 4) + "(sp)");
-    emit("sw fp, " + std::to_string(localSize - 8) + "(sp)");
-    emit("addi fp, sp, " + std::to_string(localSize));
-}
-
-void RISCVCodeGenerator::generateEpilogue() {
-    emit("lw ra, -4(fp)");
-    emit("lw fp, -8(fp)");
-    emit("addi sp, sp, 8");
-    emit("ret");
-}
-
-void RISCVCodeGenerator::optimizeDeadCodeElimination() {
-    // 简单的死代码消除实现
-    for (const auto& code : deadCode) {
-        (void)code; // 避免未使用变量警告
-        // 这里可以实现更复杂的死代码消除逻辑
-    }
-}
-
-// Visitor 方法实现
-void RISCVCodeGenerator::visit(UnaryExpression& node) {
-    node.operand->accept(*this);
-    emit("lw t0, 0(sp)");
-    
-    switch (node.op) {
-        case UnaryExpression::PLUS:
-            // 正号不需要操作
-            break;
-        case UnaryExpression::MINUS:
-            emit("neg t0, t0");
-            break;
-        case UnaryExpression::NOT:
-            emit("seqz t0, t0");
-            break;
-    }
-    
-    emit("sw t0, 0(sp)");
-}
-
-void RISCVCodeGenerator::visit(NumberLiteral& node) {
-    emit("li t0, " + std::to_string(node.value));
-    emit("addi sp, sp, -4");
-    emit("sw t0, 0(sp)");
-}
-
-void RISCVCodeGenerator::visit(Identifier& node) {
-    // 查找变量在栈中的位置
-    auto it = localVariables.find(node.name);
-    if (it != localVariables.end()) {
-        emit("lw t0, " + std::to_string(it->second) + "(fp)");
-        emit("addi sp, sp, -4");
-        emit("sw t0, 0(sp)");
-    } else {
-        // 全局变量或未定义变量
-        emit("la t0, " + node.name);
-        emit("lw t0, 0(t0)");
-        emit("addi sp, sp, -4");
-        emit("sw t0, 0(sp)");
-    }
-}
-
-void RISCVCodeGenerator::visit(FunctionCall& node) {
-    // 生成函数调用
-    for (const auto& arg : node.arguments) {
-        arg->accept(*this);
-    }
-    
-    emit("call " + node.functionName);
-    emit("addi sp, sp, " + std::to_string(node.arguments.size() * 4));
-    emit("addi sp, sp, -4");
-    emit("sw a0, 0(sp)");
-}
-
-void RISCVCodeGenerator::visit(AssignmentStatement& node) {
-    node.value->accept(*this);
-    emit("lw t0, 0(sp)");
-    emit("addi sp, sp, 4");
-    
-    auto it = localVariables.find(node.variable);
-    if (it != localVariables.end()) {
-        emit("sw t0, " + std::to_string(it->second) + "(fp)");
-    } else {
-        emit("la t1, " + node.variable);
-        emit("sw t0, 0(t1)");
-    }
-}
-
-void RISCVCodeGenerator::visit(VariableDeclaration& node) {
-    if (node.initializer) {
-        node.initializer->accept(*this);
-        emit("lw t0, 0(sp)");
-        emit("addi sp, sp, 4");
-    } else {
-        emit("li t0, 0");
-    }
-    
-    stackOffset -= 4;
-    localVariables[node.name] = stackOffset;
-    emit("sw t0, " + std::to_string(stackOffset) + "(fp)");
-}
-
-void RISCVCodeGenerator::visit(Block& node) {
-    for (const auto& stmt : node.statements) {
-        stmt->accept(*this);
-    }
-}
-
-void RISCVCodeGenerator::visit(IfStatement& node) {
-    std::string elseLabel = newLabel("else");
-    std::string endLabel = newLabel("endif");
-    
-    node.condition->accept(*this);
-    emit("lw t0, 0(sp)");
-    emit("addi sp, sp, 4");
-    emit("beqz t0, " + elseLabel);
-    
-    node.thenStatement->accept(*this);
-    emit("j " + endLabel);
-    
-    emitLabel(elseLabel);
-    if (node.elseStatement) {
-        node.elseStatement->accept(*this);
-    }
-    
-    emitLabel(endLabel);
-}
-
-void RISCVCodeGenerator::visit(WhileStatement& node) {
-    std::string loopLabel = newLabel("loop");
-    std::string endLabel = newLabel("endloop");
-    
-    emitLabel(loopLabel);
-    node.condition->accept(*this);
-    emit("lw t0, 0(sp)");
-    emit("addi sp, sp, 4");
-    emit("beqz t0, " + endLabel);
-    
-    node.body->accept(*this);
-    emit("j " + loopLabel);
-    
-    emitLabel(endLabel);
-}
-
-void RISCVCodeGenerator::visit(BreakStatement& node) {
-    (void)node; // 避免未使用参数警告
-    // 简单的 break 实现，需要更复杂的标签管理
-    emit("j break_label"); // 这里需要实际的 break 标签
-}
-
-void RISCVCodeGenerator::visit(ContinueStatement& node) {
-    (void)node; // 避免未使用参数警告
-    // 简单的 continue 实现，需要更复杂的标签管理
-    emit("j continue_label"); // 这里需要实际的 continue 标签
-}
-
-void RISCVCodeGenerator::visit(ReturnStatement& node) {
-    if (node.value) {
-        node.value->accept(*this);
-        emit("lw a0, 0(sp)");
-        emit("addi sp, sp, 4");
-    } else {
-        emit("li a0, 0");
-    }
-    
-    generateEpilogue();
-}
-
-void RISCVCodeGenerator::visit(ExpressionStatement& node) {
-    node.expression->accept(*this);
-    emit("addi sp, sp, 4"); // 弹出表达式结果
-}
-
-void RISCVCodeGenerator::visit(FunctionDefinition& node) {
-    currentFunction = node.name;
-    localVariables.clear();
-    stackOffset = 0;
-    
-    // 计算局部变量空间
-    int localSize = 8; // ra, fp
-    
-    generatePrologue(node.name, localSize);
-    node.body->accept(*this);
-    generateEpilogue();
-}
-
-void RISCVCodeGenerator::visit(CompilationUnit& node) {
-    for (const auto& func : node.functions) {
-        func->accept(*this);
-    }
-}
\ No newline at end of file
+#include "codegen/riscv.hpp"
+#include "codegen/regalloc.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+void RISCVCodeGenerator::visit(BinaryExpression& node) {
+    // 常量折叠已在 ConstantFolder 中对 AST 完成
+    if (node.op == BinaryExpression::AND || node.op == BinaryExpression::OR) {
+        generateShortCircuit(node);
+        return;
+    }
+    node.left->accept(*this);
+    node.right->accept(*this);
+    
+    int rhs = popValue(REG_T1);
+    int lhs = popValue(REG_T0);
+    int dst = REG_T0;
+    
+    switch (node.op) {
+        case BinaryExpression::ADD:
+            emit(MachineInstr(MachineInstr::ADD, dst, lhs, rhs));
+            break;
+        case BinaryExpression::SUB:
+            emit(MachineInstr(MachineInstr::SUB, dst, lhs, rhs));
+            break;
+        case BinaryExpression::MUL:
+            emit(MachineInstr(MachineInstr::MUL, dst, lhs, rhs));
+            break;
+        case BinaryExpression::DIV:
+            emit(MachineInstr(MachineInstr::DIV, dst, lhs, rhs));
+            break;
+        case BinaryExpression::MOD:
+            emit(MachineInstr(MachineInstr::REM, dst, lhs, rhs));
+            break;
+        case BinaryExpression::LT:
+            emit(MachineInstr(MachineInstr::SLT, dst, lhs, rhs));
+            break;
+        case BinaryExpression::LE: {
+            int tmp = REG_T2;
+            emit(MachineInstr(MachineInstr::SLT, tmp, rhs, lhs));
+            emit(MachineInstr(MachineInstr::XORI, dst, tmp, NO_REG, 1));
+            break;
+        }
+        case BinaryExpression::GT:
+            emit(MachineInstr(MachineInstr::SLT, dst, rhs, lhs));
+            break;
+        case BinaryExpression::GE: {
+            int tmp = REG_T2;
+            emit(MachineInstr(MachineInstr::SLT, tmp, lhs, rhs));
+            emit(MachineInstr(MachineInstr::XORI, dst, tmp, NO_REG, 1));
+            break;
+        }
+        case BinaryExpression::EQ: {
+            int tmp = REG_T0;
+            emit(MachineInstr(MachineInstr::SUB, tmp, lhs, rhs));
+            emit(MachineInstr(MachineInstr::SEQZ, dst, tmp));
+            break;
+        }
+        case BinaryExpression::NE: {
+            int tmp = REG_T0;
+            emit(MachineInstr(MachineInstr::SUB, tmp, lhs, rhs));
+            emit(MachineInstr(MachineInstr::SNEZ, dst, tmp));
+            break;
+        }
+        case BinaryExpression::AND:
+        case BinaryExpression::OR:
+            break;  // 已由 generateShortCircuit 处理
+    }
+    
+    pushValue(dst);
+}
+
+// && 和 ||：左操作数已经决定结果时不求值右操作数，结果规范化为 0/1
+void RISCVCodeGenerator::generateShortCircuit(BinaryExpression& node) {
+    bool isAnd = node.op == BinaryExpression::AND;
+    std::string shortLabel = newLabel(isAnd ? "and_false" : "or_true");
+    std::string endLabel = newLabel(isAnd ? "and_end" : "or_end");
+    
+    node.left->accept(*this);
+    int lhs = popValue(REG_T0);
+    emit(MachineInstr(isAnd ? MachineInstr::BEQZ : MachineInstr::BNEZ, NO_REG, lhs, NO_REG, 0, shortLabel));
+    node.right->accept(*this);
+    int rhs = popValue(REG_T0);
+    emit(MachineInstr(MachineInstr::SNEZ, REG_T0, rhs));
+    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, endLabel));
+    emitLabel(shortLabel);
+    emit(MachineInstr(MachineInstr::LI, REG_T0, NO_REG, NO_REG, isAnd ? 0 : 1));
+    emitLabel(endLabel);
+    pushValue(REG_T0);
+}
+
+// 添加所有缺失的方法实现
+void RISCVCodeGenerator::generate(CompilationUnit& unit, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink) {
+    out = &sink;
+    functions = &funcTable;
+    stackOffset = 0;
+    labelCounter = 0;
+    
+    // 生成数据段
+    emit(".data");
+    emit(".text");
+    emit(".global main");
+    
+    // 访问编译单元
+    unit.accept(*this);
+    out = nullptr;
+    functions = nullptr;
+}
+
+void RISCVCodeGenerator::generate(IRModule& module, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink) {
+    emitHeader(sink);
+    for (auto& function : module.functions) {
+        generate(*function, funcTable, sink);
+    }
+}
+
+void RISCVCodeGenerator::generate(IRFunction& function, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink) {
+    out = &sink;
+    functions = &funcTable;
+    selectFunction(function);
+    out = nullptr;
+    functions = nullptr;
+}
+    
+void RISCVCodeGenerator::emitHeader(OutputSink& sink) {
+    sink.write(".data\n.text\n.global main\n");
+}
+
+static bool fitsImm12(int value) {
+    return value >= -2048 && value <= 2047;
+}
+
+void RISCVCodeGenerator::selectFunction(IRFunction& function) {
+    currentFunction = function.name;
+    machineFunction = MachineFunction(function.name);
+    machineFunction.nextVirtualReg = FIRST_VIRTUAL_REG + function.numVars();
+    
+    // 标签按函数划分命名空间（.L<函数名>_<序号>），函数的汇编与其它函数无关，可以单独缓存和重放
+    blockLabels.clear();
+    labelCounter = 0;
+    std::string labelPrefix = ".L" + function.name + "_";
+    std::vector<int> useCounts(function.numVars(), 0);
+    for (const auto& block : function.blocks) {
+        blockLabels[block.get()] = newLabel(labelPrefix);
+        for (const auto& instr : block->instructions) {
+            for (const auto& operand : instr.operands) {
+                if (operand.isVar()) useCounts[operand.value]++;
+            }
+        }
+    }
+    
+    // 前 8 个参数从 a0-a7 取出，其余位于调用者栈帧底部，即 (i-8)*4(fp)
+    for (size_t i = 0; i < function.params.size(); ++i) {
+        int param = irVarReg(function.params[i]);
+        if (i < NUM_ARG_REGS) {
+            emit(MachineInstr(MachineInstr::MV, param, REG_A0 + (int)i));
+        } else {
+            emit(MachineInstr(MachineInstr::LW, param, REG_FP, NO_REG, 4 * (int)(i - NUM_ARG_REGS)));
+        }
+    }
+    
+    for (size_t i = 0; i < function.blocks.size(); ++i) {
+        const BasicBlock* block = function.blocks[i].get();
+        const BasicBlock* nextBlock = i + 1 < function.blocks.size() ? function.blocks[i + 1].get() : nullptr;
+        if (!block->preds.empty()) {
+            emitLabel(blockLabels[block]);
+        }
+        const auto& instrs = block->instructions;
+        for (size_t k = 0; k < instrs.size(); ++k) {
+            // 只被紧随其后的分支使用的比较，与分支融合为一条比较跳转
+            const IRInstr& instr = instrs[k];
+            if (instr.op >= IRInstr::LT && instr.op <= IRInstr::NE && k + 1 < instrs.size() &&
+                instrs[k + 1].op == IRInstr::BRANCH && instrs[k + 1].operands[0] == IRValue::var(instr.dst) &&
+                useCounts[instr.dst] == 1) {
+                selectCompareBranch(instr, instrs[k + 1], nextBlock);
+                ++k;
+                continue;
+            }
+            if (k + 1 < instrs.size() && isSiblingCall(instr, instrs[k + 1])) {
+                int regArgs = selectCallArgs(instr);
+                emit(MachineInstr(MachineInstr::TAIL, NO_REG, NO_REG, NO_REG, regArgs, instr.callee));
+                ++k;
+                continue;
+            }
+            selectInstr(instr, nextBlock);
+        }
+    }
+    
+    // 变量全部位于虚拟寄存器中，局部变量区为空
+    machineFunction.localSize = 0;
+    if (optimizationsEnabled) {
+        // 函数体中不压栈，sp 在序言之后保持不变，栈帧可以完全相对 sp 寻址而不设置 fp；
+        // 没有 call 的叶函数不改写 ra（tail 经 t1 跳转），不必保存它
+        machineFunction.usesFP = false;
+        machineFunction.savesRA = std::any_of(machineFunction.instructions.begin(), machineFunction.instructions.end(),
+                                              [](const MachineInstr& instr) { return instr.op == MachineInstr::CALL; });
+    }
+    finishFunction(true);
+}
+
+// 栈上的实参写入本函数栈帧底部的传出参数区，寄存器实参最后就位，
+// 以免计算栈实参时用到的临时寄存器与 a0-a7 冲突；返回寄存器传参的个数
+int RISCVCodeGenerator::selectCallArgs(const IRInstr& call) {
+    int argCount = (int)call.operands.size();
+    int regArgs = std::min(argCount, NUM_ARG_REGS);
+    for (int i = NUM_ARG_REGS; i < argCount; ++i) {
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, valueReg(call.operands[i]), 4 * (i - NUM_ARG_REGS)));
+    }
+    machineFunction.outgoingArgSize = std::max(machineFunction.outgoingArgSize, 4 * (argCount - regArgs));
+    for (int i = 0; i < regArgs; ++i) {
+        const IRValue& arg = call.operands[i];
+        if (arg.isConst()) {
+            emit(MachineInstr(MachineInstr::LI, REG_A0 + i, NO_REG, NO_REG, arg.value));
+        } else {
+            emit(MachineInstr(MachineInstr::MV, REG_A0 + i, irVarReg(arg.value)));
+        }
+    }
+    return regArgs;
+}
+
+// return f(...) 且实参全部经寄存器传递时，被调函数可以直接复用调用者的返回地址：
+// 拆除本函数栈帧后跳转过去，不再占用栈空间
+bool RISCVCodeGenerator::isSiblingCall(const IRInstr& call, const IRInstr& ret) const {
+    if (!optimizationsEnabled || call.op != IRInstr::CALL || ret.op != IRInstr::RET ||
+        call.operands.size() > NUM_ARG_REGS) {
+        return false;
+    }
+    if (ret.operands.empty()) return true;
+    return call.dst >= 0 && ret.operands[0] == IRValue::var(call.dst);
+}
+
+// 常量操作数：0 直接使用 zero 寄存器，其余用 li 装入新的虚拟寄存器
+int RISCVCodeGenerator::valueReg(const IRValue& value) {
+    if (value.isVar()) {
+        return irVarReg(value.value);
+    }
+    if (value.value == 0) {
+        return REG_ZERO;
+    }
+    int reg = machineFunction.newVirtualReg();
+    emit(MachineInstr(MachineInstr::LI, reg, NO_REG, NO_REG, value.value));
+    return reg;
+}
+
+// v 是 2 的幂时返回指数，否则返回 -1
+static int exactLog2(uint32_t v) {
+    if (v == 0 || (v & (v - 1)) != 0) return -1;
+    int k = 0;
+    while ((v >> k) != 1) ++k;
+    return k;
+}
+
+// 有符号除以常数 d（|d| >= 2，且不是 2 的幂）的魔数与移位量：
+// n / d = mulh(n, magic) [± n] >> shift，再加上结果的符号位（Hacker's Delight 10-1）
+static void signedDivisionMagic(int d, int& magic, int& shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+    uint32_t t = two31 + ((uint32_t)d >> 31);
+    uint32_t anc = t - 1 - t % ad;
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    magic = (int)(q2 + 1);
+    if (d < 0) magic = (int)(0u - (uint32_t)magic);
+    shift = p - 32;
+}
+
+// 乘以常数：2 的幂用移位，两个 2 的幂之和/差用两次移位加一次加减
+bool RISCVCodeGenerator::selectMulByConstant(int dst, int lhs, int c) {
+    uint32_t value = (uint32_t)c;
+    if (c == 0) {
+        emit(MachineInstr(MachineInstr::MV, dst, REG_ZERO));
+        return true;
+    }
+    if (c == 1) {
+        emit(MachineInstr(MachineInstr::MV, dst, lhs));
+        return true;
+    }
+    if (c == -1) {
+        emit(MachineInstr(MachineInstr::NEG, dst, lhs));
+        return true;
+    }
+    auto shifted = [this, lhs](int k) {
+        if (k == 0) return lhs;
+        int reg = machineFunction.newVirtualReg();
+        emit(MachineInstr(MachineInstr::SLLI, reg, lhs, NO_REG, k));
+        return reg;
+    };
+    
+    int k = exactLog2(value);
+    if (k >= 0) {
+        emit(MachineInstr(MachineInstr::SLLI, dst, lhs, NO_REG, k));
+        return true;
+    }
+    k = exactLog2(0u - value);
+    if (k >= 0) {
+        emit(MachineInstr(MachineInstr::NEG, dst, shifted(k)));
+        return true;
+    }
+    
+    // c = 2^a + 2^b
+    uint32_t low = value & (0u - value);
+    int a = exactLog2(value - low);
+    if (a >= 0) {
+        int high = shifted(a);
+        emit(MachineInstr(MachineInstr::ADD, dst, high, shifted(exactLog2(low))));
+        return true;
+    }
+    // c = 2^a - 2^b
+    a = exactLog2(value + low);
+    if (a >= 0 && a > exactLog2(low)) {
+        int high = shifted(a);
+        emit(MachineInstr(MachineInstr::SUB, dst, high, shifted(exactLog2(low))));
+        return true;
+    }
+    return false;
+}
+
+// 截断到零的有符号除法：负被除数先加上 2^k - 1 再算术右移
+bool RISCVCodeGenerator::selectDivByConstant(int dst, int lhs, int c) {
+    if (c == 0 || c == INT32_MIN) return false;
+    if (c == 1) {
+        emit(MachineInstr(MachineInstr::MV, dst, lhs));
+        return true;
+    }
+    if (c == -1) {
+        emit(MachineInstr(MachineInstr::NEG, dst, lhs));
+        return true;
+    }
+    
+    int k = exactLog2(c < 0 ? 0u - (uint32_t)c : (uint32_t)c);
+    if (k >= 0) {
+        int quotient = c < 0 ? machineFunction.newVirtualReg() : dst;
+        emit(MachineInstr(MachineInstr::SRAI, quotient, roundTowardZero(lhs, k), NO_REG, k));
+        if (c < 0) emit(MachineInstr(MachineInstr::NEG, dst, quotient));
+        return true;
+    }
+    
+    int magic, shift;
+    signedDivisionMagic(c, magic, shift);
+    int magicReg = machineFunction.newVirtualReg();
+    emit(MachineInstr(MachineInstr::LI, magicReg, NO_REG, NO_REG, magic));
+    int q = machineFunction.newVirtualReg();
+    emit(MachineInstr(MachineInstr::MULH, q, lhs, magicReg));
+    if (c > 0 && magic < 0) {
+        int sum = machineFunction.newVirtualReg();
+        emit(MachineInstr(MachineInstr::ADD, sum, q, lhs));
+        q = sum;
+    } else if (c < 0 && magic > 0) {
+        int diff = machineFunction.newVirtualReg();
+        emit(MachineInstr(MachineInstr::SUB, diff, q, lhs));
+        q = diff;
+    }
+    if (shift > 0) {
+        int shiftedQ = machineFunction.newVirtualReg();
+        emit(MachineInstr(MachineInstr::SRAI, shiftedQ, q, NO_REG, shift));
+        q = shiftedQ;
+    }
+    // 商为负时向零方向修正 1
+    int sign = machineFunction.newVirtualReg();
+    emit(MachineInstr(MachineInstr::SRLI, sign, q, NO_REG, 31));
+    emit(MachineInstr(MachineInstr::ADD, dst, q, sign));
+    return true;
+}
+
+// 余数与被除数同号：r = n - (n / c) * c，2 的幂时直接清掉低位
+bool RISCVCodeGenerator::selectModByConstant(int dst, int lhs, int c) {
+    if (c == 0 || c == INT32_MIN) return false;
+    if (c == 1 || c == -1) {
+        emit(MachineInstr(MachineInstr::MV, dst, REG_ZERO));
+        return true;
+    }
+    
+    int k = exactLog2(c < 0 ? 0u - (uint32_t)c : (uint32_t)c);
+    int multiple = machineFunction.newVirtualReg();
+    if (k >= 0 && k <= 11) {
+        emit(MachineInstr(MachineInstr::ANDI, multiple, roundTowardZero(lhs, k), NO_REG, -(1 << k)));
+    } else {
+        int quotient = machineFunction.newVirtualReg();
+        selectDivByConstant(quotient, lhs, c);
+        if (!selectMulByConstant(multiple, quotient, c)) {
+            emit(MachineInstr(MachineInstr::MUL, multiple, quotient, valueReg(IRValue::constant(c))));
+        }
+    }
+    emit(MachineInstr(MachineInstr::SUB, dst, lhs, multiple));
+    return true;
+}
+
+// n + (n < 0 ? 2^k - 1 : 0)，使随后的算术右移向零取整
+int RISCVCodeGenerator::roundTowardZero(int lhs, int k) {
+    int bias = machineFunction.newVirtualReg();
+    if (k == 1) {
+        emit(MachineInstr(MachineInstr::SRLI, bias, lhs, NO_REG, 31));
+    } else {
+        int sign = machineFunction.newVirtualReg();
+        emit(MachineInstr(MachineInstr::SRAI, sign, lhs, NO_REG, 31));
+        emit(MachineInstr(MachineInstr::SRLI, bias, sign, NO_REG, 32 - k));
+    }
+    int sum = machineFunction.newVirtualReg();
+    emit(MachineInstr(MachineInstr::ADD, sum, lhs, bias));
+    return sum;
+}
+
+void RISCVCodeGenerator::selectBinary(const IRInstr& instr) {
+    int dst = irVarReg(instr.dst);
+    IRValue lhsValue = instr.operands[0];
+    IRValue rhsValue = instr.operands[1];
+    
+    // 可交换运算把常量放到右边，便于使用立即数指令
+    bool commutative = instr.op == IRInstr::ADD || instr.op == IRInstr::MUL ||
+                       instr.op == IRInstr::EQ || instr.op == IRInstr::NE;
+    if (commutative && lhsValue.isConst() && !rhsValue.isConst()) {
+        std::swap(lhsValue, rhsValue);
+    }
+    
+    if (rhsValue.isConst() && !lhsValue.isConst()) {
+        int lhs = irVarReg(lhsValue.value);
+        int c = rhsValue.value;
+        switch (instr.op) {
+            case IRInstr::ADD:
+                if (fitsImm12(c)) {
+                    emit(MachineInstr(MachineInstr::ADDI, dst, lhs, NO_REG, c));
+                    return;
+                }
+                break;
+            case IRInstr::SUB:
+                if (c != -2048 && fitsImm12(-c)) {
+                    emit(MachineInstr(MachineInstr::ADDI, dst, lhs, NO_REG, -c));
+                    return;
+                }
+                break;
+            case IRInstr::MUL:
+                if (selectMulByConstant(dst, lhs, c)) return;
+                break;
+            case IRInstr::DIV:
+                if (selectDivByConstant(dst, lhs, c)) return;
+                break;
+            case IRInstr::MOD:
+                if (selectModByConstant(dst, lhs, c)) return;
+                break;
+            case IRInstr::LT:
+                if (fitsImm12(c)) {
+                    emit(MachineInstr(MachineInstr::SLTI, dst, lhs, NO_REG, c));
+                    return;
+                }
+                break;
+            case IRInstr::GE:
+                if (fitsImm12(c)) {
+                    int tmp = machineFunction.newVirtualReg();
+                    emit(MachineInstr(MachineInstr::SLTI, tmp, lhs, NO_REG, c));
+                    emit(MachineInstr(MachineInstr::XORI, dst, tmp, NO_REG, 1));
+                    return;
+                }
+                break;
+            case IRInstr::EQ:
+            case IRInstr::NE: {
+                if (!fitsImm12(c)) break;
+                int tmp = lhs;
+                if (c != 0) {
+                    tmp = machineFunction.newVirtualReg();
+                    emit(MachineInstr(MachineInstr::XORI, tmp, lhs, NO_REG, c));
+                }
+                emit(MachineInstr(instr.op == IRInstr::EQ ? MachineInstr::SEQZ : MachineInstr::SNEZ, dst, tmp));
+                return;
+            }
+            default:
+                break;
+        }
+    }
+    
+    int lhs = valueReg(lhsValue);
+    int rhs = valueReg(rhsValue);
+    switch (instr.op) {
+        case IRInstr::ADD:
+            emit(MachineInstr(MachineInstr::ADD, dst, lhs, rhs));
+            break;
+        case IRInstr::SUB:
+            emit(MachineInstr(MachineInstr::SUB, dst, lhs, rhs));
+            break;
+        case IRInstr::MUL:
+            emit(MachineInstr(MachineInstr::MUL, dst, lhs, rhs));
+            break;
+        case IRInstr::DIV:
+            emit(MachineInstr(MachineInstr::DIV, dst, lhs, rhs));
+            break;
+        case IRInstr::MOD:
+            emit(MachineInstr(MachineInstr::REM, dst, lhs, rhs));
+            break;
+        case IRInstr::LT:
+            emit(MachineInstr(MachineInstr::SLT, dst, lhs, rhs));
+            break;
+        case IRInstr::GT:
+            emit(MachineInstr(MachineInstr::SLT, dst, rhs, lhs));
+            break;
+        case IRInstr::LE:
+        case IRInstr::GE: {
+            int tmp = machineFunction.newVirtualReg();
+            if (instr.op == IRInstr::LE) {
+                emit(MachineInstr(MachineInstr::SLT, tmp, rhs, lhs));
+            } else {
+                emit(MachineInstr(MachineInstr::SLT, tmp, lhs, rhs));
+            }
+            emit(MachineInstr(MachineInstr::XORI, dst, tmp, NO_REG, 1));
+            break;
+        }
+        case IRInstr::EQ:
+        case IRInstr::NE: {
+            int tmp = machineFunction.newVirtualReg();
+            emit(MachineInstr(MachineInstr::XOR, tmp, lhs, rhs));
+            emit(MachineInstr(instr.op == IRInstr::EQ ? MachineInstr::SEQZ : MachineInstr::SNEZ, dst, tmp));
+            break;
+        }
+        case IRInstr::AND: {
+            int l = machineFunction.newVirtualReg();
+            int r = machineFunction.newVirtualReg();
+            emit(MachineInstr(MachineInstr::SNEZ, l, lhs));
+            emit(MachineInstr(MachineInstr::SNEZ, r, rhs));
+            emit(MachineInstr(MachineInstr::AND, dst, l, r));
+            break;
+        }
+        case IRInstr::OR: {
+            int tmp = machineFunction.newVirtualReg();
+            emit(MachineInstr(MachineInstr::OR, tmp, lhs, rhs));
+            emit(MachineInstr(MachineInstr::SNEZ, dst, tmp));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void RISCVCodeGenerator::selectCompareBranch(const IRInstr& compare, const IRInstr& branch, const BasicBlock* nextBlock) {
+    const BasicBlock* ifTrue = branch.targets[0];
+    const BasicBlock* ifFalse = branch.targets[1];
+    int lhs = valueReg(compare.operands[0]);
+    int rhs = valueReg(compare.operands[1]);
+    
+    // 统一成 beq/bne/blt/bge；a > b 即 b < a，a <= b 即 b >= a
+    IRInstr::Opcode op = compare.op;
+    if (op == IRInstr::GT || op == IRInstr::LE) {
+        std::swap(lhs, rhs);
+        op = op == IRInstr::GT ? IRInstr::LT : IRInstr::GE;
+    }
+    // 真分支紧跟其后时反转条件，跳向假分支
+    if (ifTrue == nextBlock) {
+        std::swap(ifTrue, ifFalse);
+        switch (op) {
+            case IRInstr::LT: op = IRInstr::GE; break;
+            case IRInstr::GE: op = IRInstr::LT; break;
+            case IRInstr::EQ: op = IRInstr::NE; break;
+            default: op = IRInstr::EQ; break;
+        }
+    }
+    
+    MachineInstr::Opcode branchOp = MachineInstr::BNE;
+    switch (op) {
+        case IRInstr::LT: branchOp = MachineInstr::BLT; break;
+        case IRInstr::GE: branchOp = MachineInstr::BGE; break;
+        case IRInstr::EQ: branchOp = MachineInstr::BEQ; break;
+        default: branchOp = MachineInstr::BNE; break;
+    }
+    emit(MachineInstr(branchOp, NO_REG, lhs, rhs, 0, blockLabels[ifTrue]));
+    if (ifFalse != nextBlock) {
+        emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, blockLabels[ifFalse]));
+    }
+}
+
+void RISCVCodeGenerator::selectInstr(const IRInstr& instr, const BasicBlock* nextBlock) {
+    switch (instr.op) {
+        case IRInstr::COPY:
+            if (instr.operands[0].isConst()) {
+                emit(MachineInstr(MachineInstr::LI, irVarReg(instr.dst), NO_REG, NO_REG, instr.operands[0].value));
+            } else {
+                emit(MachineInstr(MachineInstr::MV, irVarReg(instr.dst), irVarReg(instr.operands[0].value)));
+            }
+            break;
+        case IRInstr::NEG:
+            emit(MachineInstr(MachineInstr::NEG, irVarReg(instr.dst), valueReg(instr.operands[0])));
+            break;
+        case IRInstr::NOT:
+            emit(MachineInstr(MachineInstr::SEQZ, irVarReg(instr.dst), valueReg(instr.operands[0])));
+            break;
+        case IRInstr::CALL: {
+            int regArgs = selectCallArgs(instr);
+            emit(MachineInstr(MachineInstr::CALL, NO_REG, NO_REG, NO_REG, regArgs, instr.callee));
+            if (instr.dst >= 0) {
+                emit(MachineInstr(MachineInstr::MV, irVarReg(instr.dst), REG_A0));
+            }
+            break;
+        }
+        case IRInstr::RET:
+            if (!instr.operands.empty() && instr.operands[0].isVar()) {
+                emit(MachineInstr(MachineInstr::MV, REG_A0, irVarReg(instr.operands[0].value)));
+            } else {
+                int value = instr.operands.empty() ? 0 : instr.operands[0].value;
+                emit(MachineInstr(MachineInstr::LI, REG_A0, NO_REG, NO_REG, value));
+            }
+            emit(MachineInstr(MachineInstr::RET));
+            break;
+        case IRInstr::JUMP:
+            if (instr.targets[0] != nextBlock) {
+                emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, blockLabels[instr.targets[0]]));
+            }
+            break;
+        case IRInstr::BRANCH: {
+            int cond = valueReg(instr.operands[0]);
+            const BasicBlock* ifTrue = instr.targets[0];
+            const BasicBlock* ifFalse = instr.targets[1];
+            if (ifTrue == nextBlock) {
+                emit(MachineInstr(MachineInstr::BEQZ, NO_REG, cond, NO_REG, 0, blockLabels[ifFalse]));
+            } else {
+                emit(MachineInstr(MachineInstr::BNEZ, NO_REG, cond, NO_REG, 0, blockLabels[ifTrue]));
+                if (ifFalse != nextBlock) {
+                    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, blockLabels[ifFalse]));
+                }
+            }
+            break;
+        }
+        case IRInstr::PHI:
+            throw std::runtime_error("IR still contains phi in function '" + currentFunction + "'");
+        default:
+            selectBinary(instr);
+            break;
+    }
+}
+
+void RISCVCodeGenerator::emit(const char* directive) {
+    out->write(directive);
+    out->put('\n');
+}
+
+void RISCVCodeGenerator::emit(const MachineInstr& instr) {
+    machineFunction.append(instr);
+}
+
+void RISCVCodeGenerator::emitLabel(const std::string& label) {
+    machineFunction.append(MachineInstr(MachineInstr::LABEL, NO_REG, NO_REG, NO_REG, 0, label));
+}
+
+std::string RISCVCodeGenerator::newLabel(const std::string& prefix) {
+    return prefix + std::to_string(labelCounter++);
+}
+
+void RISCVCodeGenerator::pushValue(int reg) {
+    emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, -4));
+    emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, reg, 0));
+}
+
+int RISCVCodeGenerator::popValue(int scratch) {
+    emit(MachineInstr(MachineInstr::LW, scratch, REG_SP, NO_REG, 0));
+    emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, 4));
+    return scratch;
+}
+
+void RISCVCodeGenerator::dropValue() {
+    emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, 4));
+}
+
+void RISCVCodeGenerator::adjustStackPointer(int delta) {
+    if (delta >= -2048 && delta <= 2047) {
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, delta));
+    } else {
+        emit(MachineInstr(MachineInstr::LI, REG_T0, NO_REG, NO_REG, delta));
+        emit(MachineInstr(MachineInstr::ADD, REG_SP, REG_SP, REG_T0));
+    }
+}
+
+void RISCVCodeGenerator::generatePrologue(const std::string& funcName, int frameSize) {
+    emitLabel(funcName);
+    if (!machineFunction.usesFP) {
+        // 没有 fp 时栈帧不超过 2047 字节（见 rebaseOnSP），各项都直接相对 sp 保存
+        if (frameSize > 0) {
+            emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, -frameSize));
+        }
+        if (machineFunction.savesRA) {
+            emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_RA, frameSize - 4));
+        }
+        int offset = frameSize + machineFunction.spillSlotOffset(machineFunction.spillSlots - 1);
+        for (int reg : machineFunction.usedCalleeSaved) {
+            offset -= 4;
+            emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, reg, offset));
+        }
+        return;
+    }
+    if (frameSize <= 2047) {
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, -frameSize));
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_RA, frameSize - 4));
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_FP, frameSize - 8));
+        emit(MachineInstr(MachineInstr::ADDI, REG_FP, REG_SP, NO_REG, frameSize));
+    } else {
+        // 帧太大时先保存 ra/fp，再用寄存器调整 sp
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, -8));
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_RA, 4));
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_FP, 0));
+        emit(MachineInstr(MachineInstr::ADDI, REG_FP, REG_SP, NO_REG, 8));
+        adjustStackPointer(-(frameSize - 8));
+    }
+    
+    // 被调用者保存寄存器放在溢出槽之下
+    int offset = machineFunction.spillSlotOffset(machineFunction.spillSlots - 1);
+    for (int reg : machineFunction.usedCalleeSaved) {
+        offset -= 4;
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_FP, reg, offset));
+    }
+}
+
+// exit 为函数的出口指令：ret，或尾调用的 tail
+void RISCVCodeGenerator::generateEpilogue(int frameSize, const MachineInstr& exit) {
+    if (!machineFunction.usesFP) {
+        int offset = frameSize + machineFunction.spillSlotOffset(machineFunction.spillSlots - 1);
+        for (int reg : machineFunction.usedCalleeSaved) {
+            offset -= 4;
+            emit(MachineInstr(MachineInstr::LW, reg, REG_SP, NO_REG, offset));
+        }
+        if (machineFunction.savesRA) {
+            emit(MachineInstr(MachineInstr::LW, REG_RA, REG_SP, NO_REG, frameSize - 4));
+        }
+        if (frameSize > 0) {
+            emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, frameSize));
+        }
+        emit(exit);
+        return;
+    }
+    int offset = machineFunction.spillSlotOffset(machineFunction.spillSlots - 1);
+    for (int reg : machineFunction.usedCalleeSaved) {
+        offset -= 4;
+        emit(MachineInstr(MachineInstr::LW, reg, REG_FP, NO_REG, offset));
+    }
+    
+    if (frameSize <= 2047) {
+        emit(MachineInstr(MachineInstr::LW, REG_RA, REG_SP, NO_REG, frameSize - 4));
+        emit(MachineInstr(MachineInstr::LW, REG_FP, REG_SP, NO_REG, frameSize - 8));
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, frameSize));
+    } else {
+        emit(MachineInstr(MachineInstr::LW, REG_RA, REG_FP, NO_REG, -4));
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_FP, NO_REG, -8));
+        emit(MachineInstr(MachineInstr::LW, REG_FP, REG_SP, NO_REG, 0));
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, 8));
+    }
+    emit(exit);
+}
+
+// 不设置 fp 时，函数体中相对 fp（进入函数时的 sp，即 sp + frameSize）的访存改为相对 sp。
+// 有偏移超出 12 位立即数时不做改动，返回 false
+bool RISCVCodeGenerator::rebaseOnSP(std::vector<MachineInstr>& body, int frameSize) {
+    if (frameSize > 2047) return false;
+    for (const auto& instr : body) {
+        if ((instr.op == MachineInstr::LW || instr.op == MachineInstr::SW) && instr.rs1 == REG_FP &&
+            !fitsImm12(frameSize + instr.imm)) {
+            return false;
+        }
+    }
+    for (auto& instr : body) {
+        if ((instr.op == MachineInstr::LW || instr.op == MachineInstr::SW) && instr.rs1 == REG_FP) {
+            instr.rs1 = REG_SP;
+            instr.imm += frameSize;
+        }
+    }
+    return true;
+}
+
+// 栈帧太大、无法相对 sp 寻址时退回到保存 ra 和 fp 的标准栈帧：
+// 帧顶的保存区变大，溢出槽（函数体中相对 fp 的负偏移）随之整体下移
+void RISCVCodeGenerator::keepFramePointer(std::vector<MachineInstr>& body) {
+    int oldSaveArea = machineFunction.saveAreaSize();
+    machineFunction.savesRA = true;
+    machineFunction.usesFP = true;
+    int shift = machineFunction.saveAreaSize() - oldSaveArea;
+    for (auto& instr : body) {
+        if ((instr.op == MachineInstr::LW || instr.op == MachineInstr::SW) && instr.rs1 == REG_FP && instr.imm < 0) {
+            instr.imm -= shift;
+        }
+    }
+}
+
+// 函数体生成完毕后：寄存器分配（栈式代码不含虚拟寄存器，跳过）、确定栈帧，再补上序言和尾声
+void RISCVCodeGenerator::finishFunction(bool allocateRegisters) {
+    if (allocateRegisters) {
+        LinearScanAllocator allocator(machineFunction);
+        allocator.run();
+    }
+    
+    int frameSize = machineFunction.frameSize();
+    
+    std::vector<MachineInstr> body = std::move(machineFunction.instructions);
+    machineFunction.instructions.clear();
+    if (!machineFunction.usesFP && !rebaseOnSP(body, frameSize)) {
+        keepFramePointer(body);
+        frameSize = machineFunction.frameSize();
+    }
+    generatePrologue(machineFunction.name, frameSize);
+    for (const auto& instr : body) {
+        if (instr.op == MachineInstr::RET || instr.op == MachineInstr::TAIL) {
+            generateEpilogue(frameSize, instr);
+        } else {
+            emit(instr);
+        }
+    }
+    
+    if (optimizationsEnabled) {
+        peephole.run(machineFunction);
+    }
+    
+    // 写入输出端后即可丢弃：已完成的函数不在内存中累积，缓冲区写满时整块写出
+    for (const auto& instr : machineFunction.instructions) {
+        instr.print(*out);
+        out->put('\n');
+    }
+    machineFunction.instructions.clear();
+}
+
+// Visitor 方法实现
+void RISCVCodeGenerator::visit(UnaryExpression& node) {
+    node.operand->accept(*this);
+    int src = popValue(REG_T0);
+    int dst = src;
+    
+    switch (node.op) {
+        case UnaryExpression::PLUS:
+            // 正号不需要操作
+            break;
+        case UnaryExpression::MINUS:
+            dst = REG_T0;
+            emit(MachineInstr(MachineInstr::NEG, dst, src));
+            break;
+        case UnaryExpression::NOT:
+            dst = REG_T0;
+            emit(MachineInstr(MachineInstr::SEQZ, dst, src));
+            break;
+    }
+    
+    pushValue(dst);
+}
+
+void RISCVCodeGenerator::visit(NumberLiteral& node) {
+    int dst = REG_T0;
+    emit(MachineInstr(MachineInstr::LI, dst, NO_REG, NO_REG, node.value));
+    pushValue(dst);
+}
+
+void RISCVCodeGenerator::visit(Identifier& node) {
+    int dst = REG_T0;
+    // 查找变量在栈中的位置
+    const int* offset = localVariables.find(node.name);
+    if (offset) {
+        emit(MachineInstr(MachineInstr::LW, dst, REG_FP, NO_REG, *offset));
+    } else {
+        // 全局变量或未定义变量
+        int addr = REG_T0;
+        emit(MachineInstr(MachineInstr::LA, addr, NO_REG, NO_REG, 0, node.name.str()));
+        emit(MachineInstr(MachineInstr::LW, dst, addr, NO_REG, 0));
+    }
+    pushValue(dst);
+}
+
+void RISCVCodeGenerator::visit(FunctionCall& node) {
+    // 生成函数调用
+    for (const auto& arg : node.arguments) {
+        arg->accept(*this);
+    }
+    
+    int argCount = (int)node.arguments.size();
+    int regArgs = std::min(argCount, NUM_ARG_REGS);
+    int stackArgs = argCount - regArgs;
+    // 实参已按求值顺序压栈，第 i 个位于 (n-1-i)*4(sp)；
+    // 栈上的实参需要倒过来复制到新的栈顶，再把前 8 个装入 a0-a7
+    int argBase = 4 * stackArgs;
+    if (stackArgs > 0) {
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, -argBase));
+        for (int i = NUM_ARG_REGS; i < argCount; ++i) {
+            emit(MachineInstr(MachineInstr::LW, REG_T0, REG_SP, NO_REG, argBase + 4 * (argCount - 1 - i)));
+            emit(MachineInstr(MachineInstr::SW, NO_REG, REG_SP, REG_T0, 4 * (i - NUM_ARG_REGS)));
+        }
+    }
+    for (int i = 0; i < regArgs; ++i) {
+        emit(MachineInstr(MachineInstr::LW, REG_A0 + i, REG_SP, NO_REG, argBase + 4 * (argCount - 1 - i)));
+    }
+    emit(MachineInstr(MachineInstr::CALL, NO_REG, NO_REG, NO_REG, regArgs, node.functionName.str()));
+    if (argCount > 0) {
+        emit(MachineInstr(MachineInstr::ADDI, REG_SP, REG_SP, NO_REG, argBase + 4 * argCount));
+    }
+    pushValue(REG_A0);
+}
+
+void RISCVCodeGenerator::visit(AssignmentStatement& node) {
+    node.value->accept(*this);
+    int value = popValue(REG_T0);
+    
+    const int* offset = localVariables.find(node.variable);
+    if (offset) {
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_FP, value, *offset));
+    } else {
+        int addr = REG_T1;
+        emit(MachineInstr(MachineInstr::LA, addr, NO_REG, NO_REG, 0, node.variable.str()));
+        emit(MachineInstr(MachineInstr::SW, NO_REG, addr, value, 0));
+    }
+}
+
+void RISCVCodeGenerator::visit(VariableDeclaration& node) {
+    int value;
+    if (node.initializer) {
+        node.initializer->accept(*this);
+        value = popValue(REG_T0);
+    } else {
+        value = REG_T0;
+        emit(MachineInstr(MachineInstr::LI, value, NO_REG, NO_REG, 0));
+    }
+    
+    emit(MachineInstr(MachineInstr::SW, NO_REG, REG_FP, value, allocateSlot(node.name)));
+}
+
+// 为声明分配新的栈槽；同名的外层绑定记入 shadowedSlots，离开所在的块时恢复
+int RISCVCodeGenerator::allocateSlot(SymbolId name) {
+    const int* outer = localVariables.find(name);
+    shadowedSlots.emplace_back(name, outer ? *outer : 0);
+    stackOffset -= 4;
+    lowestOffset = std::min(lowestOffset, stackOffset);
+    localVariables[name] = stackOffset;
+    return stackOffset;
+}
+
+void RISCVCodeGenerator::visit(Block& node) {
+    size_t scopeStart = shadowedSlots.size();
+    int scopeOffset = stackOffset;
+    for (const auto& stmt : node.statements) {
+        stmt->accept(*this);
+    }
+    while (shadowedSlots.size() > scopeStart) {
+        auto [name, outer] = shadowedSlots.back();
+        shadowedSlots.pop_back();
+        if (outer != 0) {
+            localVariables[name] = outer;
+        } else {
+            localVariables.erase(name);
+        }
+    }
+    stackOffset = scopeOffset;
+}
+
+void RISCVCodeGenerator::visit(IfStatement& node) {
+    std::string elseLabel = newLabel("else");
+    std::string endLabel = newLabel("endif");
+    
+    node.condition->accept(*this);
+    int cond = popValue(REG_T0);
+    emit(MachineInstr(MachineInstr::BEQZ, NO_REG, cond, NO_REG, 0, elseLabel));
+    
+    node.thenStatement->accept(*this);
+    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, endLabel));
+    
+    emitLabel(elseLabel);
+    if (node.elseStatement) {
+        node.elseStatement->accept(*this);
+    }
+    
+    emitLabel(endLabel);
+}
+
+void RISCVCodeGenerator::visit(WhileStatement& node) {
+    std::string loopLabel = newLabel("loop");
+    std::string endLabel = newLabel("endloop");
+    
+    emitLabel(loopLabel);
+    node.condition->accept(*this);
+    int cond = popValue(REG_T0);
+    emit(MachineInstr(MachineInstr::BEQZ, NO_REG, cond, NO_REG, 0, endLabel));
+    
+    // continue 回到条件判断，break 跳出循环
+    breakLabels.push_back(endLabel);
+    continueLabels.push_back(loopLabel);
+    node.body->accept(*this);
+    breakLabels.pop_back();
+    continueLabels.pop_back();
+    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, loopLabel));
+    
+    emitLabel(endLabel);
+}
+
+void RISCVCodeGenerator::visit(BreakStatement& node) {
+    (void)node; // 避免未使用参数警告
+    // 语义分析保证 break 位于循环内
+    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, breakLabels.back()));
+}
+
+void RISCVCodeGenerator::visit(ContinueStatement& node) {
+    (void)node; // 避免未使用参数警告
+    emit(MachineInstr(MachineInstr::J, NO_REG, NO_REG, NO_REG, 0, continueLabels.back()));
+}
+
+void RISCVCodeGenerator::visit(ReturnStatement& node) {
+    if (node.value) {
+        node.value->accept(*this);
+        int value = popValue(REG_A0);
+        if (value != REG_A0) {
+            emit(MachineInstr(MachineInstr::MV, REG_A0, value));
+        }
+    } else {
+        emit(MachineInstr(MachineInstr::LI, REG_A0, NO_REG, NO_REG, 0));
+    }
+    
+    // RET 在 finishFunction 中展开为尾声
+    emit(MachineInstr(MachineInstr::RET));
+}
+
+void RISCVCodeGenerator::visit(ExpressionStatement& node) {
+    node.expression->accept(*this);
+    dropValue(); // 弹出表达式结果
+}
+
+void RISCVCodeGenerator::visit(FunctionDefinition& node) {
+    currentFunction = node.name.str();
+    localVariables.clear();
+    shadowedSlots.clear();
+    machineFunction = MachineFunction(currentFunction);
+    stackOffset = -8; // -4(fp)、-8(fp) 保存 ra、fp
+    lowestOffset = stackOffset;
+    
+    // 参数与局部变量一样分配栈槽：a0-a7 中的参数直接存入，其余从调用者栈帧底部复制
+    for (size_t i = 0; i < node.parameters.size(); ++i) {
+        int slot = allocateSlot(node.parameters[i].name);
+        int value = REG_A0 + (int)i;
+        if (i >= NUM_ARG_REGS) {
+            value = REG_T0;
+            emit(MachineInstr(MachineInstr::LW, value, REG_FP, NO_REG, 4 * (int)(i - NUM_ARG_REGS)));
+        }
+        emit(MachineInstr(MachineInstr::SW, NO_REG, REG_FP, value, slot));
+    }
+    
+    node.body->accept(*this);
+    emit(MachineInstr(MachineInstr::RET));
+    
+    // 计算局部变量空间
+    machineFunction.localSize = -8 - lowestOffset;
+    finishFunction(false);
+}
+
+void RISCVCodeGenerator::visit(CompilationUnit& node) {
+    for (const auto& func : node.functions) {
+        func->accept(*this);
+    }
+}
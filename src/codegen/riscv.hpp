@@ -1,60 +1,100 @@
-#pragma once
-#include "ast/ast.hpp"
-#include "common/types.hpp"
-#include <string>
-#include <unordered_map>
-#include <vector>
-
-class RISCVCodeGenerator : public Visitor {
-private:
-    std::string output;
-    std::unordered_map<std::string, int> localVariables;
-    std::unordered_map<std::string, FunctionInfo> functions;
-    int stackOffset;
-    int labelCounter;
-    std::string currentFunction;
-    
-    // 优化相关
-    bool optimizationsEnabled;
-    std::unordered_map<std::string, int> constantValues; // 常量传播
-    std::vector<std::string> deadCode; // 死代码消除
-    
-public:
-    RISCVCodeGenerator() : stackOffset(0), labelCounter(0), optimizationsEnabled(false) {}
-    
-    std::string generate(CompilationUnit& unit, const std::unordered_map<std::string, FunctionInfo>& funcTable);
-    
-    // 启用优化
-    void enableOptimizations() { optimizationsEnabled = true; }
-    
-    // Visitor接口
-    void visit(BinaryExpression& node) override;
-    void visit(UnaryExpression& node) override;
-    void visit(NumberLiteral& node) override;
-    void visit(Identifier& node) override;
-    void visit(FunctionCall& node) override;
-    void visit(AssignmentStatement& node) override;
-    void visit(VariableDeclaration& node) override;
-    void visit(Block& node) override;
-    void visit(IfStatement& node) override;
-    void visit(WhileStatement& node) override;
-    void visit(BreakStatement& node) override;
-    void visit(ContinueStatement& node) override;
-    void visit(ReturnStatement& node) override;
-    void visit(ExpressionStatement& node) override;
-    void visit(FunctionDefinition& node) override;
-    void visit(CompilationUnit& node) override;
-    
-private:
-    void emit(const std::string& instruction);
-    void emitLabel(const std::string& label);
-    std::string newLabel(const std::string& prefix = "L");
-    void generatePrologue(const std::string& funcName, int localSize);
-    void generateEpilogue();
-    
-    // 优化相关方法
-    void optimizeConstantFolding(BinaryExpression& node);
-    void optimizeDeadCodeElimination();
-    bool isConstantExpression(Expression* expr);
-    int evaluateConstantExpression(Expression* expr);
-};
\ No newline at end of file
+#pragma once
+#include "ast/ast.hpp"
+#include "common/types.hpp"
+#include "common/symbol.hpp"
+#include "common/output_sink.hpp"
+#include "codegen/machine.hpp"
+#include "codegen/peephole.hpp"
+#include "ir/ir.hpp"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RISCVCodeGenerator : public Visitor {
+private:
+    OutputSink* out;                   // 仅在 generate 期间有效
+    SymbolMap<int> localVariables;     // 变量 -> 栈槽偏移（相对 fp），按符号 ID 索引
+    const std::unordered_map<std::string, FunctionInfo>* functions;  // 仅在 generate 期间有效
+    int stackOffset;                   // 下一个栈槽之上的偏移，离开块时恢复，栈槽在兄弟块之间复用
+    int lowestOffset;                  // 本函数用到的最低栈槽偏移，决定 localSize
+    std::vector<std::pair<SymbolId, int>> shadowedSlots;  // 块内声明遮蔽的外层绑定（0 表示此前未绑定），离开块时恢复
+    std::vector<std::string> breakLabels;     // 各层循环 break 跳转的标签
+    std::vector<std::string> continueLabels;  // 各层循环 continue 跳转的标签
+    int labelCounter;
+    std::string currentFunction;
+    MachineFunction machineFunction;  // 当前正在生成的函数
+    std::unordered_map<const BasicBlock*, std::string> blockLabels;  // IR 基本块 -> 汇编标签
+    
+    // 优化相关
+    bool optimizationsEnabled;
+    PeepholeOptimizer peephole;
+    
+public:
+    RISCVCodeGenerator() : out(nullptr), functions(nullptr), stackOffset(0), lowestOffset(0), labelCounter(0), optimizationsEnabled(false) {}
+    
+    // 汇编写入 sink，每个函数生成完毕即写出；由调用者负责最后的 flush。
+    // 从 AST 直接生成的是栈式代码（-stack-machine，调试用）：表达式结果全部经由运行时栈传递，不做寄存器分配
+    void generate(CompilationUnit& unit, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink);
+    // 从三地址 IR 做指令选择（IR 变量直接对应虚拟寄存器）
+    void generate(IRModule& module, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink);
+    // 单独生成一个函数，结果只取决于该函数的 IR；整个模块的输出即段声明加上各函数依次生成的结果。
+    // 各函数可以用不同的生成器实例在不同线程上同时生成
+    void generate(IRFunction& function, const std::unordered_map<std::string, FunctionInfo>& funcTable, OutputSink& sink);
+    static void emitHeader(OutputSink& sink);
+    
+    // 启用优化
+    void enableOptimizations() { optimizationsEnabled = true; }
+    const PeepholeOptimizer& getPeephole() const { return peephole; }
+    
+    // Visitor接口
+    void visit(BinaryExpression& node) override;
+    void visit(UnaryExpression& node) override;
+    void visit(NumberLiteral& node) override;
+    void visit(Identifier& node) override;
+    void visit(FunctionCall& node) override;
+    void visit(AssignmentStatement& node) override;
+    void visit(VariableDeclaration& node) override;
+    void visit(Block& node) override;
+    void visit(IfStatement& node) override;
+    void visit(WhileStatement& node) override;
+    void visit(BreakStatement& node) override;
+    void visit(ContinueStatement& node) override;
+    void visit(ReturnStatement& node) override;
+    void visit(ExpressionStatement& node) override;
+    void visit(FunctionDefinition& node) override;
+    void visit(CompilationUnit& node) override;
+    
+private:
+    void emit(const char* directive);
+    void emit(const MachineInstr& instr);
+    void emitLabel(const std::string& label);
+    std::string newLabel(const std::string& prefix = "L");
+    void generatePrologue(const std::string& funcName, int frameSize);
+    void generateEpilogue(int frameSize, const MachineInstr& exit);
+    void adjustStackPointer(int delta);
+    bool rebaseOnSP(std::vector<MachineInstr>& body, int frameSize);
+    void keepFramePointer(std::vector<MachineInstr>& body);
+    void finishFunction(bool allocateRegisters);
+    
+    // IR 指令选择
+    void selectFunction(IRFunction& function);
+    void selectInstr(const IRInstr& instr, const BasicBlock* nextBlock);
+    void selectBinary(const IRInstr& instr);
+    bool selectMulByConstant(int dst, int lhs, int c);
+    bool selectDivByConstant(int dst, int lhs, int c);
+    bool selectModByConstant(int dst, int lhs, int c);
+    int roundTowardZero(int lhs, int k);
+    int selectCallArgs(const IRInstr& call);
+    bool isSiblingCall(const IRInstr& call, const IRInstr& ret) const;
+    void selectCompareBranch(const IRInstr& compare, const IRInstr& branch, const BasicBlock* nextBlock);
+    int valueReg(const IRValue& value);
+    int irVarReg(int var) const { return FIRST_VIRTUAL_REG + var; }
+    
+    // 栈式代码中表达式结果的传递：运行时的压栈/弹栈，popValue 把栈顶弹到 scratch 并返回它
+    void pushValue(int reg);
+    int popValue(int scratch);
+    void dropValue();
+    void generateShortCircuit(BinaryExpression& node);
+    int allocateSlot(SymbolId name);
+};
@@ -0,0 +1,76 @@
+#include "common/output_sink.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+
+OutputSink::OutputSink(int fd) : fd(fd), used(0), error(false) {}
+
+OutputSink::OutputSink() : fd(-1), used(0), error(false) {}
+
+OutputSink::~OutputSink() {
+    flush();
+}
+
+void OutputSink::writeInt(int value) {
+    // 32 位整数最多 11 个字符（含负号）
+    if (BUFFER_SIZE - used < 11) drain();
+    uint32_t magnitude = (uint32_t)value;
+    if (value < 0) {
+        buffer[used++] = '-';
+        magnitude = 0u - magnitude;
+    }
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (count > 0) {
+        buffer[used++] = digits[--count];
+    }
+}
+
+void OutputSink::drain() {
+    if (used == 0) return;
+    if (fd < 0) {
+        memory.append(buffer, used);
+        used = 0;
+        return;
+    }
+    const char* data = buffer;
+    size_t remaining = used;
+    while (remaining > 0 && !error) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            error = true;
+            break;
+        }
+        data += written;
+        remaining -= (size_t)written;
+    }
+    used = 0;
+}
+
+void OutputSink::writeSlow(const char* data, size_t length) {
+    // 先填满当前缓冲区再整块刷出，超过一个缓冲区的内容分多次写入
+    while (length > 0) {
+        size_t chunk = BUFFER_SIZE - used;
+        if (chunk > length) chunk = length;
+        std::memcpy(buffer + used, data, chunk);
+        used += chunk;
+        data += chunk;
+        length -= chunk;
+        if (used == BUFFER_SIZE) drain();
+    }
+}
+
+bool OutputSink::flush() {
+    drain();
+    return !error;
+}
+
+const std::string& OutputSink::str() {
+    drain();
+    return memory;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// 汇编输出的缓冲写出端：定长缓冲区写满或显式 flush 时整块写到文件描述符，
+// 不再先在内存里拼出整个汇编文件。整数直接格式化进缓冲区，不经过 std::to_string。
+// 默认构造时不绑定文件描述符，刷出的内容追加到内存中的字符串，供调试打印和测试使用。
+class OutputSink {
+public:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+    
+    // 写到 fd；不接管 fd 的所有权
+    explicit OutputSink(int fd);
+    // 写到内存，用 str() 取出
+    OutputSink();
+    ~OutputSink();
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    
+    void put(char c) {
+        if (used == BUFFER_SIZE) drain();
+        buffer[used++] = c;
+    }
+    void write(const char* data, size_t length) {
+        if (length > BUFFER_SIZE - used) {
+            writeSlow(data, length);
+            return;
+        }
+        std::memcpy(buffer + used, data, length);
+        used += length;
+    }
+    void write(const char* text) { write(text, std::strlen(text)); }
+    void write(const std::string& text) { write(text.data(), text.size()); }
+    void writeInt(int value);
+    
+    // 把缓冲区内容写出；返回此前所有写出是否都成功
+    bool flush();
+    bool failed() const { return error; }
+    
+    // 内存模式下已写入的全部内容
+    const std::string& str();
+    
+private:
+    int fd;
+    size_t used;
+    bool error;
+    std::string memory;
+    char buffer[BUFFER_SIZE];
+    
+    void drain();
+    void writeSlow(const char* data, size_t length);
+};
@@ -0,0 +1,122 @@
+#include "common/parallel.hpp"
+#include "common/time_report.hpp"
+#include <atomic>
+#include <memory>
+
+unsigned hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// parallelFor 的辅助线程。进程退出时析构，此前提交的任务都已结束或只剩空转
+static ThreadPool& helperPool() {
+    static ThreadPool pool(1);
+    return pool;
+}
+
+void parallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body) {
+    if (jobs == 0) jobs = hardwareThreads();
+    if (jobs > count) jobs = (unsigned)count;
+    if (jobs <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+    
+    // 提交给池的任务可能在本次调用返回之后才开始执行，所以共享状态由任务共同持有；
+    // 下标取完之后开始的任务不再访问 body
+    struct Shared {
+        const std::function<void(size_t)>* body;
+        size_t count;
+        std::atomic<size_t> next;
+        size_t finished;
+        uint64_t allocations;     // 辅助线程执行 body 时的堆分配，最后记到调用线程
+        uint64_t allocatedBytes;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto shared = std::make_shared<Shared>();
+    shared->body = &body;
+    shared->count = count;
+    shared->next = 0;
+    shared->finished = 0;
+    shared->allocations = 0;
+    shared->allocatedBytes = 0;
+    auto helper = [shared]() {
+        uint64_t allocations = heapAllocations();
+        uint64_t allocatedBytes = heapAllocatedBytes();
+        size_t ran = 0;
+        for (size_t i = shared->next++; i < shared->count; i = shared->next++) {
+            (*shared->body)(i);
+            ran++;
+        }
+        if (ran == 0) return;
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->allocations += heapAllocations() - allocations;
+        shared->allocatedBytes += heapAllocatedBytes() - allocatedBytes;
+        shared->finished += ran;
+        if (shared->finished == shared->count) shared->done.notify_all();
+    };
+    ThreadPool& pool = helperPool();
+    pool.reserve(jobs - 1);
+    for (unsigned i = 1; i < jobs; ++i) {
+        pool.submit(helper);
+    }
+    size_t ran = 0;
+    for (size_t i = shared->next++; i < count; i = shared->next++) {
+        body(i);
+        ran++;
+    }
+    // 只等待各下标执行完，不等待尚未开始的任务
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished += ran;
+    shared->done.wait(lock, [&]() { return shared->finished == shared->count; });
+    chargeHeapAllocations(shared->allocations, shared->allocatedBytes);
+}
+
+ThreadPool::ThreadPool(unsigned threads) : stopping(false) {
+    if (threads == 0) threads = hardwareThreads();
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    ready.notify_one();
+}
+
+void ThreadPool::reserve(unsigned threads) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (workers.size() < threads) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+void ThreadPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            // 停止时仍然先取完队列中的任务
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
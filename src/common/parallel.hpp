@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 用 jobs 个线程（含调用线程）执行 body(0) ... body(count - 1)，各下标按取用顺序动态分配给空闲线程，
+// 全部完成后返回。jobs 为 0 时取硬件线程数；jobs 为 1 或只有一项时直接在调用线程上顺序执行。
+// 其余线程取自进程内共享的 ThreadPool，不在每次调用时创建；调用线程自己也取下标，
+// 所以嵌套调用（例如 --batch 的单元内再并行各函数）时即使池中线程都在忙也能完成。
+// body 不得抛出异常。
+void parallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body);
+
+// std::thread::hardware_concurrency()，无法得知时为 1
+unsigned hardwareThreads();
+
+// 常驻的工作线程组：任务按提交顺序交给空闲线程执行。线程创建一次后一直复用（编译守护进程用它处理各连接）。
+// 析构时先执行完已经提交的任务再结束线程。任务不得抛出异常
+class ThreadPool {
+public:
+    // threads 为 0 时取硬件线程数
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    void submit(std::function<void()> task);
+    // 线程不足 threads 个时补足
+    void reserve(unsigned threads);
+    unsigned size() const { return (unsigned)workers.size(); }
+    
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping;
+    
+    void run();
+};
@@ -0,0 +1,46 @@
+#include "common/source_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<SourceFile> SourceFile::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open '" + path + "': " + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        error = "'" + path + "' is not a regular file";
+        ::close(fd);
+        return nullptr;
+    }
+    
+    // 先保留一段全零的匿名区，再把文件映射到它的开头：
+    // 文件末页的剩余部分由内核补零，长度恰为页的整数倍时结束标记落在后面的匿名页里
+    size_t size = (size_t)info.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (size + 2 + page - 1) / page * page;
+    void* base = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        error = "cannot map '" + path + "': " + std::strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+    if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        error = "cannot map '" + path + "': " + std::strerror(errno);
+        munmap(base, mappedSize);
+        ::close(fd);
+        return nullptr;
+    }
+    ::close(fd);
+    madvise(base, size, MADV_SEQUENTIAL);
+    return std::unique_ptr<SourceFile>(new SourceFile(path, static_cast<char*>(base), size, mappedSize));
+}
+
+SourceFile::~SourceFile() {
+    munmap(base, mappedSize);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// 以只读私有映射方式打开的源文件，供 Flex 的 yy_scan_buffer 原地扫描。
+// 映射区在文件内容之后保留两个 '\0'（yy_scan_buffer 要求的结束标记）；
+// Flex 扫描时会临时改写 yytext 之后的一个字节，私有映射只复制被写到的页，文件本身不受影响。
+class SourceFile {
+public:
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    
+    // 失败时返回 nullptr 并在 error 中给出原因
+    static std::unique_ptr<SourceFile> open(const std::string& path, std::string& error);
+    
+    const std::string& path() const { return filePath; }
+    // 含结尾两个 '\0' 的映射区，直接交给 yy_scan_buffer
+    char* buffer() const { return base; }
+    size_t bufferSize() const { return contentSize + 2; }
+    // 文件内容本身的长度
+    size_t size() const { return contentSize; }
+    
+private:
+    SourceFile(const std::string& path, char* base, size_t contentSize, size_t mappedSize)
+        : filePath(path), base(base), contentSize(contentSize), mappedSize(mappedSize) {}
+    
+    std::string filePath;
+    char* base;
+    size_t contentSize;
+    size_t mappedSize;
+};
@@ -0,0 +1,52 @@
+#include "common/symbol.hpp"
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// 驻留表：deque 追加元素时不移动已有字符串，索引的 string_view 和 str() 返回的引用一直有效
+struct SymbolStorage {
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    
+    SymbolStorage() { names.emplace_back(); }
+};
+
+static SymbolStorage& storage() {
+    static SymbolStorage instance;
+    return instance;
+}
+
+SymbolId SymbolId::intern(const char* text, size_t length) {
+    SymbolStorage& table = storage();
+    std::string_view key(text, length);
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(key);
+    if (it != table.ids.end()) return fromIndex(it->second);
+    
+    uint32_t id = (uint32_t)table.names.size();
+    table.names.emplace_back(text, length);
+    table.ids.emplace(table.names.back(), id);
+    return fromIndex(id);
+}
+
+size_t SymbolId::count() {
+    SymbolStorage& table = storage();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names.size() - 1;
+}
+
+void SymbolId::reset() {
+    SymbolStorage& table = storage();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.ids.clear();
+    table.names.clear();
+    table.names.emplace_back();
+}
+
+const std::string& SymbolId::str() const {
+    SymbolStorage& table = storage();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names[value];
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 驻留后的标识符：同名标识符共享同一个整数 ID，比较、哈希和查表都只用 ID。
+// 词法分析器遇到标识符时驻留一次，之后 AST、代码生成中的符号表都按 ID 索引。
+// 驻留表全局共享且线程安全，ID 从 1 开始连续分配，0 为空标识符。
+// 保持平凡类型以便放进 Bison 的 %union，默认构造不初始化，需由 intern 得到。
+class SymbolId {
+public:
+    SymbolId() = default;
+    
+    static SymbolId intern(const char* text, size_t length);
+    static SymbolId intern(const std::string& text) { return intern(text.data(), text.size()); }
+    static SymbolId none() { return fromIndex(0); }
+    static SymbolId fromIndex(uint32_t index) {
+        SymbolId symbol;
+        symbol.value = index;
+        return symbol;
+    }
+    // 已驻留的标识符个数（不含空标识符），即当前最大 ID
+    static size_t count();
+    // 清空驻留表，之后的 ID 重新从 1 分配。调用者须保证没有线程正在使用或仍然持有任何 SymbolId
+    // （编译守护进程在请求之间调用，见 driver/server.cpp）
+    static void reset();
+    
+    uint32_t index() const { return value; }
+    const std::string& str() const;
+    
+    bool operator==(SymbolId other) const { return value == other.value; }
+    bool operator!=(SymbolId other) const { return value != other.value; }
+    bool operator<(SymbolId other) const { return value < other.value; }
+    
+private:
+    uint32_t value;
+};
+
+inline std::ostream& operator<<(std::ostream& os, SymbolId symbol) {
+    return os << symbol.str();
+}
+
+template <>
+struct std::hash<SymbolId> {
+    size_t operator()(SymbolId symbol) const { return symbol.index(); }
+};
+
+// 以符号 ID 为下标的稠密表，查找不需要哈希，大小随写入过的最大 ID 增长；
+// 记录写入过的键，clear() 只重置这些位置，适合按函数反复清空的局部变量表
+template <typename T>
+class SymbolMap {
+public:
+    T* find(SymbolId key) {
+        uint32_t id = key.index();
+        return id < present.size() && present[id] ? &values[id] : nullptr;
+    }
+    const T* find(SymbolId key) const {
+        uint32_t id = key.index();
+        return id < present.size() && present[id] ? &values[id] : nullptr;
+    }
+    bool contains(SymbolId key) const { return find(key) != nullptr; }
+    
+    T& operator[](SymbolId key) {
+        uint32_t id = key.index();
+        if (id >= present.size()) {
+            // 按写入的 ID 成倍扩大，不按全局驻留表的大小：驻留表只增不减，
+            // 按它分配会让每个短命的表都付出迄今见过的全部标识符的代价
+            size_t size = std::max<size_t>(id + 1, present.size() * 2);
+            present.resize(size, false);
+            values.resize(size);
+        }
+        if (!present[id]) {
+            present[id] = true;
+            keys.push_back(id);
+        }
+        return values[id];
+    }
+    
+    void erase(SymbolId key) {
+        uint32_t id = key.index();
+        if (id < present.size() && present[id]) {
+            present[id] = false;
+            values[id] = T();
+        }
+    }
+    
+    void clear() {
+        for (uint32_t id : keys) {
+            present[id] = false;
+            values[id] = T();
+        }
+        keys.clear();
+    }
+    
+private:
+    std::vector<T> values;
+    std::vector<bool> present;
+    std::vector<uint32_t> keys;  // 写入过的 ID（可能含已删除的）
+};
@@ -0,0 +1,164 @@
+#include "common/time_report.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+// 全局 operator new 的替换版本只在打开计数后才更新计数器；
+// 关闭时每次分配只多一次只读的原子加载。计数器每个线程一份，
+// 同时编译的其他单元的分配不会计入本线程的阶段
+static std::atomic<bool> countingEnabled(false);
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t allocationBytes = 0;
+
+static void* allocate(size_t size) {
+    if (countingEnabled.load(std::memory_order_relaxed)) {
+        allocationCount++;
+        allocationBytes += size;
+    }
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+
+void enableAllocationCounting() {
+    countingEnabled.store(true, std::memory_order_relaxed);
+}
+
+uint64_t heapAllocations() {
+    return allocationCount;
+}
+
+uint64_t heapAllocatedBytes() {
+    return allocationBytes;
+}
+
+void chargeHeapAllocations(uint64_t allocations, uint64_t allocatedBytes) {
+    allocationCount += allocations;
+    allocationBytes += allocatedBytes;
+}
+
+uint64_t peakResidentBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (uint64_t)usage.ru_maxrss * 1024;  // Linux 上单位为 KB
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TimeReport::Phase::Phase(TimeReport* report, const char* name)
+    : report(report), name(name), start(std::chrono::steady_clock::now()),
+      allocations(heapAllocations()), allocatedBytes(heapAllocatedBytes()) {}
+
+TimeReport::Phase::~Phase() {
+    if (!report) return;
+    report->addPhase(name, secondsSince(start), heapAllocations() - allocations, heapAllocatedBytes() - allocatedBytes);
+}
+
+TimeReport::TimeReport() : start(std::chrono::steady_clock::now()) {
+    enableAllocationCounting();
+}
+
+void TimeReport::addPhase(const char* name, double seconds, uint64_t allocations, uint64_t allocatedBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& phase : phases) {
+        if (phase.name != name) continue;
+        phase.count++;
+        phase.seconds += seconds;
+        phase.allocations += allocations;
+        phase.allocatedBytes += allocatedBytes;
+        return;
+    }
+    phases.push_back(PhaseStats{name, 1, seconds, allocations, allocatedBytes});
+}
+
+void TimeReport::addCounter(const std::string& name, int64_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& counter : counters) {
+        if (counter.first == name) {
+            counter.second += value;
+            return;
+        }
+    }
+    counters.emplace_back(name, value);
+}
+
+void TimeReport::addPass(size_t position, const char* name, double seconds, bool changed, int64_t instructionsRemoved) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (passes.size() <= position) {
+        passes.resize(position + 1, PassStats{"", 0, 0, 0.0, 0});
+    }
+    PassStats& pass = passes[position];
+    pass.name = name;
+    pass.runs++;
+    pass.changed += changed;
+    pass.seconds += seconds;
+    pass.instructionsRemoved += instructionsRemoved;
+}
+
+// 名字都是程序内的常量，只需处理引号和反斜杠
+static void writeString(std::ostream& os, const std::string& text) {
+    os << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+
+static void writeSeconds(std::ostream& os, double seconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6f", seconds);
+    os << buffer;
+}
+
+void TimeReport::writeJSON(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    os << "{\n  \"total_seconds\": ";
+    writeSeconds(os, secondsSince(start));
+    os << ",\n  \"peak_rss_bytes\": " << peakResidentBytes();
+    os << ",\n  \"allocations\": " << heapAllocations();
+    os << ",\n  \"allocated_bytes\": " << heapAllocatedBytes();
+    
+    os << ",\n  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const PhaseStats& phase = phases[i];
+        os << (i ? ",\n" : "\n") << "    {\"name\": ";
+        writeString(os, phase.name);
+        os << ", \"count\": " << phase.count << ", \"seconds\": ";
+        writeSeconds(os, phase.seconds);
+        os << ", \"allocations\": " << phase.allocations << ", \"allocated_bytes\": " << phase.allocatedBytes << "}";
+    }
+    os << (phases.empty() ? "]" : "\n  ]");
+    
+    os << ",\n  \"passes\": [";
+    bool first = true;
+    for (const auto& pass : passes) {
+        if (pass.runs == 0) continue;
+        os << (first ? "\n" : ",\n") << "    {\"name\": ";
+        writeString(os, pass.name);
+        os << ", \"runs\": " << pass.runs << ", \"changed\": " << pass.changed << ", \"seconds\": ";
+        writeSeconds(os, pass.seconds);
+        os << ", \"instructions_removed\": " << pass.instructionsRemoved << "}";
+        first = false;
+    }
+    os << (first ? "]" : "\n  ]");
+    
+    os << ",\n  \"counters\": {";
+    for (size_t i = 0; i < counters.size(); ++i) {
+        os << (i ? ",\n" : "\n") << "    ";
+        writeString(os, counters[i].first);
+        os << ": " << counters[i].second;
+    }
+    os << (counters.empty() ? "}" : "\n  }") << "\n}\n";
+}
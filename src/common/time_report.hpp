@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// --time-report：各阶段的墙钟耗时与堆分配、各优化遍的统计和若干计数器，最后输出为一个 JSON 对象。
+// 同名阶段、同一流水线位置的优化遍多次记录时累加（批量模式下即各单元之和）。
+// 所有记录方法都加锁，并行优化各函数的线程可以同时记录
+class TimeReport {
+public:
+    // 计时区间：构造时开始，析构时把耗时和其间的堆分配累加到 report 的同名阶段。
+    // report 为空时什么都不做，调用处不必判断是否启用了 --time-report
+    class Phase {
+    public:
+        Phase(TimeReport* report, const char* name);
+        ~Phase();
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+        
+    private:
+        TimeReport* report;
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+    };
+    
+    // 开始计算总耗时，并打开堆分配计数
+    TimeReport();
+    
+    void addCounter(const std::string& name, int64_t value);
+    // 流水线第 position 个优化遍对一个函数运行一次的结果，instructionsRemoved 可以为负
+    void addPass(size_t position, const char* name, double seconds, bool changed, int64_t instructionsRemoved);
+    
+    void writeJSON(std::ostream& os) const;
+    
+private:
+    struct PhaseStats {
+        std::string name;
+        uint64_t count;
+        double seconds;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+    };
+    struct PassStats {
+        std::string name;
+        uint64_t runs;
+        uint64_t changed;
+        double seconds;
+        int64_t instructionsRemoved;
+    };
+    
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point start;
+    std::vector<PhaseStats> phases;      // 按第一次出现的顺序
+    std::vector<PassStats> passes;       // 按流水线位置
+    std::vector<std::pair<std::string, int64_t>> counters;
+    
+    void addPhase(const char* name, double seconds, uint64_t allocations, uint64_t allocatedBytes);
+};
+
+// 打开计数之后当前线程 operator new 的调用次数与请求的字节数（之前为 0）。
+// parallelFor 把其他线程替调用者完成的工作中的分配记到调用线程，所以一个阶段或一个批量单元
+// 的统计包括它派出的并行任务，不包括同时在其他线程上编译的单元。
+// 构造 TimeReport 时自动打开，基准测试也可以直接打开
+void enableAllocationCounting();
+uint64_t heapAllocations();
+uint64_t heapAllocatedBytes();
+// 把其他线程上的分配记到当前线程
+void chargeHeapAllocations(uint64_t allocations, uint64_t allocatedBytes);
+// 进程的峰值常驻内存（getrusage 的 ru_maxrss）
+uint64_t peakResidentBytes();
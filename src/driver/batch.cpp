@@ -0,0 +1,122 @@
+#include "driver/batch.hpp"
+#include "ast/arena.hpp"
+#include "ast/parse.hpp"
+#include "common/output_sink.hpp"
+#include "common/parallel.hpp"
+#include "common/source_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sstream>
+#include <unistd.h>
+#include <unordered_map>
+
+std::string batchOutputPath(const std::string& input, const std::string& outputDir) {
+    size_t nameStart = input.find_last_of('/');
+    nameStart = nameStart == std::string::npos ? 0 : nameStart + 1;
+    size_t dot = input.find_last_of('.');
+    size_t stemEnd = dot == std::string::npos || dot < nameStart ? input.size() : dot;
+    if (outputDir.empty()) {
+        return input.substr(0, stemEnd) + ".s";
+    }
+    std::string dir = outputDir;
+    if (dir.back() != '/') dir += '/';
+    return dir + input.substr(nameStart, stemEnd - nameStart) + ".s";
+}
+
+// 编译一个单元，诊断信息写入 log；失败时不留下输出文件
+static bool compileFile(const std::string& input, const std::string& output,
+                        const CompileOptions& options, std::ostream& log) {
+    std::string error;
+    std::unique_ptr<SourceFile> source;
+    {
+        TimeReport::Phase phase(options.timeReport, "read");
+        source = SourceFile::open(input, error);
+    }
+    if (!source) {
+        log << "Error: " << error << std::endl;
+        return false;
+    }
+    
+    std::unique_ptr<CompilationUnit> unit;
+    {
+        ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+        if (options.timeReport) options.timeReport->addCounter("input_bytes", (int64_t)source->size());
+        TimeReport::Phase phase(options.timeReport, "parse");
+        unit = parseBuffer(source->buffer(), source->bufferSize(), log);
+    }
+    source.reset();
+    if (!unit) {
+        log << "Error: Parsing failed" << std::endl;
+        return false;
+    }
+    if (options.timeReport) {
+        options.timeReport->addCounter("ast.arena_bytes", (int64_t)unit->arena->bytesUsed());
+        options.timeReport->addCounter("ast.arena_blocks", (int64_t)unit->arena->blockCount());
+    }
+    
+    int fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        log << "Error: cannot write '" << output << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    bool ok;
+    {
+        OutputSink sink(fd);
+        ok = compileUnit(*unit, options, sink, log);
+        if (ok && !sink.flush()) {
+            log << "Error: cannot write '" << output << "'" << std::endl;
+            ok = false;
+        }
+    }
+    if (::close(fd) != 0 && ok) {
+        log << "Error: cannot write '" << output << "'" << std::endl;
+        ok = false;
+    }
+    if (!ok) {
+        ::unlink(output.c_str());
+    }
+    return ok;
+}
+
+size_t compileBatch(const std::vector<std::string>& inputs, const std::string& outputDir,
+                    const CompileOptions& options, unsigned jobs, std::ostream& log) {
+    std::vector<std::string> outputs;
+    std::unordered_map<std::string, size_t> owners;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        outputs.push_back(batchOutputPath(inputs[i], outputDir));
+        auto inserted = owners.emplace(outputs[i], i);
+        if (!inserted.second) {
+            log << "Error: '" << inputs[inserted.first->second] << "' and '" << inputs[i]
+                << "' would both be written to '" << outputs[i] << "'" << std::endl;
+            return inputs.size();
+        }
+    }
+    
+    // 每个单元只写自己的那一项，不需要加锁
+    std::vector<std::string> logs(inputs.size());
+    std::vector<char> succeeded(inputs.size(), 0);
+    parallelFor(inputs.size(), jobs, [&](size_t i) {
+        std::ostringstream unitLog;
+        succeeded[i] = compileFile(inputs[i], outputs[i], options, unitLog);
+        logs[i] = unitLog.str();
+    });
+    
+    size_t failed = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (succeeded[i]) continue;
+        failed++;
+        log << inputs[i] << ":" << std::endl;
+        std::istringstream lines(logs[i]);
+        std::string line;
+        while (std::getline(lines, line)) {
+            // 失败单元的进度信息没有意义，只保留错误
+            if (line.rfind("[INFO]", 0) == 0) continue;
+            log << "  " << line << std::endl;
+        }
+    }
+    log << "[INFO] Batch: " << inputs.size() - failed << " of " << inputs.size() << " units compiled, "
+        << failed << " failed (" << (jobs == 0 ? hardwareThreads() : jobs) << " jobs)" << std::endl;
+    return failed;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "driver/compiler.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 批量模式：在一个进程内用 jobs 个线程编译多个翻译单元（jobs 为 0 时取硬件线程数），
+// 单元内部按 options.jobs 处理各函数（main 在批量模式下保持为 1，线程只用于单元之间）。
+// 输入 dir/foo.tc 的汇编写到 dir/foo.s；给出 outputDir 时写到 outputDir/foo.s。
+// 各单元的诊断信息先各自缓存，全部完成后按输入顺序只输出失败单元的信息，最后是汇总行。
+// 返回失败的单元个数
+size_t compileBatch(const std::vector<std::string>& inputs, const std::string& outputDir,
+                    const CompileOptions& options, unsigned jobs, std::ostream& log);
+
+// 输入路径对应的输出路径（扩展名换成 .s）
+std::string batchOutputPath(const std::string& input, const std::string& outputDir);
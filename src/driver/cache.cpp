@@ -0,0 +1,243 @@
+#include "driver/cache.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+static const char* const ENTRY_MAGIC = "toyc-function-cache 1";
+
+// 128 位内容摘要：两路互相独立的 64 位散列，只用于区分缓存条目，不需要抗碰撞攻击
+class Digest {
+public:
+    Digest() : first(14695981039346656037ull), second(0x9e3779b97f4a7c15ull) {}
+    
+    void add(const char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            uint8_t byte = (uint8_t)data[i];
+            first = (first ^ byte) * 1099511628211ull;
+            second = (second + byte + 1) * 0xff51afd7ed558ccdull;
+            second ^= second >> 29;
+        }
+    }
+    void add(const std::string& text) {
+        add(text.data(), text.size());
+        // 长度作为分隔，相邻字段的拼接方式不同时摘要也不同
+        uint64_t length = text.size();
+        add(reinterpret_cast<const char*>(&length), sizeof(length));
+    }
+    
+    std::string hex() const {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", (unsigned long long)first, (unsigned long long)second);
+        return buffer;
+    }
+    
+private:
+    uint64_t first;
+    uint64_t second;
+};
+
+// 编译器可执行文件的摘要，进程内只计算一次。读不到时退回到本文件的编译时间
+static const std::string& compilerFingerprint() {
+    static const std::string fingerprint = []() {
+        Digest digest;
+        std::ifstream self("/proc/self/exe", std::ios::binary);
+        if (!self) {
+            digest.add(std::string(__DATE__ " " __TIME__));
+            return digest.hex();
+        }
+        char buffer[64 * 1024];
+        while (self.read(buffer, sizeof(buffer)) || self.gcount() > 0) {
+            digest.add(buffer, (size_t)self.gcount());
+        }
+        return digest.hex();
+    }();
+    return fingerprint;
+}
+
+// 函数的规范化记号序列：前序遍历，每个节点一个标记字符，名字带长度前缀，
+// 不同的树得到不同的序列；同时收集直接调用的函数
+class FunctionTokens : public ASTVisitor<FunctionTokens> {
+public:
+    std::string text;
+    std::set<std::string> callees;
+    
+    void visit(BinaryExpression& node) {
+        tag('b', node.op);
+        dispatch(*node.left);
+        dispatch(*node.right);
+    }
+    void visit(UnaryExpression& node) {
+        tag('u', node.op);
+        dispatch(*node.operand);
+    }
+    void visit(NumberLiteral& node) { tag('n', node.value); }
+    void visit(Identifier& node) {
+        tag('i', 0);
+        name(node.name);
+    }
+    void visit(FunctionCall& node) {
+        tag('c', (int)node.arguments.size());
+        name(node.functionName);
+        callees.insert(node.functionName.str());
+        for (auto& arg : node.arguments) dispatch(*arg);
+    }
+    void visit(AssignmentStatement& node) {
+        tag('=', 0);
+        name(node.variable);
+        dispatch(*node.value);
+    }
+    void visit(VariableDeclaration& node) {
+        tag('d', node.initializer != nullptr);
+        name(node.name);
+        if (node.initializer) dispatch(*node.initializer);
+    }
+    void visit(Block& node) {
+        tag('{', (int)node.statements.size());
+        for (auto& stmt : node.statements) dispatch(*stmt);
+    }
+    void visit(IfStatement& node) {
+        tag('?', node.elseStatement != nullptr);
+        dispatch(*node.condition);
+        dispatch(*node.thenStatement);
+        if (node.elseStatement) dispatch(*node.elseStatement);
+    }
+    void visit(WhileStatement& node) {
+        tag('w', 0);
+        dispatch(*node.condition);
+        dispatch(*node.body);
+    }
+    void visit(BreakStatement&) { tag('k', 0); }
+    void visit(ContinueStatement&) { tag('t', 0); }
+    void visit(ReturnStatement& node) {
+        tag('r', node.value != nullptr);
+        if (node.value) dispatch(*node.value);
+    }
+    void visit(ExpressionStatement& node) {
+        tag('e', 0);
+        dispatch(*node.expression);
+    }
+    void visit(FunctionDefinition& node) {
+        tag('f', node.returnType);
+        name(node.name);
+        text += std::to_string(node.parameters.size());
+        for (const auto& param : node.parameters) {
+            tag('p', param.type);
+            name(param.name);
+        }
+        dispatch(*node.body);
+    }
+    void visit(CompilationUnit&) {}
+    
+private:
+    void tag(char kind, int value) {
+        text += kind;
+        text += std::to_string(value);
+        text += ' ';
+    }
+    void name(SymbolId symbol) {
+        const std::string& str = symbol.str();
+        text += std::to_string(str.size());
+        text += ':';
+        text += str;
+    }
+};
+
+std::vector<std::string> FunctionCache::functionKeys(CompilationUnit& unit, const CompileOptions& options) {
+    size_t count = unit.functions.size();
+    std::vector<FunctionTokens> tokens(count);
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t i = 0; i < count; ++i) {
+        tokens[i].dispatch(*unit.functions[i]);
+        byName[unit.functions[i]->name.str()] = i;
+    }
+    
+    std::ostringstream common;
+    common << compilerFingerprint() << " opt=" << options.optimize << " inline=" << options.inlineThreshold;
+    bool inlining = options.optimize && options.inlineThreshold != 0;
+    
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i) {
+        Digest digest;
+        digest.add(common.str());
+        digest.add(tokens[i].text);
+        for (const auto& callee : tokens[i].callees) {
+            auto it = byName.find(callee);
+            if (it == byName.end()) {
+                digest.add("?" + callee);
+                continue;
+            }
+            const FunctionDefinition& def = *unit.functions[it->second];
+            digest.add(callee + "/" + std::to_string(def.parameters.size()) + "/" + std::to_string(def.returnType));
+        }
+        if (inlining) {
+            // 传递调用到的函数，按名字排序
+            std::set<std::string> reached;
+            std::vector<std::string> worklist(tokens[i].callees.begin(), tokens[i].callees.end());
+            while (!worklist.empty()) {
+                std::string callee = worklist.back();
+                worklist.pop_back();
+                auto it = byName.find(callee);
+                if (it == byName.end() || !reached.insert(callee).second) continue;
+                worklist.insert(worklist.end(), tokens[it->second].callees.begin(), tokens[it->second].callees.end());
+            }
+            for (const auto& callee : reached) {
+                digest.add(tokens[byName[callee]].text);
+            }
+        }
+        keys.push_back(digest.hex());
+    }
+    return keys;
+}
+
+FunctionCache::FunctionCache(const std::string& directory) : directory(directory) {
+    mkdir(directory.c_str(), 0755);
+}
+
+bool FunctionCache::load(const std::string& key, Entry& entry) const {
+    std::ifstream in(entryPath(key), std::ios::binary);
+    if (!in) return false;
+    std::string line;
+    if (!std::getline(in, line) || line != ENTRY_MAGIC) return false;
+    size_t callCount;
+    if (!std::getline(in, line) || std::sscanf(line.c_str(), "calls %zu", &callCount) != 1) return false;
+    entry.calls.clear();
+    for (size_t i = 0; i < callCount; ++i) {
+        if (!std::getline(in, line)) return false;
+        entry.calls.push_back(line);
+    }
+    entry.assembly.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+bool FunctionCache::store(const std::string& key, const Entry& entry) const {
+    std::string path = entryPath(key);
+    std::ostringstream suffix;
+    suffix << ".tmp" << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string temporary = path + suffix.str();
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << ENTRY_MAGIC << "\n" << "calls " << entry.calls.size() << "\n";
+        for (const auto& call : entry.calls) {
+            out << call << "\n";
+        }
+        out << entry.assembly;
+        if (!out.flush()) {
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
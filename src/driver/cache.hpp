@@ -0,0 +1,36 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "driver/compiler.hpp"
+#include <string>
+#include <vector>
+
+// 增量编译缓存：每个函数生成的汇编按缓存键存放在目录下，一个函数一个文件。
+// 缓存键是以下内容的摘要：
+//   - 编译器可执行文件本身的摘要（编译器一变，全部失效）和影响代码生成的选项；
+//   - 函数的记号序列（与空白、注释无关）；
+//   - 它直接调用的函数的签名；
+//   - 启用内联时，它传递调用到的全部函数的记号序列，因为这些函数体可能被内联进来。
+// 条目同时记录生成代码中仍然存在的调用，-opt 删除不可达函数时据此沿调用图确定要输出哪些函数。
+// 写入先落到临时文件再改名，多个线程或进程可以共用一个缓存目录。
+class FunctionCache {
+public:
+    struct Entry {
+        std::vector<std::string> calls;  // 生成代码中（内联之后）剩下的被调函数
+        std::string assembly;
+    };
+    
+    // 目录不存在时创建（只创建最后一级）
+    explicit FunctionCache(const std::string& directory);
+    
+    // 按源代码顺序给出 unit 中每个函数的缓存键；须在语义分析之后、AST 常量折叠之前调用
+    static std::vector<std::string> functionKeys(CompilationUnit& unit, const CompileOptions& options);
+    
+    bool load(const std::string& key, Entry& entry) const;
+    // 写入失败（如目录不可写）时只是不缓存，返回 false
+    bool store(const std::string& key, const Entry& entry) const;
+    
+private:
+    std::string directory;
+    
+    std::string entryPath(const std::string& key) const { return directory + "/" + key + ".fn"; }
+};
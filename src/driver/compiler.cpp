@@ -0,0 +1,430 @@
+#include "driver/compiler.hpp"
+#include "driver/cache.hpp"
+#include "ast/arena.hpp"
+#include "common/types.hpp"
+#include "semantic/analyzer.hpp"
+#include "codegen/riscv.hpp"
+#include "ir/lowering.hpp"
+#include "opt/passes.hpp"
+#include "opt/constant_folder.hpp"
+#include "common/parallel.hpp"
+#include "common/time_report.hpp"
+#include <exception>
+#include <functional>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+// 内联与优化之后仍然留在函数中的调用
+static std::vector<std::string> remainingCalls(const IRFunction& function) {
+    std::set<std::string> callees;
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block->instructions) {
+            if (instr.op == IRInstr::CALL) callees.insert(instr.callee);
+        }
+    }
+    return std::vector<std::string>(callees.begin(), callees.end());
+}
+
+// 用 jobs 个线程执行 body(0) ... body(count - 1)。parallelFor 的任务不得抛出异常，
+// 所以各任务的异常先记下，全部完成后重新抛出下标最小的一个
+static void forEachFunction(size_t count, unsigned jobs, const std::function<void(size_t)>& body) {
+    std::vector<std::exception_ptr> failures(count);
+    parallelFor(count, jobs, [&](size_t i) {
+        try {
+            body(i);
+        } catch (...) {
+            failures[i] = std::current_exception();
+        }
+    });
+    for (auto& failure : failures) {
+        if (failure) std::rethrow_exception(failure);
+    }
+}
+
+// 内联之后各函数的优化互不相关，每个任务使用自己的优化流水线
+static void optimizeFunctions(const std::vector<IRFunction*>& functions, const CompileOptions& options) {
+    TimeReport::Phase phase(options.timeReport, "optimize");
+    forEachFunction(functions.size(), options.jobs, [&](size_t i) {
+        PassManager passManager;
+        passManager.addDefaultPipeline();
+        passManager.setTimeReport(options.timeReport);
+        passManager.run(*functions[i]);
+    });
+}
+
+// 指令选择、寄存器分配与窥孔优化：每个任务使用自己的代码生成器（标签本来就按函数划分命名空间），
+// 函数 i 的汇编放在 assembly[i]，由调用者按源代码顺序拼接。窥孔统计合并进 peephole
+static std::vector<std::string> generateFunctions(const std::vector<IRFunction*>& functions, const CompileOptions& options,
+                                                  const std::unordered_map<std::string, FunctionInfo>& functionTable,
+                                                  PeepholeOptimizer& peephole) {
+    TimeReport::Phase phase(options.timeReport, "codegen");
+    std::vector<std::string> assembly(functions.size());
+    std::vector<PeepholeOptimizer> stats(functions.size());
+    forEachFunction(functions.size(), options.jobs, [&](size_t i) {
+        RISCVCodeGenerator generator;
+        if (options.optimize) {
+            generator.enableOptimizations();
+        }
+        OutputSink buffer;
+        generator.generate(*functions[i], functionTable, buffer);
+        assembly[i] = buffer.str();
+        stats[i] = generator.getPeephole();
+    });
+    for (const auto& stat : stats) {
+        peephole.merge(stat);
+    }
+    return assembly;
+}
+
+// 带缓存的 IR 路径：命中缓存的函数直接重放汇编，只有未命中的函数执行优化遍和代码生成。
+// 内联需要全部函数体，所以仍然为整个单元构建 IR 并在模块范围内联。
+// 结果与不带缓存的路径逐字节相同
+static void generateCached(CompilationUnit& unit, IRModule& module, const std::vector<std::string>& keys,
+                           const CompileOptions& options,
+                           const std::unordered_map<std::string, FunctionInfo>& functionTable,
+                           OutputSink& sink, PeepholeOptimizer& peephole, std::ostream& log) {
+    FunctionCache cache(options.cacheDir);
+    std::unordered_map<std::string, std::string> keyOf;
+    for (size_t i = 0; i < unit.functions.size(); ++i) {
+        keyOf[unit.functions[i]->name.str()] = keys[i];
+    }
+    
+    PassManager passManager;
+    if (options.optimize) {
+        passManager.addDefaultPipeline();
+        if (options.inlineThreshold >= 0) {
+            passManager.setInlineThreshold(options.inlineThreshold);
+        }
+        TimeReport::Phase phase(options.timeReport, "inline");
+        passManager.runInliner(module);
+    }
+    
+    // 以下各数组都按 module.functions 的下标索引，每个任务只写自己的那一项
+    std::vector<IRFunction*> functions;
+    std::unordered_map<std::string, size_t> indexOf;
+    for (auto& function : module.functions) {
+        indexOf[function->name] = functions.size();
+        functions.push_back(function.get());
+    }
+    size_t count = functions.size();
+    std::vector<FunctionCache::Entry> entries(count);
+    std::vector<char> cached(count, 0);
+    {
+        TimeReport::Phase phase(options.timeReport, "cache-load");
+        forEachFunction(count, options.jobs, [&](size_t i) {
+            cached[i] = cache.load(keyOf.at(functions[i]->name), entries[i]);
+        });
+    }
+    
+    std::vector<char> emitted(count, 0);
+    if (options.optimize) {
+        std::vector<IRFunction*> misses;
+        std::vector<size_t> missIndex;
+        for (size_t i = 0; i < count; ++i) {
+            if (cached[i]) continue;
+            misses.push_back(functions[i]);
+            missIndex.push_back(i);
+        }
+        optimizeFunctions(misses, options);
+        for (size_t j = 0; j < misses.size(); ++j) {
+            entries[missIndex[j]].calls = remainingCalls(*misses[j]);
+        }
+        log << "[INFO] Inlined " << passManager.getInlinedCalls() << " call sites" << std::endl;
+        if (options.timeReport) options.timeReport->addCounter("inliner.inlined_calls", passManager.getInlinedCalls());
+        
+        // 与 PassManager::removeUnreachableFunctions 相同：只输出从 main 出发仍然调用得到的函数
+        std::vector<size_t> worklist;
+        if (indexOf.count("main")) {
+            worklist.push_back(indexOf["main"]);
+            emitted[indexOf["main"]] = 1;
+        } else {
+            emitted.assign(count, 1);
+        }
+        while (!worklist.empty()) {
+            size_t index = worklist.back();
+            worklist.pop_back();
+            for (const auto& callee : entries[index].calls) {
+                auto it = indexOf.find(callee);
+                if (it != indexOf.end() && !emitted[it->second]) {
+                    emitted[it->second] = 1;
+                    worklist.push_back(it->second);
+                }
+            }
+        }
+    } else {
+        emitted.assign(count, 1);
+    }
+    
+    std::vector<IRFunction*> work;
+    std::vector<size_t> workIndex;
+    for (size_t i = 0; i < count; ++i) {
+        if (!emitted[i] || cached[i]) continue;
+        work.push_back(functions[i]);
+        workIndex.push_back(i);
+    }
+    std::vector<std::string> assembly = generateFunctions(work, options, functionTable, peephole);
+    {
+        TimeReport::Phase phase(options.timeReport, "cache-store");
+        forEachFunction(work.size(), options.jobs, [&](size_t j) {
+            FunctionCache::Entry& entry = entries[workIndex[j]];
+            entry.assembly = std::move(assembly[j]);
+            if (!options.optimize) entry.calls = remainingCalls(*work[j]);
+            cache.store(keyOf.at(work[j]->name), entry);
+        });
+    }
+    
+    size_t reused = 0;
+    RISCVCodeGenerator::emitHeader(sink);
+    for (size_t i = 0; i < count; ++i) {
+        if (!emitted[i]) continue;
+        if (cached[i]) reused++;
+        sink.write(entries[i].assembly);
+    }
+    log << "[INFO] Cache: " << reused << " functions reused, " << work.size() << " compiled" << std::endl;
+    if (options.timeReport) {
+        options.timeReport->addCounter("cache.reused", (int64_t)reused);
+        options.timeReport->addCounter("cache.compiled", (int64_t)work.size());
+    }
+}
+
+static void reportSemanticErrors(const SemanticAnalyzer& analyzer, std::ostream& log) {
+    log << "Semantic analysis failed:" << std::endl;
+    const auto& errors = analyzer.getErrors();
+    for (size_t i = 0; i < errors.size(); ++i) {
+        log << "  Error " << (i+1) << ": " << errors[i] << std::endl;
+    }
+}
+
+static void reportPeephole(const PeepholeOptimizer& peephole, TimeReport* report, std::ostream& log) {
+    log << "[INFO] Peephole: " << peephole.report() << std::endl;
+    if (report) {
+        for (int i = 0; i < PeepholeOptimizer::NUM_PATTERNS; ++i) {
+            PeepholeOptimizer::Pattern pattern = (PeepholeOptimizer::Pattern)i;
+            report->addCounter(std::string("peephole.") + PeepholeOptimizer::patternName(pattern), peephole.hits(pattern));
+        }
+    }
+}
+
+static FunctionInfo functionInfo(const FunctionDefinition& func) {
+    std::vector<Expression::Type> paramTypes;
+    for (const auto& param : func.parameters) {
+        paramTypes.push_back(param.type);
+    }
+    return FunctionInfo(func.name.str(), func.returnType, paramTypes, true);
+}
+
+static bool compileChecked(CompilationUnit& unit, const CompileOptions& options, OutputSink& sink, std::ostream& log) {
+    // 1. 语义分析
+    log << "[INFO] Performing semantic analysis..." << std::endl;
+    
+    TimeReport* report = options.timeReport;
+    if (report) report->addCounter("functions", (int64_t)unit.functions.size());
+    
+    SemanticAnalyzer analyzer;
+    bool analyzed;
+    {
+        TimeReport::Phase phase(report, "semantic");
+        analyzed = analyzer.analyze(unit, options.jobs);
+    }
+    if (!analyzed) {
+        reportSemanticErrors(analyzer, log);
+        return false;
+    }
+    
+    log << "[INFO] Semantic analysis completed successfully" << std::endl;
+    
+    // 缓存键基于源代码，在 AST 常量折叠改写之前计算；调试输出不经过缓存
+    bool useCache = !options.cacheDir.empty() && !options.stackMachine && !options.emitIR;
+    std::vector<std::string> cacheKeys;
+    if (useCache) {
+        TimeReport::Phase phase(report, "cache-keys");
+        cacheKeys = FunctionCache::functionKeys(unit, options);
+    }
+    
+    // AST 级常量折叠，在两条后端路径之前完成
+    if (options.optimize) {
+        ConstantFolder folder;
+        {
+            TimeReport::Phase phase(report, "constant-fold");
+            folder.run(unit);
+        }
+        log << "[INFO] Constant folding simplified " << folder.getFoldCount() << " expressions" << std::endl;
+        if (report) report->addCounter("constant_folder.folded", folder.getFoldCount());
+    }
+    
+    // 2. 代码生成
+    log << "[INFO] Generating code..." << std::endl;
+    
+    // 构建函数表
+    std::unordered_map<std::string, FunctionInfo> functionTable;
+    for (const auto& func : unit.functions) {
+        functionTable[func->name.str()] = functionInfo(*func);
+    }
+    
+    PeepholeOptimizer peephole;  // 各函数的窥孔统计之和
+    if (options.stackMachine) {
+        // 栈式模式保留直接从 AST 生成代码的路径（调试用，顺序生成）
+        RISCVCodeGenerator generator;
+        if (options.optimize) {
+            generator.enableOptimizations();
+        }
+        TimeReport::Phase phase(report, "codegen");
+        generator.generate(unit, functionTable, sink);
+        peephole.merge(generator.getPeephole());
+    } else {
+        // AST -> 三地址 IR -> 优化 -> 指令选择。
+        // 内联之后各函数的优化和代码生成按 options.jobs 并行，结果按源代码顺序拼接
+        std::unique_ptr<IRModule> module;
+        {
+            TimeReport::Phase phase(report, "lowering");
+            IRBuilder builder;
+            module = builder.build(unit);
+        }
+        if (useCache) {
+            generateCached(unit, *module, cacheKeys, options, functionTable, sink, peephole, log);
+        } else {
+            if (options.optimize) {
+                // 与 PassManager::run(IRModule&) 相同，只是各函数的优化并行执行
+                PassManager passManager;
+                passManager.addDefaultPipeline();
+                if (options.inlineThreshold >= 0) {
+                    passManager.setInlineThreshold(options.inlineThreshold);
+                }
+                {
+                    TimeReport::Phase phase(report, "inline");
+                    passManager.runInliner(*module);
+                }
+                std::vector<IRFunction*> functions;
+                for (auto& function : module->functions) functions.push_back(function.get());
+                optimizeFunctions(functions, options);
+                PassManager::removeUnreachableFunctions(*module);
+                log << "[INFO] Inlined " << passManager.getInlinedCalls() << " call sites" << std::endl;
+                if (report) report->addCounter("inliner.inlined_calls", passManager.getInlinedCalls());
+            }
+            if (options.emitIR) {
+                std::ostringstream ir;
+                module->print(ir);
+                sink.write(ir.str());
+            } else {
+                std::vector<IRFunction*> functions;
+                for (auto& function : module->functions) functions.push_back(function.get());
+                RISCVCodeGenerator::emitHeader(sink);
+                for (const auto& assembly : generateFunctions(functions, options, functionTable, peephole)) {
+                    sink.write(assembly);
+                }
+            }
+        }
+    }
+    
+    log << "[INFO] Code generation completed" << std::endl;
+    if (options.optimize) {
+        reportPeephole(peephole, report, log);
+    }
+    return true;
+}
+
+bool compileUnit(CompilationUnit& unit, const CompileOptions& options, OutputSink& sink, std::ostream& log) {
+    try {
+        return compileChecked(unit, options, sink, log);
+    } catch (const std::exception& e) {
+        log << "Error: " << e.what() << std::endl;
+    } catch (...) {
+        log << "Error: Unknown error occurred" << std::endl;
+    }
+    return false;
+}
+
+StreamingCompiler::StreamingCompiler(const CompileOptions& options, OutputSink& sink, std::ostream& log)
+    : options(options), sink(sink), log(log), analyzer(std::make_unique<SemanticAnalyzer>()),
+      builder(std::make_unique<IRBuilder>()), peephole(std::make_unique<PeepholeOptimizer>()), functionCount(0), foldCount(0), hasFailed(false) {
+    log << "[INFO] Streaming compilation: each function is emitted as soon as it is parsed" << std::endl;
+    if (!options.emitIR) {
+        RISCVCodeGenerator::emitHeader(sink);
+    }
+}
+
+StreamingCompiler::~StreamingCompiler() {}
+
+bool StreamingCompiler::compileFunction(std::unique_ptr<FunctionDefinition> function) {
+    try {
+        if (compileChecked(std::move(function))) {
+            return true;
+        }
+    } catch (const std::exception& e) {
+        log << "Error: " << e.what() << std::endl;
+    } catch (...) {
+        log << "Error: Unknown error occurred" << std::endl;
+    }
+    hasFailed = true;
+    return false;
+}
+
+bool StreamingCompiler::compileChecked(std::unique_ptr<FunctionDefinition> function) {
+    TimeReport* report = options.timeReport;
+    functionCount++;
+    
+    bool analyzed;
+    {
+        TimeReport::Phase phase(report, "semantic");
+        analyzed = analyzer->analyzeFunction(*function);
+    }
+    if (!analyzed) {
+        reportSemanticErrors(*analyzer, log);
+        return false;
+    }
+    
+    if (options.optimize) {
+        ConstantFolder folder;
+        TimeReport::Phase phase(report, "constant-fold");
+        folder.run(*function);
+        foldCount += folder.getFoldCount();
+    }
+    functionTable[function->name.str()] = functionInfo(*function);
+    
+    std::unique_ptr<IRModule> module;
+    {
+        TimeReport::Phase phase(report, "lowering");
+        module = builder->build(*function);
+    }
+    // IR 不再引用 AST：释放这个函数的节点，分配区的内存块随之归还
+    function.reset();
+    if (ASTArena* arena = ASTArena::active()) {
+        arena->reset();
+    }
+    
+    std::vector<IRFunction*> functions;
+    for (auto& irFunction : module->functions) functions.push_back(irFunction.get());
+    if (options.optimize) {
+        optimizeFunctions(functions, options);
+    }
+    if (options.emitIR) {
+        std::ostringstream ir;
+        module->print(ir);
+        sink.write(ir.str());
+    } else {
+        for (const auto& assembly : generateFunctions(functions, options, functionTable, *peephole)) {
+            sink.write(assembly);
+        }
+    }
+    return true;
+}
+
+bool StreamingCompiler::finish() {
+    if (!analyzer->finish()) {
+        reportSemanticErrors(*analyzer, log);
+        return false;
+    }
+    
+    TimeReport* report = options.timeReport;
+    log << "[INFO] Streamed " << functionCount << " functions" << std::endl;
+    if (report) report->addCounter("functions", (int64_t)functionCount);
+    if (options.optimize) {
+        log << "[INFO] Constant folding simplified " << foldCount << " expressions" << std::endl;
+        if (report) report->addCounter("constant_folder.folded", foldCount);
+        reportPeephole(*peephole, report, log);
+    }
+    return true;
+}
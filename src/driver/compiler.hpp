@@ -0,0 +1,65 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "common/output_sink.hpp"
+#include "common/time_report.hpp"
+#include "common/types.hpp"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+class IRBuilder;
+class PeepholeOptimizer;
+class SemanticAnalyzer;
+
+// 命令行选项中影响单个翻译单元编译结果的部分
+struct CompileOptions {
+    bool optimize;
+    bool stackMachine;    // 关闭寄存器分配（调试）
+    bool emitIR;          // 输出三地址 IR 而不是汇编（调试）
+    int inlineThreshold;  // -1 表示使用默认阈值
+    std::string cacheDir; // 非空时启用按函数的增量编译缓存（见 FunctionCache）
+    unsigned jobs;        // 各函数的语义分析、优化与代码生成使用的线程数，0 表示全部硬件线程
+    TimeReport* timeReport;  // 非空时记录各阶段耗时与统计（--time-report），不影响生成的代码
+    
+    CompileOptions() : optimize(false), stackMachine(false), emitIR(false), inlineThreshold(-1), jobs(1), timeReport(nullptr) {}
+};
+
+// 语法分析之后的全部阶段：语义分析、优化与代码生成，结果写入 sink（不 flush）。
+// [INFO] 进度和错误信息写入 log；不向外抛出异常，失败时返回 false。
+// 只使用参数和局部状态，不同线程可以同时编译不同的单元。
+// 输出与 options.jobs 无关：各函数并行生成后按源代码顺序拼接
+bool compileUnit(CompilationUnit& unit, const CompileOptions& options, OutputSink& sink, std::ostream& log);
+
+// 流式编译（--stream）：语法分析每归约出一个函数，就立即完成它的语义分析、优化和代码生成并写出汇编，
+// 随后释放它的 AST，峰值内存与最大的函数而不是整个文件成正比。
+// 函数必须先定义后调用；-opt 时只做函数内的优化，不做内联，也不删除不可达的函数。
+// 不支持栈式模式和缓存。与 compileUnit 一样不向外抛出异常
+class StreamingCompiler {
+public:
+    StreamingCompiler(const CompileOptions& options, OutputSink& sink, std::ostream& log);
+    ~StreamingCompiler();
+    
+    // 作为 parseBuffer / parseStream 的 FunctionHandler。调用时当前线程的 ASTArena 中只能有这个函数的节点，
+    // 编译后连同函数一起释放。失败时返回 false 以中止语法分析
+    bool compileFunction(std::unique_ptr<FunctionDefinition> function);
+    // 输入结束后调用：检查 main 并输出统计
+    bool finish();
+    // 语法分析因 compileFunction 失败而中止（错误已经写入 log）
+    bool failed() const { return hasFailed; }
+    
+private:
+    const CompileOptions& options;
+    OutputSink& sink;
+    std::ostream& log;
+    std::unique_ptr<SemanticAnalyzer> analyzer;
+    std::unique_ptr<IRBuilder> builder;  // 跨函数复用，按符号 ID 索引的表不必每个函数重新分配
+    std::unique_ptr<PeepholeOptimizer> peephole;
+    std::unordered_map<std::string, FunctionInfo> functionTable;
+    size_t functionCount;
+    int foldCount;
+    bool hasFailed;
+    
+    bool compileChecked(std::unique_ptr<FunctionDefinition> function);
+    void reportErrors();
+};
@@ -0,0 +1,517 @@
+#include "driver/server.hpp"
+#include "ast/arena.hpp"
+#include "ast/parse.hpp"
+#include "common/output_sink.hpp"
+#include "common/parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <shared_mutex>
+#include <sstream>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// 单个字段的上限，防止格式错误的长度让守护进程分配过多内存
+static const size_t MAX_FIELD_SIZE = 64 * 1024 * 1024;
+// 内存中响应缓存的容量（键与响应内容的总字节数）
+static const size_t RESPONSE_CACHE_BYTES = 64 * 1024 * 1024;
+// 读写一个请求时，对方停顿超过这么久就关闭连接，慢速客户端不能一直占着工作线程
+static const int REQUEST_TIMEOUT_SECONDS = 10;
+// 空闲（两个请求之间）超过这么久的连接被关闭
+static const int IDLE_TIMEOUT_SECONDS = 300;
+// 驻留表超过这么多标识符时，在没有请求正在编译的时刻清空它
+static const size_t INTERNER_RESET_SYMBOLS = 1 << 16;
+
+// 在套接字上按字段读写，读取带缓冲
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd), start(0), end(0) {}
+    
+    // 读一个字段；连接已经关闭或长度格式错误时返回 false
+    bool readField(std::string& field) {
+        size_t length = 0;
+        int digits = 0;
+        for (;;) {
+            int c = readByte();
+            if (c < 0) return false;
+            if (c == '\n') break;
+            if (c < '0' || c > '9' || ++digits > 10) return false;
+            length = length * 10 + (size_t)(c - '0');
+        }
+        if (digits == 0 || length > MAX_FIELD_SIZE) return false;
+        field.resize(length);
+        size_t filled = std::min(length, end - start);
+        std::memcpy(&field[0], buffer + start, filled);
+        start += filled;
+        while (filled < length) {
+            ssize_t got = ::read(fd, &field[filled], length - filled);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            filled += (size_t)got;
+        }
+        return true;
+    }
+    
+    // 缓冲区中还有未处理的数据（对方连续发送了多个请求）
+    bool buffered() const { return start < end; }
+    
+    bool writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            // MSG_NOSIGNAL：对方已经关闭时返回 EPIPE 而不是产生 SIGPIPE
+            ssize_t count = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) return false;
+            written += (size_t)count;
+        }
+        return true;
+    }
+    
+private:
+    int fd;
+    char buffer[4096];
+    size_t start;
+    size_t end;
+    
+    int readByte() {
+        if (start == end) {
+            ssize_t got;
+            do {
+                got = ::read(fd, buffer, sizeof(buffer));
+            } while (got < 0 && errno == EINTR);
+            if (got <= 0) return -1;
+            start = 0;
+            end = (size_t)got;
+        }
+        return (unsigned char)buffer[start++];
+    }
+};
+
+static void appendField(std::string& out, const std::string& field) {
+    out += std::to_string(field.size());
+    out += '\n';
+    out += field;
+}
+
+// 请求中的选项，写法与命令行相同
+static bool applyFlags(const std::string& flags, CompileOptions& options, std::string& error) {
+    std::istringstream words(flags);
+    std::string flag;
+    while (words >> flag) {
+        if (flag == "-opt") {
+            options.optimize = true;
+        } else if (flag == "-stack-machine") {
+            options.stackMachine = true;
+        } else if (flag == "-emit-ir") {
+            options.emitIR = true;
+        } else if (flag.rfind("-inline-threshold=", 0) == 0) {
+            try {
+                options.inlineThreshold = std::stoi(flag.substr(18));
+            } catch (const std::exception&) {
+                options.inlineThreshold = -1;
+            }
+            if (options.inlineThreshold < 0) {
+                error = "Invalid inline threshold: " + flag;
+                return false;
+            }
+        } else {
+            error = "Unsupported option in request: " + flag;
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按请求内容（规范化的选项和源代码）保存最近的响应，超出容量时丢弃最久未用的
+class ResponseCache {
+public:
+    explicit ResponseCache(size_t capacity) : capacity(capacity), bytes(0) {}
+    
+    bool lookup(const std::string& key, ServerResponse& response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end()) return false;
+        entries.splice(entries.begin(), entries, found->second);
+        response = found->second->response;
+        return true;
+    }
+    
+    void store(std::string key, const ServerResponse& response) {
+        size_t size = entrySize(key, response);
+        if (size > capacity) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index.count(key)) return;  // 另一个线程同时编译了同样的请求
+        entries.push_front(Entry{std::move(key), response});
+        index.emplace(entries.front().key, entries.begin());
+        bytes += size;
+        while (bytes > capacity) {
+            Entry& oldest = entries.back();
+            bytes -= entrySize(oldest.key, oldest.response);
+            index.erase(oldest.key);
+            entries.pop_back();
+        }
+    }
+    
+private:
+    struct Entry {
+        std::string key;
+        ServerResponse response;
+    };
+    
+    std::mutex mutex;
+    size_t capacity;
+    size_t bytes;
+    std::list<Entry> entries;  // 最近使用的在前；list 节点不移动，index 的 string_view 一直有效
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    
+    static size_t entrySize(const std::string& key, const ServerResponse& response) {
+        return key.size() + response.output.size() + response.diagnostics.size();
+    }
+};
+
+// 守护进程的共享状态
+struct ServerState {
+    CompileOptions defaults;
+    ResponseCache responses;
+    std::atomic<size_t> requests;
+    std::atomic<size_t> cacheHits;
+    // 尚未关闭的连接。空闲的连接由主循环一起 poll；有请求到达时交给一个工作线程处理一个请求，
+    // 处理完放进 idle，并写 wakePipe 让主循环重新等待它。stopping 之后工作线程直接关闭连接
+    std::mutex connectionsMutex;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<int> idle;
+    bool stopping;
+    int wakePipe[2];
+    // 编译请求持有共享锁；清空驻留表需要独占，保证此时没有线程在用 SymbolId
+    std::shared_mutex interner;
+    
+    explicit ServerState(const CompileOptions& defaults)
+        : defaults(defaults), responses(RESPONSE_CACHE_BYTES), requests(0), cacheHits(0), stopping(false),
+          wakePipe{-1, -1} {}
+};
+
+// 每个工作线程的分配区，请求之间清空后复用，不必重新申请内存块
+static thread_local std::shared_ptr<ASTArena> warmArena;
+
+static ServerResponse compileRequest(const CompileOptions& options, std::string& source) {
+    ServerResponse response;
+    std::ostringstream log;
+    // parseBuffer 要求缓冲区以两个 '\0' 结尾
+    source.append(2, '\0');
+    if (!warmArena) warmArena = std::make_shared<ASTArena>();
+    
+    std::unique_ptr<CompilationUnit> unit;
+    {
+        ASTArena::Scope arenaScope(warmArena);
+        unit = parseBuffer(&source[0], source.size(), log);
+    }
+    if (!unit) {
+        log << "Error: Parsing failed" << std::endl;
+    } else {
+        OutputSink sink;
+        if (compileUnit(*unit, options, sink, log)) {
+            response.status = 0;
+            response.output = sink.str();
+        }
+        unit.reset();
+    }
+    // 节点都已随 unit 销毁；仍有别处持有时（不应发生）换一个新的分配区
+    if (warmArena.use_count() == 1) {
+        warmArena->reset();
+    } else {
+        warmArena = std::make_shared<ASTArena>();
+    }
+    response.diagnostics = log.str();
+    return response;
+}
+
+static bool serveRequest(Connection& connection, ServerState& state) {
+    std::string flags;
+    std::string source;
+    if (!connection.readField(flags) || !connection.readField(source)) return false;
+    state.requests++;
+    
+    ServerResponse response;
+    CompileOptions options = state.defaults;
+    std::string error;
+    if (!applyFlags(flags, options, error)) {
+        response.diagnostics = "Error: " + error + "\n";
+    } else {
+        std::string key = std::to_string(options.optimize) + std::to_string(options.stackMachine) +
+                          std::to_string(options.emitIR) + std::to_string(options.inlineThreshold) + '\n' + source;
+        if (state.responses.lookup(key, response)) {
+            state.cacheHits++;
+        } else {
+            try {
+                std::shared_lock<std::shared_mutex> lock(state.interner);
+                response = compileRequest(options, source);
+            } catch (const std::exception& e) {
+                response = ServerResponse();
+                response.diagnostics = std::string("Error: ") + e.what() + "\n";
+            }
+            state.responses.store(std::move(key), response);
+            // 驻留表只增不减，长期运行时不断出现的新名字会让它越来越大；请求之间没有 SymbolId 存留，
+            // 所以在没有其他请求正在编译时清空。有请求在编译时 try_lock 失败，留给之后的请求
+            if (SymbolId::count() > INTERNER_RESET_SYMBOLS && state.interner.try_lock()) {
+                SymbolId::reset();
+                state.interner.unlock();
+            }
+        }
+    }
+    
+    std::string reply;
+    appendField(reply, std::to_string(response.status));
+    appendField(reply, response.output);
+    appendField(reply, response.diagnostics);
+    return connection.writeAll(reply);
+}
+
+static void closeConnection(int fd, ServerState& state) {
+    {
+        std::lock_guard<std::mutex> lock(state.connectionsMutex);
+        state.connections.erase(fd);
+    }
+    ::close(fd);
+}
+
+// 处理 fd 上已经到达的请求（对方连续发送的也一并处理），之后把连接交还主循环
+static void serveReady(int fd, ServerState& state) {
+    Connection* connection;
+    {
+        std::lock_guard<std::mutex> lock(state.connectionsMutex);
+        connection = state.connections.at(fd).get();
+    }
+    bool open = serveRequest(*connection, state);
+    while (open && connection->buffered()) {
+        open = serveRequest(*connection, state);
+    }
+    if (open) {
+        std::lock_guard<std::mutex> lock(state.connectionsMutex);
+        if (!state.stopping) {
+            state.idle.push_back(fd);
+            char byte = 0;
+            (void)::write(state.wakePipe[1], &byte, 1);
+            return;
+        }
+    }
+    closeConnection(fd, state);
+}
+
+// SIGINT / SIGTERM 通过管道通知主循环，避免在检查标志和进入 poll 之间错过信号
+static int stopPipe[2] = {-1, -1};
+
+static void requestStop(int) {
+    int saved = errno;
+    char byte = 0;
+    (void)::write(stopPipe[1], &byte, 1);
+    errno = saved;
+}
+
+static bool fillAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "invalid socket path '" + path + "'";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 路径上的套接字文件是之前没有正常退出的守护进程留下的（没有进程在监听）时删除它
+static bool removeStaleSocket(const std::string& path, const sockaddr_un& address) {
+    struct stat info;
+    if (::lstat(path.c_str(), &info) != 0 || !S_ISSOCK(info.st_mode)) return false;
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) return false;
+    bool stale = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 && errno == ECONNREFUSED;
+    ::close(probe);
+    return stale && ::unlink(path.c_str()) == 0;
+}
+
+static int listenOn(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    if (!fillAddress(path, address, error)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+    sockaddr* raw = reinterpret_cast<sockaddr*>(&address);
+    bool bound = ::bind(fd, raw, sizeof(address)) == 0;
+    if (!bound && errno == EADDRINUSE) {
+        if (!removeStaleSocket(path, address)) {
+            error = "'" + path + "' is in use";
+            ::close(fd);
+            return -1;
+        }
+        bound = ::bind(fd, raw, sizeof(address)) == 0;
+    }
+    if (!bound || ::listen(fd, 64) != 0) {
+        error = "cannot listen on '" + path + "': " + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int runServer(const std::string& socketPath, const CompileOptions& defaults, unsigned jobs, std::ostream& log) {
+    std::string error;
+    int listenFd = listenOn(socketPath, error);
+    if (listenFd < 0) {
+        log << "Error: " << error << std::endl;
+        return 1;
+    }
+    if (::pipe2(stopPipe, O_CLOEXEC) != 0) {
+        log << "Error: pipe: " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+        return 1;
+    }
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    
+    ServerState state(defaults);
+    // 线程用于各连接之间，单个请求内部顺序编译
+    state.defaults.jobs = 1;
+    state.defaults.timeReport = nullptr;
+    if (::pipe2(state.wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        log << "Error: pipe: " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+        return 1;
+    }
+    {
+        ThreadPool pool(jobs);
+        log << "[INFO] Listening on " << socketPath << " (" << pool.size() << " threads)" << std::endl;
+        // 主循环等待的空闲连接及其开始空闲的时刻
+        std::vector<std::pair<int, std::chrono::steady_clock::time_point>> waiting;
+        std::vector<pollfd> watched;
+        for (;;) {
+            auto now = std::chrono::steady_clock::now();
+            auto idleLimit = std::chrono::seconds(IDLE_TIMEOUT_SECONDS);
+            int timeout = -1;
+            watched.assign({{listenFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}, {state.wakePipe[0], POLLIN, 0}});
+            for (const auto& [fd, since] : waiting) {
+                watched.push_back({fd, POLLIN, 0});
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(since + idleLimit - now).count();
+                if (timeout < 0 || left < timeout) timeout = (int)std::max<int64_t>(left, 0);
+            }
+            if (::poll(watched.data(), watched.size(), timeout) < 0) {
+                if (errno == EINTR) continue;
+                log << "Error: poll: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            if (watched[1].revents != 0) break;
+            now = std::chrono::steady_clock::now();
+            
+            // 有请求到达（或对方已关闭）的连接交给工作线程，空闲太久的关闭
+            std::vector<std::pair<int, std::chrono::steady_clock::time_point>> still;
+            for (size_t i = 0; i < waiting.size(); ++i) {
+                int fd = waiting[i].first;
+                if (watched[i + 3].revents != 0) {
+                    pool.submit([fd, &state]() { serveReady(fd, state); });
+                } else if (now - waiting[i].second >= idleLimit) {
+                    closeConnection(fd, state);
+                } else {
+                    still.push_back(waiting[i]);
+                }
+            }
+            waiting.swap(still);
+            
+            if (watched[2].revents != 0) {
+                char bytes[256];
+                while (::read(state.wakePipe[0], bytes, sizeof(bytes)) > 0) {
+                }
+                std::lock_guard<std::mutex> lock(state.connectionsMutex);
+                for (int fd : state.idle) waiting.emplace_back(fd, now);
+                state.idle.clear();
+            }
+            
+            if (watched[0].revents == 0) continue;
+            int client = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN) continue;
+                log << "Error: accept: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            timeval limit = {REQUEST_TIMEOUT_SECONDS, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+            ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+            {
+                std::lock_guard<std::mutex> lock(state.connectionsMutex);
+                state.connections.emplace(client, std::make_unique<Connection>(client));
+            }
+            waiting.emplace_back(client, now);
+        }
+        
+        // 不再接受新连接，关闭空闲的连接；正在处理的请求照常完成并写回响应，之后连接读到结束
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+        std::lock_guard<std::mutex> lock(state.connectionsMutex);
+        state.stopping = true;
+        for (const auto& entry : waiting) state.idle.push_back(entry.first);
+        for (int fd : state.idle) {
+            state.connections.erase(fd);
+            ::close(fd);
+        }
+        state.idle.clear();
+        for (const auto& entry : state.connections) {
+            ::shutdown(entry.first, SHUT_RD);
+        }
+    }
+    
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    ::close(stopPipe[0]);
+    ::close(stopPipe[1]);
+    ::close(state.wakePipe[0]);
+    ::close(state.wakePipe[1]);
+    log << "[INFO] Server stopped: " << state.requests.load() << " requests, " << state.cacheHits.load()
+        << " answered from the response cache" << std::endl;
+    return 0;
+}
+
+bool requestCompile(const std::string& socketPath, const std::string& flags, const std::string& source,
+                    ServerResponse& response, std::string& error) {
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address, error)) return false;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error = "cannot connect to '" + socketPath + "': " + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    
+    std::string request;
+    appendField(request, flags);
+    appendField(request, source);
+    Connection connection(fd);
+    std::string status;
+    bool ok = connection.writeAll(request) && connection.readField(status) && connection.readField(response.output) &&
+              connection.readField(response.diagnostics);
+    ::close(fd);
+    if (!ok) {
+        error = "no valid response from '" + socketPath + "'";
+        return false;
+    }
+    response.status = status == "0" ? 0 : 1;
+    return true;
+}
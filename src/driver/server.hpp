@@ -0,0 +1,34 @@
+#pragma once
+#include "driver/compiler.hpp"
+#include <ostream>
+#include <string>
+
+// 编译守护进程（--server）：在 Unix 域套接字上接受编译请求，省去每次启动进程的开销。
+// 进程内的状态在请求之间复用：工作线程（ThreadPool）常驻，每个线程保留一个清空后再用的 ASTArena，
+// 标识符驻留表是进程全局的，已经驻留的名字不再分配（超过一定大小时趁没有请求在编译时清空）；
+// defaults.cacheDir 非空时各请求共用这个函数缓存。
+// 另外在内存中按请求内容保存最近的响应，完全相同的请求直接返回，不再编译。
+//
+// 协议：请求和响应都由若干字段组成，每个字段是十进制字节数、一个换行符和相应个数的字节。
+//   请求：选项（空格分隔，只接受 -opt、-inline-threshold=N、-stack-machine、-emit-ir）、源代码；
+//   响应：状态（"0" 成功，"1" 失败）、输出的汇编（或 -emit-ir 的 IR）、诊断信息（命令行编译时写到 stderr 的内容）。
+// 一个连接上可以依次发送多个请求，对方关闭连接时结束。空闲的连接由接受连接的线程一起等待，
+// 不占用工作线程；请求到达后才交给工作线程，处理完再交还。读写一个请求的中途停顿超过 10 秒、
+// 或连接空闲超过 5 分钟时关闭连接。格式错误的请求得不到响应，连接直接关闭。
+
+struct ServerResponse {
+    int status;
+    std::string output;
+    std::string diagnostics;
+    
+    ServerResponse() : status(1) {}
+};
+
+// 在 socketPath 上监听，直到收到 SIGINT 或 SIGTERM；退出前删除套接字文件。
+// jobs 为工作线程数（0 表示硬件线程数），每个请求内部不再并行。启动失败时返回 1
+int runServer(const std::string& socketPath, const CompileOptions& defaults, unsigned jobs, std::ostream& log);
+
+// 客户端（--connect）：把一个请求发送给 socketPath 上的守护进程并等待响应。
+// 连接或通信失败时返回 false，原因写入 error
+bool requestCompile(const std::string& socketPath, const std::string& flags, const std::string& source,
+                    ServerResponse& response, std::string& error);
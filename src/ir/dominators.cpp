@@ -0,0 +1,101 @@
+#include "ir/dominators.hpp"
+#include <algorithm>
+
+DominatorTree::DominatorTree(IRFunction& function) {
+    // 非递归 DFS 求后序
+    std::vector<BasicBlock*> postOrder;
+    std::unordered_map<const BasicBlock*, bool> visited;
+    std::vector<std::pair<BasicBlock*, size_t>> stack = {{function.entry(), 0}};
+    visited[function.entry()] = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < block->succs.size()) {
+            BasicBlock* succ = block->succs[next++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+            }
+        } else {
+            postOrder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(postOrder.rbegin(), postOrder.rend());
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        order[rpo[i]] = (int)i;
+    }
+    
+    int n = (int)rpo.size();
+    idoms.assign(n, -1);
+    idoms[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < n; ++i) {
+            int newIdom = -1;
+            for (BasicBlock* pred : rpo[i]->preds) {
+                auto it = order.find(pred);
+                if (it == order.end() || idoms[it->second] < 0) continue;
+                newIdom = newIdom < 0 ? it->second : intersect(it->second, newIdom);
+            }
+            if (newIdom != idoms[i]) {
+                idoms[i] = newIdom;
+                changed = true;
+            }
+        }
+    }
+    
+    childLists.assign(n, {});
+    for (int i = 1; i < n; ++i) {
+        childLists[idoms[i]].push_back(rpo[i]);
+    }
+    
+    // 汇合点的每个前驱沿支配树上行，直到汇合点的直接支配者
+    frontiers.assign(n, {});
+    for (int i = 0; i < n; ++i) {
+        if (rpo[i]->preds.size() < 2) continue;
+        for (BasicBlock* pred : rpo[i]->preds) {
+            auto it = order.find(pred);
+            if (it == order.end()) continue;
+            int runner = it->second;
+            while (runner != idoms[i]) {
+                auto& df = frontiers[runner];
+                if (std::find(df.begin(), df.end(), rpo[i]) == df.end()) {
+                    df.push_back(rpo[i]);
+                }
+                if (runner == 0) break;
+                runner = idoms[runner];
+            }
+        }
+    }
+}
+
+int DominatorTree::intersect(int a, int b) const {
+    while (a != b) {
+        while (a > b) a = idoms[a];
+        while (b > a) b = idoms[b];
+    }
+    return a;
+}
+
+BasicBlock* DominatorTree::idom(const BasicBlock* block) const {
+    int i = order.at(block);
+    return i == 0 ? nullptr : rpo[idoms[i]];
+}
+
+const std::vector<BasicBlock*>& DominatorTree::children(const BasicBlock* block) const {
+    return childLists[order.at(block)];
+}
+
+const std::vector<BasicBlock*>& DominatorTree::frontier(const BasicBlock* block) const {
+    return frontiers[order.at(block)];
+}
+
+bool DominatorTree::dominates(const BasicBlock* a, const BasicBlock* b) const {
+    int target = order.at(a);
+    int i = order.at(b);
+    while (i > target) {
+        i = idoms[i];
+    }
+    return i == target;
+}
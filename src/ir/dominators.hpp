@@ -0,0 +1,28 @@
+#pragma once
+#include "ir/ir.hpp"
+#include <unordered_map>
+#include <vector>
+
+// 支配树与支配边界（Cooper, Harvey & Kennedy 的迭代算法）
+// 只覆盖从入口可达的块；CFG 改动后需要重新计算
+class DominatorTree {
+public:
+    explicit DominatorTree(IRFunction& function);
+    
+    BasicBlock* idom(const BasicBlock* block) const;
+    const std::vector<BasicBlock*>& children(const BasicBlock* block) const;
+    const std::vector<BasicBlock*>& frontier(const BasicBlock* block) const;
+    bool dominates(const BasicBlock* a, const BasicBlock* b) const;
+    
+    // 逆后序，入口在最前
+    const std::vector<BasicBlock*>& reversePostOrder() const { return rpo; }
+    
+private:
+    std::vector<BasicBlock*> rpo;
+    std::unordered_map<const BasicBlock*, int> order;  // 块 -> 逆后序编号
+    std::vector<int> idoms;                            // 按逆后序编号
+    std::vector<std::vector<BasicBlock*>> childLists;
+    std::vector<std::vector<BasicBlock*>> frontiers;
+    
+    int intersect(int a, int b) const;
+};
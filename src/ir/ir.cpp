@@ -0,0 +1,176 @@
+#include "ir/ir.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+
+void IRFunction::rebuildCFG() {
+    for (auto& block : blocks) {
+        block->preds.clear();
+        block->succs.clear();
+    }
+    for (auto& block : blocks) {
+        if (!block->hasTerminator()) continue;
+        for (BasicBlock* target : block->terminator().targets) {
+            if (std::find(block->succs.begin(), block->succs.end(), target) == block->succs.end()) {
+                block->succs.push_back(target);
+                target->preds.push_back(block.get());
+            }
+        }
+    }
+    
+    for (auto& block : blocks) {
+        for (auto& instr : block->instructions) {
+            if (!instr.isPhi()) break;
+            for (size_t i = instr.targets.size(); i-- > 0;) {
+                if (std::find(block->preds.begin(), block->preds.end(), instr.targets[i]) == block->preds.end()) {
+                    instr.targets.erase(instr.targets.begin() + i);
+                    instr.operands.erase(instr.operands.begin() + i);
+                }
+            }
+        }
+    }
+}
+
+BasicBlock* IRFunction::newBlockAfter(const BasicBlock* after) {
+    auto pos = std::find_if(blocks.begin(), blocks.end(), [after](const std::unique_ptr<BasicBlock>& block) {
+        return block.get() == after;
+    });
+    auto inserted = blocks.insert(pos + 1, std::make_unique<BasicBlock>(nextBlockId++));
+    return inserted->get();
+}
+
+bool IRFunction::removeUnreachableBlocks() {
+    std::unordered_set<BasicBlock*> reachable;
+    std::vector<BasicBlock*> worklist = {entry()};
+    reachable.insert(entry());
+    while (!worklist.empty()) {
+        BasicBlock* block = worklist.back();
+        worklist.pop_back();
+        if (!block->hasTerminator()) continue;
+        for (BasicBlock* target : block->terminator().targets) {
+            if (reachable.insert(target).second) {
+                worklist.push_back(target);
+            }
+        }
+    }
+    
+    size_t before = blocks.size();
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](const std::unique_ptr<BasicBlock>& block) {
+        return !reachable.count(block.get());
+    }), blocks.end());
+    rebuildCFG();
+    return blocks.size() != before;
+}
+
+static const char* opcodeName(IRInstr::Opcode op) {
+    switch (op) {
+        case IRInstr::COPY: return "copy";
+        case IRInstr::ADD: return "add";
+        case IRInstr::SUB: return "sub";
+        case IRInstr::MUL: return "mul";
+        case IRInstr::DIV: return "div";
+        case IRInstr::MOD: return "mod";
+        case IRInstr::LT: return "lt";
+        case IRInstr::LE: return "le";
+        case IRInstr::GT: return "gt";
+        case IRInstr::GE: return "ge";
+        case IRInstr::EQ: return "eq";
+        case IRInstr::NE: return "ne";
+        case IRInstr::AND: return "and";
+        case IRInstr::OR: return "or";
+        case IRInstr::NEG: return "neg";
+        case IRInstr::NOT: return "not";
+        case IRInstr::CALL: return "call";
+        case IRInstr::RET: return "ret";
+        case IRInstr::JUMP: return "jump";
+        case IRInstr::BRANCH: return "br";
+        case IRInstr::PHI: return "phi";
+    }
+    return "?";
+}
+
+void IRFunction::print(std::ostream& os) const {
+    auto valueName = [this](const IRValue& value) -> std::string {
+        if (value.isConst()) return std::to_string(value.value);
+        if (value.isVar()) {
+            const std::string& varName = varNames[value.value];
+            return "%" + (varName.empty() ? "t" : varName + ".") + std::to_string(value.value);
+        }
+        return "_";
+    };
+    
+    os << "function " << name << "(";
+    for (size_t i = 0; i < params.size(); ++i) {
+        os << (i ? ", " : "") << valueName(IRValue::var(params[i]));
+    }
+    os << ")" << (returnsValue ? " -> int" : "") << " {\n";
+    
+    for (const auto& block : blocks) {
+        os << "bb" << block->id << ":";
+        if (!block->preds.empty()) {
+            os << "    ; preds:";
+            for (BasicBlock* pred : block->preds) os << " bb" << pred->id;
+        }
+        os << "\n";
+        for (const auto& instr : block->instructions) {
+            os << "    ";
+            if (instr.dst >= 0) os << valueName(IRValue::var(instr.dst)) << " = ";
+            os << opcodeName(instr.op);
+            if (instr.op == IRInstr::CALL) os << " " << instr.callee;
+            if (instr.isPhi()) {
+                for (size_t i = 0; i < instr.operands.size(); ++i) {
+                    os << (i ? ", [" : " [") << valueName(instr.operands[i]) << ", bb" << instr.targets[i]->id << "]";
+                }
+                os << "\n";
+                continue;
+            }
+            for (size_t i = 0; i < instr.operands.size(); ++i) {
+                os << (i ? ", " : " ") << valueName(instr.operands[i]);
+            }
+            for (size_t i = 0; i < instr.targets.size(); ++i) {
+                os << ((i || !instr.operands.empty()) ? ", " : " ") << "bb" << instr.targets[i]->id;
+            }
+            os << "\n";
+        }
+    }
+    os << "}\n";
+}
+
+bool foldBinary(IRInstr::Opcode op, int lhs, int rhs, int& result) {
+    uint32_t a = (uint32_t)lhs;
+    uint32_t b = (uint32_t)rhs;
+    switch (op) {
+        case IRInstr::ADD: result = (int)(a + b); return true;
+        case IRInstr::SUB: result = (int)(a - b); return true;
+        case IRInstr::MUL: result = (int)(a * b); return true;
+        case IRInstr::DIV:
+            if (rhs == 0) return false;
+            result = (lhs == INT32_MIN && rhs == -1) ? INT32_MIN : lhs / rhs;
+            return true;
+        case IRInstr::MOD:
+            if (rhs == 0) return false;
+            result = (lhs == INT32_MIN && rhs == -1) ? 0 : lhs % rhs;
+            return true;
+        case IRInstr::LT: result = lhs < rhs; return true;
+        case IRInstr::LE: result = lhs <= rhs; return true;
+        case IRInstr::GT: result = lhs > rhs; return true;
+        case IRInstr::GE: result = lhs >= rhs; return true;
+        case IRInstr::EQ: result = lhs == rhs; return true;
+        case IRInstr::NE: result = lhs != rhs; return true;
+        case IRInstr::AND: result = lhs && rhs; return true;
+        case IRInstr::OR: result = lhs || rhs; return true;
+        default: return false;
+    }
+}
+
+int foldUnary(IRInstr::Opcode op, int operand) {
+    if (op == IRInstr::NEG) return (int)(0u - (uint32_t)operand);
+    return !operand;
+}
+
+void IRModule::print(std::ostream& os) const {
+    for (const auto& function : functions) {
+        function->print(os);
+        os << "\n";
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// IR 操作数：变量编号或整数常量
+class IRValue {
+public:
+    enum Kind { NONE, VAR, CONST };
+    
+    Kind kind;
+    int value;  // VAR 时为变量编号，CONST 时为常量值
+    
+    IRValue() : kind(NONE), value(0) {}
+    
+    static IRValue var(int id) { return IRValue(VAR, id); }
+    static IRValue constant(int v) { return IRValue(CONST, v); }
+    
+    bool isNone() const { return kind == NONE; }
+    bool isVar() const { return kind == VAR; }
+    bool isConst() const { return kind == CONST; }
+    
+    bool operator==(const IRValue& other) const { return kind == other.kind && value == other.value; }
+    bool operator!=(const IRValue& other) const { return !(*this == other); }
+    
+private:
+    IRValue(Kind k, int v) : kind(k), value(v) {}
+};
+
+class BasicBlock;
+
+// 三地址指令：dst = op operands...
+class IRInstr {
+public:
+    enum Opcode {
+        COPY,                                   // dst = a
+        ADD, SUB, MUL, DIV, MOD,                // dst = a op b
+        LT, LE, GT, GE, EQ, NE,                 // dst = (a op b) ? 1 : 0
+        AND, OR,                                // 逻辑与/或，结果为 0 或 1
+        NEG, NOT,                               // dst = op a
+        CALL,                                   // dst = callee(operands...)，dst 可以为空
+        RET,                                    // return [a]
+        JUMP,                                   // goto targets[0]
+        BRANCH,                                 // if (a) goto targets[0] else goto targets[1]
+        PHI                                     // SSA 合流：来自 targets[i] 时取 operands[i]
+    };
+    
+    Opcode op;
+    int dst;                           // 结果变量，-1 表示没有结果
+    std::vector<IRValue> operands;
+    std::string callee;                // CALL 的被调函数名
+    std::vector<BasicBlock*> targets;  // JUMP / BRANCH 的目标块；PHI 的来源前驱块
+    
+    IRInstr(Opcode o, int d = -1, std::vector<IRValue> ops = {})
+        : op(o), dst(d), operands(std::move(ops)) {}
+    
+    bool isTerminator() const { return op == RET || op == JUMP || op == BRANCH; }
+    bool isBinary() const { return op >= ADD && op <= OR; }
+    bool isUnary() const { return op == NEG || op == NOT; }
+    bool isPhi() const { return op == PHI; }
+    bool hasSideEffects() const { return op == CALL || isTerminator(); }
+};
+
+class BasicBlock {
+public:
+    int id;
+    std::vector<IRInstr> instructions;
+    std::vector<BasicBlock*> preds;
+    std::vector<BasicBlock*> succs;
+    
+    explicit BasicBlock(int i) : id(i) {}
+    
+    bool hasTerminator() const { return !instructions.empty() && instructions.back().isTerminator(); }
+    IRInstr& terminator() { return instructions.back(); }
+};
+
+class IRFunction {
+public:
+    std::string name;
+    bool returnsValue;
+    std::vector<int> params;                           // 形参对应的变量
+    std::vector<std::unique_ptr<BasicBlock>> blocks;   // blocks[0] 为入口，顺序即代码布局
+    std::vector<std::string> varNames;                 // 源变量名，临时变量为空串
+    
+    IRFunction(const std::string& n, bool ret) : name(n), returnsValue(ret), nextBlockId(0) {}
+    
+    int newVar(const std::string& varName = "") {
+        varNames.push_back(varName);
+        return (int)varNames.size() - 1;
+    }
+    int numVars() const { return (int)varNames.size(); }
+    
+    BasicBlock* newBlock() {
+        blocks.push_back(std::make_unique<BasicBlock>(nextBlockId++));
+        return blocks.back().get();
+    }
+    // 新块紧跟在 after 之后布局
+    BasicBlock* newBlockAfter(const BasicBlock* after);
+    BasicBlock* entry() const { return blocks.front().get(); }
+    
+    // 根据终结指令重新计算前驱/后继，并删掉 phi 中已不是前驱的来源
+    void rebuildCFG();
+    // 删除从入口不可达的基本块，返回是否有改动
+    bool removeUnreachableBlocks();
+    
+    void print(std::ostream& os) const;
+    
+private:
+    int nextBlockId;
+};
+
+// 按 RV32 语义对常量求值（加减乘回绕，除数为 0 时不折叠）
+bool foldBinary(IRInstr::Opcode op, int lhs, int rhs, int& result);
+int foldUnary(IRInstr::Opcode op, int operand);
+
+class IRModule {
+public:
+    std::vector<std::unique_ptr<IRFunction>> functions;
+    
+    void print(std::ostream& os) const;
+};
@@ -0,0 +1,133 @@
+#include "ir/loops.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+BasicBlock* Loop::preheader() const {
+    BasicBlock* candidate = nullptr;
+    for (BasicBlock* pred : header->preds) {
+        if (contains(pred)) continue;
+        if (candidate) return nullptr;
+        candidate = pred;
+    }
+    return candidate && candidate->succs.size() == 1 ? candidate : nullptr;
+}
+
+LoopInfo::LoopInfo(const DominatorTree& domTree) {
+    std::unordered_map<BasicBlock*, size_t> byHeader;
+    for (BasicBlock* block : domTree.reversePostOrder()) {
+        for (BasicBlock* succ : block->succs) {
+            if (!domTree.dominates(succ, block)) continue;
+            auto it = byHeader.find(succ);
+            if (it == byHeader.end()) {
+                it = byHeader.emplace(succ, loopList.size()).first;
+                loopList.emplace_back(succ);
+                loopList.back().blocks.insert(succ);
+            }
+            Loop& loop = loopList[it->second];
+            loop.latches.push_back(block);
+            
+            // 从回边源头逆着前驱走，直到循环头
+            std::vector<BasicBlock*> worklist;
+            if (loop.blocks.insert(block).second) worklist.push_back(block);
+            while (!worklist.empty()) {
+                BasicBlock* current = worklist.back();
+                worklist.pop_back();
+                for (BasicBlock* pred : current->preds) {
+                    if (loop.blocks.insert(pred).second) worklist.push_back(pred);
+                }
+            }
+        }
+    }
+    
+    std::stable_sort(loopList.begin(), loopList.end(), [](const Loop& a, const Loop& b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+}
+
+BasicBlock* insertPreheader(IRFunction& function, const Loop& loop) {
+    BasicBlock* header = loop.header;
+    if (header == function.entry()) return nullptr;
+    std::vector<BasicBlock*> outside;
+    for (BasicBlock* pred : header->preds) {
+        if (!loop.contains(pred)) outside.push_back(pred);
+    }
+    if (outside.empty()) return nullptr;
+    
+    // 前置块紧挨着放在循环头之前
+    auto pos = std::find_if(function.blocks.begin(), function.blocks.end(),
+        [header](const std::unique_ptr<BasicBlock>& block) { return block.get() == header; });
+    BasicBlock* preheader = function.newBlockAfter((pos - 1)->get());
+    
+    for (BasicBlock* pred : outside) {
+        for (BasicBlock*& target : pred->terminator().targets) {
+            if (target == header) target = preheader;
+        }
+    }
+    
+    for (auto& phi : header->instructions) {
+        if (!phi.isPhi()) break;
+        IRInstr merged(IRInstr::PHI);
+        for (size_t i = phi.targets.size(); i-- > 0;) {
+            if (loop.contains(phi.targets[i])) continue;
+            merged.operands.insert(merged.operands.begin(), phi.operands[i]);
+            merged.targets.insert(merged.targets.begin(), phi.targets[i]);
+            phi.operands.erase(phi.operands.begin() + i);
+            phi.targets.erase(phi.targets.begin() + i);
+        }
+        if (merged.operands.size() == 1) {
+            phi.operands.push_back(merged.operands[0]);
+        } else {
+            merged.dst = function.newVar(function.varNames[phi.dst]);
+            phi.operands.push_back(IRValue::var(merged.dst));
+            preheader->instructions.push_back(std::move(merged));
+        }
+        phi.targets.push_back(preheader);
+    }
+    
+    IRInstr jump(IRInstr::JUMP);
+    jump.targets.push_back(header);
+    preheader->instructions.push_back(std::move(jump));
+    function.rebuildCFG();
+    return preheader;
+}
+
+BasicBlock* insertLatch(IRFunction& function, const Loop& loop) {
+    if (loop.latches.size() == 1) return loop.latches[0];
+    BasicBlock* header = loop.header;
+    std::unordered_set<const BasicBlock*> latches(loop.latches.begin(), loop.latches.end());
+    
+    // 回边块放在布局上最后一个 latch 之后
+    const BasicBlock* last = nullptr;
+    for (const auto& block : function.blocks) {
+        if (latches.count(block.get())) last = block.get();
+    }
+    BasicBlock* latch = function.newBlockAfter(last);
+    
+    for (BasicBlock* from : loop.latches) {
+        for (BasicBlock*& target : from->terminator().targets) {
+            if (target == header) target = latch;
+        }
+    }
+    
+    for (auto& phi : header->instructions) {
+        if (!phi.isPhi()) break;
+        IRInstr merged(IRInstr::PHI);
+        for (size_t i = phi.targets.size(); i-- > 0;) {
+            if (!latches.count(phi.targets[i])) continue;
+            merged.operands.insert(merged.operands.begin(), phi.operands[i]);
+            merged.targets.insert(merged.targets.begin(), phi.targets[i]);
+            phi.operands.erase(phi.operands.begin() + i);
+            phi.targets.erase(phi.targets.begin() + i);
+        }
+        merged.dst = function.newVar(function.varNames[phi.dst]);
+        phi.operands.push_back(IRValue::var(merged.dst));
+        phi.targets.push_back(latch);
+        latch->instructions.push_back(std::move(merged));
+    }
+    
+    IRInstr jump(IRInstr::JUMP);
+    jump.targets.push_back(header);
+    latch->instructions.push_back(std::move(jump));
+    function.rebuildCFG();
+    return latch;
+}
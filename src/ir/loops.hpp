@@ -0,0 +1,38 @@
+#pragma once
+#include "ir/dominators.hpp"
+#include <unordered_set>
+#include <vector>
+
+// 自然循环：由回边 latch -> header（header 支配 latch）确定，
+// 同一循环头的多条回边（如 continue）合并为一个循环
+class Loop {
+public:
+    BasicBlock* header;
+    std::vector<BasicBlock*> latches;
+    std::unordered_set<const BasicBlock*> blocks;
+    
+    explicit Loop(BasicBlock* h) : header(h) {}
+    
+    bool contains(const BasicBlock* block) const { return blocks.count(block) != 0; }
+    // 循环外唯一的、只跳向循环头的前驱；没有时返回 nullptr
+    BasicBlock* preheader() const;
+};
+
+// 函数中的全部自然循环，块数少的（内层）在前；CFG 改动后需要重新计算
+class LoopInfo {
+public:
+    explicit LoopInfo(const DominatorTree& domTree);
+    
+    std::vector<Loop>& loops() { return loopList; }
+    
+private:
+    std::vector<Loop> loopList;
+};
+
+// 为循环插入前置块：循环外的前驱改为跳向它，循环头 phi 中来自这些前驱的项
+// 在前置块里合并为一个新的 phi。返回前置块，循环头是函数入口时返回 nullptr
+BasicBlock* insertPreheader(IRFunction& function, const Loop& loop);
+
+// 把循环的多条回边（如 continue）合并为一条：各 latch 改为跳向新的回边块，由它跳向循环头，
+// 循环头 phi 中来自这些 latch 的项在新块里合并为一个新的 phi。返回新块，只有一条回边时返回该 latch
+BasicBlock* insertLatch(IRFunction& function, const Loop& loop);
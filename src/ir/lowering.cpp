@@ -0,0 +1,300 @@
+#include "ir/lowering.hpp"
+#include <stdexcept>
+
+std::unique_ptr<IRModule> IRBuilder::build(CompilationUnit& unit) {
+    module = std::make_unique<IRModule>();
+    dispatch(unit);
+    return std::move(module);
+}
+
+std::unique_ptr<IRModule> IRBuilder::build(FunctionDefinition& function) {
+    module = std::make_unique<IRModule>();
+    dispatch(function);
+    return std::move(module);
+}
+
+IRValue IRBuilder::lower(Expression& expr) {
+    dispatch(expr);
+    return result;
+}
+
+void IRBuilder::lowerCondition(Expression& expr, BasicBlock* ifTrue, BasicBlock* ifFalse) {
+    if (auto binary = expr.as<BinaryExpression>()) {
+        if (binary->op == BinaryExpression::AND || binary->op == BinaryExpression::OR) {
+            BasicBlock* rhsBlock = function->newBlockAfter(current);
+            if (binary->op == BinaryExpression::AND) {
+                lowerCondition(*binary->left, rhsBlock, ifFalse);
+            } else {
+                lowerCondition(*binary->left, ifTrue, rhsBlock);
+            }
+            setInsertPoint(rhsBlock);
+            lowerCondition(*binary->right, ifTrue, ifFalse);
+            return;
+        }
+    }
+    if (auto unary = expr.as<UnaryExpression>()) {
+        if (unary->op == UnaryExpression::NOT) {
+            lowerCondition(*unary->operand, ifFalse, ifTrue);
+            return;
+        }
+    }
+    // 比较运算保留为 IR 指令，由指令选择与随后的分支融合成 blt/bge/beq/bne
+    emitBranch(lower(expr), ifTrue, ifFalse);
+}
+
+// 值上下文中的 &&/||：按条件分支到两个块，分别给结果赋 1 / 0
+IRValue IRBuilder::lowerLogical(Expression& expr) {
+    int dst = function->newVar();
+    BasicBlock* trueBlock = function->newBlockAfter(current);
+    BasicBlock* falseBlock = function->newBlockAfter(trueBlock);
+    BasicBlock* endBlock = function->newBlockAfter(falseBlock);
+    
+    lowerCondition(expr, trueBlock, falseBlock);
+    setInsertPoint(trueBlock);
+    emit(IRInstr(IRInstr::COPY, dst, {IRValue::constant(1)}));
+    emitJump(endBlock);
+    setInsertPoint(falseBlock);
+    emit(IRInstr(IRInstr::COPY, dst, {IRValue::constant(0)}));
+    emitJump(endBlock);
+    setInsertPoint(endBlock);
+    return IRValue::var(dst);
+}
+
+void IRBuilder::emit(IRInstr instr) {
+    // return/break/continue 之后的语句放进一个没有前驱的新块，稍后统一删除
+    if (current->hasTerminator()) {
+        current = function->newBlock();
+    }
+    current->instructions.push_back(std::move(instr));
+}
+
+void IRBuilder::emitJump(BasicBlock* target) {
+    IRInstr jump(IRInstr::JUMP);
+    jump.targets = {target};
+    emit(std::move(jump));
+}
+
+void IRBuilder::emitBranch(IRValue cond, BasicBlock* ifTrue, BasicBlock* ifFalse) {
+    IRInstr branch(IRInstr::BRANCH, -1, {cond});
+    branch.targets = {ifTrue, ifFalse};
+    emit(std::move(branch));
+}
+
+void IRBuilder::assign(int var, IRValue value) {
+    // 值刚由上一条指令算进临时变量时，直接改写那条指令的目标，省掉一次 copy
+    if (value.isVar() && function->varNames[value.value].empty() && !current->instructions.empty()) {
+        IRInstr& last = current->instructions.back();
+        if (last.dst == value.value) {
+            last.dst = var;
+            return;
+        }
+    }
+    emit(IRInstr(IRInstr::COPY, var, {value}));
+}
+
+void IRBuilder::exitScope() {
+    auto& shadowed = scopes.back();
+    for (auto it = shadowed.rbegin(); it != shadowed.rend(); ++it) {
+        if (it->second >= 0) {
+            bindings[it->first] = it->second;
+        } else {
+            bindings.erase(it->first);
+        }
+    }
+    scopes.pop_back();
+}
+
+int IRBuilder::declare(SymbolId name) {
+    int var = function->newVar(name.str());
+    const int* previous = bindings.find(name);
+    scopes.back().emplace_back(name, previous ? *previous : -1);
+    bindings[name] = var;
+    return var;
+}
+
+int IRBuilder::lookup(SymbolId name) const {
+    const int* var = bindings.find(name);
+    if (!var) {
+        throw std::runtime_error("IR lowering: undefined variable '" + name.str() + "'");
+    }
+    return *var;
+}
+
+void IRBuilder::visit(BinaryExpression& node) {
+    if (node.op == BinaryExpression::AND || node.op == BinaryExpression::OR) {
+        result = lowerLogical(node);
+        return;
+    }
+    
+    IRValue lhs = lower(*node.left);
+    IRValue rhs = lower(*node.right);
+    
+    IRInstr::Opcode op = IRInstr::ADD;
+    switch (node.op) {
+        case BinaryExpression::ADD: op = IRInstr::ADD; break;
+        case BinaryExpression::SUB: op = IRInstr::SUB; break;
+        case BinaryExpression::MUL: op = IRInstr::MUL; break;
+        case BinaryExpression::DIV: op = IRInstr::DIV; break;
+        case BinaryExpression::MOD: op = IRInstr::MOD; break;
+        case BinaryExpression::LT: op = IRInstr::LT; break;
+        case BinaryExpression::LE: op = IRInstr::LE; break;
+        case BinaryExpression::GT: op = IRInstr::GT; break;
+        case BinaryExpression::GE: op = IRInstr::GE; break;
+        case BinaryExpression::EQ: op = IRInstr::EQ; break;
+        case BinaryExpression::NE: op = IRInstr::NE; break;
+        case BinaryExpression::AND: case BinaryExpression::OR: break;
+    }
+    
+    int dst = function->newVar();
+    emit(IRInstr(op, dst, {lhs, rhs}));
+    result = IRValue::var(dst);
+}
+
+void IRBuilder::visit(UnaryExpression& node) {
+    IRValue operand = lower(*node.operand);
+    if (node.op == UnaryExpression::PLUS) {
+        result = operand;
+        return;
+    }
+    
+    int dst = function->newVar();
+    emit(IRInstr(node.op == UnaryExpression::MINUS ? IRInstr::NEG : IRInstr::NOT, dst, {operand}));
+    result = IRValue::var(dst);
+}
+
+void IRBuilder::visit(NumberLiteral& node) {
+    result = IRValue::constant(node.value);
+}
+
+void IRBuilder::visit(Identifier& node) {
+    result = IRValue::var(lookup(node.name));
+}
+
+void IRBuilder::visit(FunctionCall& node) {
+    std::vector<IRValue> args;
+    for (const auto& arg : node.arguments) {
+        args.push_back(lower(*arg));
+    }
+    
+    int dst = node.returnType == Expression::VOID ? -1 : function->newVar();
+    IRInstr call(IRInstr::CALL, dst, std::move(args));
+    call.callee = node.functionName.str();
+    emit(std::move(call));
+    result = dst >= 0 ? IRValue::var(dst) : IRValue::constant(0);
+}
+
+void IRBuilder::visit(AssignmentStatement& node) {
+    IRValue value = lower(*node.value);
+    assign(lookup(node.variable), value);
+}
+
+void IRBuilder::visit(VariableDeclaration& node) {
+    IRValue value = node.initializer ? lower(*node.initializer) : IRValue::constant(0);
+    // 先求初始化表达式再声明，使 int x = x + 1 中的 x 指向外层变量
+    assign(declare(node.name), value);
+}
+
+void IRBuilder::visit(Block& node) {
+    enterScope();
+    for (const auto& stmt : node.statements) {
+        dispatch(*stmt);
+        // return/break/continue 之后的语句不可达，不再降低
+        if (current->hasTerminator()) break;
+    }
+    exitScope();
+}
+
+void IRBuilder::visit(IfStatement& node) {
+    // 新块紧接当前块布局，嵌套结构的代码顺序与源程序一致
+    BasicBlock* thenBlock = function->newBlockAfter(current);
+    BasicBlock* elseBlock = node.elseStatement ? function->newBlockAfter(thenBlock) : nullptr;
+    BasicBlock* endBlock = function->newBlockAfter(elseBlock ? elseBlock : thenBlock);
+    
+    lowerCondition(*node.condition, thenBlock, elseBlock ? elseBlock : endBlock);
+    
+    setInsertPoint(thenBlock);
+    dispatch(*node.thenStatement);
+    emitJump(endBlock);
+    
+    if (elseBlock) {
+        setInsertPoint(elseBlock);
+        dispatch(*node.elseStatement);
+        emitJump(endBlock);
+    }
+    
+    setInsertPoint(endBlock);
+}
+
+void IRBuilder::visit(WhileStatement& node) {
+    BasicBlock* header = function->newBlockAfter(current);
+    BasicBlock* body = function->newBlockAfter(header);
+    BasicBlock* exit = function->newBlockAfter(body);
+    
+    emitJump(header);
+    setInsertPoint(header);
+    lowerCondition(*node.condition, body, exit);
+    
+    breakTargets.push_back(exit);
+    continueTargets.push_back(header);
+    setInsertPoint(body);
+    dispatch(*node.body);
+    emitJump(header);
+    breakTargets.pop_back();
+    continueTargets.pop_back();
+    
+    setInsertPoint(exit);
+}
+
+void IRBuilder::visit(BreakStatement& node) {
+    (void)node;
+    emitJump(breakTargets.back());
+}
+
+void IRBuilder::visit(ContinueStatement& node) {
+    (void)node;
+    emitJump(continueTargets.back());
+}
+
+void IRBuilder::visit(ReturnStatement& node) {
+    IRInstr ret(IRInstr::RET);
+    if (node.value) {
+        ret.operands.push_back(lower(*node.value));
+    }
+    emit(std::move(ret));
+}
+
+void IRBuilder::visit(ExpressionStatement& node) {
+    lower(*node.expression);
+}
+
+void IRBuilder::visit(FunctionDefinition& node) {
+    module->functions.push_back(std::make_unique<IRFunction>(node.name.str(), node.returnType == Expression::INT));
+    function = module->functions.back().get();
+    current = function->newBlock();
+    
+    bindings.clear();
+    scopes.clear();
+    enterScope();
+    for (const auto& param : node.parameters) {
+        function->params.push_back(declare(param.name));
+    }
+    
+    dispatch(*node.body);
+    
+    // 函数末尾隐含的返回
+    if (!current->hasTerminator()) {
+        IRInstr ret(IRInstr::RET);
+        if (function->returnsValue) {
+            ret.operands.push_back(IRValue::constant(0));
+        }
+        emit(std::move(ret));
+    }
+    
+    function->removeUnreachableBlocks();
+}
+
+void IRBuilder::visit(CompilationUnit& node) {
+    for (const auto& func : node.functions) {
+        dispatch(*func);
+    }
+}
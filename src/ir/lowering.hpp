@@ -0,0 +1,64 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "ir/ir.hpp"
+#include "common/symbol.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 把（已通过语义分析的）AST 降低为三地址 IR 和控制流图
+class IRBuilder : public ASTVisitor<IRBuilder> {
+private:
+    std::unique_ptr<IRModule> module;
+    IRFunction* function;
+    BasicBlock* current;
+    IRValue result;  // 最近一个表达式的值
+    
+    // 变量 -> IR 变量，按符号 ID 直接索引；每层作用域记录被它遮蔽的旧绑定，退出时恢复
+    SymbolMap<int> bindings;
+    std::vector<std::vector<std::pair<SymbolId, int>>> scopes;
+    std::vector<BasicBlock*> breakTargets;
+    std::vector<BasicBlock*> continueTargets;
+    
+public:
+    IRBuilder() : function(nullptr), current(nullptr) {}
+    
+    std::unique_ptr<IRModule> build(CompilationUnit& unit);
+    // 只含一个函数的模块（流式编译）
+    std::unique_ptr<IRModule> build(FunctionDefinition& function);
+    
+    // 各节点的降低，由 ASTVisitor::dispatch 按节点标签静态分派
+    void visit(BinaryExpression& node);
+    void visit(UnaryExpression& node);
+    void visit(NumberLiteral& node);
+    void visit(Identifier& node);
+    void visit(FunctionCall& node);
+    void visit(AssignmentStatement& node);
+    void visit(VariableDeclaration& node);
+    void visit(Block& node);
+    void visit(IfStatement& node);
+    void visit(WhileStatement& node);
+    void visit(BreakStatement& node);
+    void visit(ContinueStatement& node);
+    void visit(ReturnStatement& node);
+    void visit(ExpressionStatement& node);
+    void visit(FunctionDefinition& node);
+    void visit(CompilationUnit& node);
+    
+private:
+    IRValue lower(Expression& expr);
+    // 把条件直接降低为控制流：&&/|| 短路，! 交换目标
+    void lowerCondition(Expression& expr, BasicBlock* ifTrue, BasicBlock* ifFalse);
+    IRValue lowerLogical(Expression& expr);
+    void emit(IRInstr instr);
+    void emitJump(BasicBlock* target);
+    void emitBranch(IRValue cond, BasicBlock* ifTrue, BasicBlock* ifFalse);
+    void assign(int var, IRValue value);
+    void setInsertPoint(BasicBlock* block) { current = block; }
+    
+    void enterScope() { scopes.emplace_back(); }
+    void exitScope();
+    int declare(SymbolId name);
+    int lookup(SymbolId name) const;
+};
@@ -1,131 +1,409 @@
-#include <iostream>
-#include <memory>
-#include <sstream>
-#include "ast/ast.hpp"
-#include "common/types.hpp"
-#include "semantic/analyzer.hpp"
-#include "codegen/riscv.hpp"
-#include "utils/utils.hpp"
-
-// 外部函数声明（由flex/bison生成）
-extern FILE* yyin;
-extern int yyparse();
-extern std::unique_ptr<CompilationUnit> root;
-extern int yylineno;
-
-void printUsage(const char* programName) {
-	std::cerr << "ToyC Compiler v1.0\n"
-	<< "Usage: " << programName << " [-opt]\n\n"
-	<< "Options:\n"
-	<< "  -opt         Enable optimizations\n"
-	<< "\n"
-	<< "Input: Read from stdin\n"
-	<< "Output: Write to stdout\n"
-	<< "Errors: Write to stderr\n\n"
-	<< "Example: " << programName << " < input.tc > output.s\n";
-}
-
-int main(int argc, char* argv[]) {
-	bool enableOptimizations = false;
-	
-	// 解析命令行参数
-	for (int i = 1; i < argc; i++) {
-		std::string arg = argv[i];
-		
-		if (arg == "-opt") {
-			enableOptimizations = true;
-		} else if (arg == "--help" || arg == "-h") {
-			printUsage(argv[0]);
-			return 0;
-		} else {
-			std::cerr << "Error: Unknown option: " << arg << std::endl;
-			printUsage(argv[0]);
-			return 1;
-		}
-	}
-	
-	try {
-		// 调试信息输出到stderr
-		if (enableOptimizations) {
-			std::cerr << "[INFO] Optimizations enabled" << std::endl;
-		}
-		
-		// 1. 从stdin读取输入并解析
-		std::cerr << "[INFO] Reading from stdin..." << std::endl;
-		
-		// 设置输入为stdin
-		yyin = stdin;
-		yylineno = 1;
-		root.reset();
-		
-		// 语法分析
-		int parseResult = yyparse();
-		
-		if (parseResult != 0) {
-			std::cerr << "Error: Parsing failed" << std::endl;
-			return 1;
-		}
-		
-		if (!root) {
-			std::cerr << "Error: No AST generated" << std::endl;
-			return 1;
-		}
-		
-		std::cerr << "[INFO] Parsing completed successfully" << std::endl;
-		
-		// 2. 语义分析
-		std::cerr << "[INFO] Performing semantic analysis..." << std::endl;
-		
-		SemanticAnalyzer analyzer;
-		if (!analyzer.analyze(*root)) {
-			std::cerr << "Semantic analysis failed:" << std::endl;
-			const auto& errors = analyzer.getErrors();
-			for (size_t i = 0; i < errors.size(); ++i) {
-				std::cerr << "  Error " << (i+1) << ": " << errors[i] << std::endl;
-			}
-			return 1;
-		}
-		
-		std::cerr << "[INFO] Semantic analysis completed successfully" << std::endl;
-		
-		// 3. 代码生成
-		std::cerr << "[INFO] Generating code..." << std::endl;
-		
-		RISCVCodeGenerator generator;
-		
-		// 如果启用优化，设置优化标志
-		if (enableOptimizations) {
-			generator.enableOptimizations();
-		}
-		
-		// 构建函数表
-		std::unordered_map<std::string, FunctionInfo> functionTable;
-		for (const auto& func : root->functions) {
-			std::vector<Expression::Type> paramTypes;
-			for (const auto& param : func->parameters) {
-				paramTypes.push_back(param.type);
-			}
-			functionTable[func->name] = FunctionInfo(func->name, func->returnType, paramTypes, true);
-		}
-		
-		std::string assemblyCode = generator.generate(*root, functionTable);
-		
-		std::cerr << "[INFO] Code generation completed" << std::endl;
-		
-		// 4. 输出到stdout
-		std::cout << assemblyCode;
-		
-		// 确保输出被刷新
-		std::cout.flush();
-		
-		std::cerr << "[INFO] Compilation successful!" << std::endl;
-		return 0;
-		
-	} catch (const std::exception& e) {
-		std::cerr << "Error: " << e.what() << std::endl;
-		return 1;
-	} catch (...) {
-		std::cerr << "Error: Unknown error occurred" << std::endl;
-		return 1;
-	}
-}
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+#include "ast/ast.hpp"
+#include "ast/arena.hpp"
+#include "ast/parse.hpp"
+#include "common/source_file.hpp"
+#include "common/output_sink.hpp"
+#include "common/time_report.hpp"
+#include "driver/compiler.hpp"
+#include "driver/batch.hpp"
+#include "driver/server.hpp"
+#include "utils/utils.hpp"
+
+void printUsage(const char* programName) {
+	std::cerr << "ToyC Compiler v1.0\n"
+	<< "Usage: " << programName << " [options] [input.tc] [-o output.s]\n"
+	<< "       " << programName << " [options] --batch [-j N] [-o DIR] input.tc...\n"
+	<< "       " << programName << " --server SOCKET [-j N] [--cache-dir DIR]\n"
+	<< "       " << programName << " --connect SOCKET [options] [input.tc] [-o output.s]\n\n"
+	<< "Options:\n"
+	<< "  -opt            Enable optimizations\n"
+	<< "  -inline-threshold=N  Inline non-recursive functions of at most N IR instructions (0 disables)\n"
+	<< "  -stack-machine  Disable register allocation (debug)\n"
+	<< "  -emit-ir        Print the three-address IR instead of assembly (debug)\n"
+	<< "  -o FILE         Write output to FILE instead of stdout\n"
+	<< "  --batch         Compile every input in one process; foo.tc is written to foo.s,\n"
+	<< "                  or to DIR/foo.s when -o DIR is given\n"
+	<< "  -j N            Number of threads: units run in parallel with --batch, functions otherwise\n"
+	<< "                  (default: all hardware threads)\n"
+	<< "  --cache-dir DIR Reuse the assembly of unchanged functions from DIR and store new ones there\n"
+	<< "  --stream        Compile and emit each function as soon as it is parsed, then free its AST;\n"
+	<< "                  functions must be defined before they are called, -opt does not inline\n"
+	<< "  --server SOCKET Run as a compile daemon on the Unix socket SOCKET until SIGINT/SIGTERM;\n"
+	<< "                  -j sets the number of worker threads, --cache-dir is shared by all requests\n"
+	<< "  --connect SOCKET  Compile through the daemon on SOCKET instead of in this process\n"
+	<< "  --time-report[=FILE]  Write per-phase timings, allocations, peak RSS and optimization\n"
+	<< "                  statistics as JSON to FILE (default: stderr)\n"
+	<< "\n"
+	<< "Input: The given file (memory-mapped), or stdin when omitted\n"
+	<< "Output: Write to stdout unless -o is given\n"
+	<< "Errors: Write to stderr\n\n"
+	<< "Example: " << programName << " input.tc -o output.s\n"
+	<< "         " << programName << " < input.tc > output.s\n"
+	<< "         " << programName << " -opt --batch -j 8 a.tc b.tc c.tc\n";
+}
+
+// --time-report 的 JSON 写到 path，path 为空时写到 stderr
+static bool writeTimeReport(const TimeReport& report, const std::string& path) {
+	if (path.empty()) {
+		report.writeJSON(std::cerr);
+		return true;
+	}
+	std::ofstream out(path);
+	report.writeJSON(out);
+	if (!out.flush()) {
+		std::cerr << "Error: cannot write '" << path << "'" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// 打开 -o 指定的输出文件，path 为空时使用 stdout；失败时返回 -1
+static int openOutput(const std::string& path) {
+	if (path.empty()) {
+		return STDOUT_FILENO;
+	}
+	int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		std::cerr << "Error: cannot write '" << path << "': " << std::strerror(errno) << std::endl;
+	}
+	return fd;
+}
+
+// 写出 sink 中剩余的内容并关闭输出文件
+static bool closeOutput(OutputSink& sink, int fd, const std::string& path, TimeReport* timeReport) {
+	bool written;
+	{
+		TimeReport::Phase phase(timeReport, "output");
+		written = sink.flush();
+		if (fd != STDOUT_FILENO) {
+			written = ::close(fd) == 0 && written;
+		}
+	}
+	if (!written) {
+		std::cerr << "Error: cannot write '" << (path.empty() ? "<stdout>" : path) << "'" << std::endl;
+	}
+	return written;
+}
+
+// --stream：边分析边编译，每个函数的汇编生成后立即写出，AST 随即释放。
+// 汇编在分析的同时写出，后面的函数出错时输出文件中已经有前面函数的代码
+static int compileStreaming(const std::string& input, const std::string& outputPath, const CompileOptions& options) {
+	TimeReport* timeReport = options.timeReport;
+	std::unique_ptr<SourceFile> source;
+	if (!input.empty()) {
+		std::string error;
+		{
+			TimeReport::Phase phase(timeReport, "read");
+			source = SourceFile::open(input, error);
+		}
+		if (!source) {
+			std::cerr << "Error: " << error << std::endl;
+			return 1;
+		}
+		std::cerr << "[INFO] Reading " << input << " (" << source->size() << " bytes, mapped)" << std::endl;
+		if (timeReport) timeReport->addCounter("input_bytes", (int64_t)source->size());
+	} else {
+		std::cerr << "[INFO] Reading from stdin..." << std::endl;
+	}
+	
+	int outputFd = openOutput(outputPath);
+	if (outputFd < 0) {
+		return 1;
+	}
+	OutputSink sink(outputFd);
+	StreamingCompiler compiler(options, sink, std::cerr);
+	FunctionHandler handler = [&compiler](std::unique_ptr<FunctionDefinition> function) {
+		return compiler.compileFunction(std::move(function));
+	};
+	
+	std::unique_ptr<CompilationUnit> root;
+	{
+		// 整个分析期间只有一个分配区，每个函数编译完后由 StreamingCompiler 清空
+		ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+		TimeReport::Phase phase(timeReport, "parse");
+		if (source) {
+			root = parseBuffer(source->buffer(), source->bufferSize(), std::cerr, nullptr, &handler);
+		} else {
+			root = parseStream(stdin, std::cerr, nullptr, &handler);
+		}
+	}
+	source.reset();
+	
+	bool compiled = root && compiler.finish();
+	if (!root && !compiler.failed()) {
+		std::cerr << "Error: Parsing failed" << std::endl;
+	}
+	if (!closeOutput(sink, outputFd, outputPath, timeReport) || !compiled) {
+		return 1;
+	}
+	std::cerr << "[INFO] Compilation successful!" << std::endl;
+	return 0;
+}
+
+// --connect：把输入交给守护进程编译，输出与诊断信息和在本进程内编译时一样分别写到 -o（或 stdout）和 stderr
+static int compileRemote(const std::string& socketPath, const std::string& flags, const std::string& input,
+                         const std::string& outputPath) {
+	std::string source;
+	{
+		std::ifstream file;
+		if (!input.empty()) {
+			file.open(input, std::ios::binary);
+			if (!file) {
+				std::cerr << "Error: cannot open '" << input << "'" << std::endl;
+				return 1;
+			}
+		}
+		std::istream& in = input.empty() ? std::cin : file;
+		source.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	
+	ServerResponse response;
+	std::string error;
+	if (!requestCompile(socketPath, flags, source, response, error)) {
+		std::cerr << "Error: " << error << std::endl;
+		return 1;
+	}
+	std::cerr << response.diagnostics;
+	if (response.status != 0) {
+		return 1;
+	}
+	int outputFd = openOutput(outputPath);
+	if (outputFd < 0) {
+		return 1;
+	}
+	OutputSink sink(outputFd);
+	sink.write(response.output);
+	return closeOutput(sink, outputFd, outputPath, nullptr) ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+	CompileOptions options;
+	bool batch = false;
+	bool stream = false;
+	std::string serverSocket;         // --server
+	std::string connectSocket;        // --connect
+	std::string requestFlags;         // --connect 时随请求发送的编译选项
+	unsigned jobs = 0;                // 0 表示使用全部硬件线程
+	std::vector<std::string> inputs;  // 为空时从 stdin 读取
+	std::string outputPath;           // 为空时写到 stdout；批量模式下为输出目录
+	std::unique_ptr<TimeReport> timeReport;
+	std::string timeReportPath;       // 为空时写到 stderr
+	
+	// 解析命令行参数
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		
+		if (arg == "-opt" || arg == "-stack-machine" || arg == "-emit-ir" || arg.rfind("-inline-threshold=", 0) == 0) {
+			requestFlags += (requestFlags.empty() ? "" : " ") + arg;
+		}
+		
+		if (arg == "-opt") {
+			options.optimize = true;
+		} else if (arg.rfind("-inline-threshold=", 0) == 0) {
+			try {
+				options.inlineThreshold = std::stoi(arg.substr(18));
+			} catch (const std::exception&) {
+				options.inlineThreshold = -1;
+			}
+			if (options.inlineThreshold < 0) {
+				std::cerr << "Error: Invalid inline threshold: " << arg << std::endl;
+				return 1;
+			}
+		} else if (arg == "-stack-machine") {
+			options.stackMachine = true;
+		} else if (arg == "-emit-ir") {
+			options.emitIR = true;
+		} else if (arg == "--cache-dir") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: --cache-dir requires a directory" << std::endl;
+				return 1;
+			}
+			options.cacheDir = argv[++i];
+		} else if (arg == "--time-report" || arg.rfind("--time-report=", 0) == 0) {
+			timeReport = std::make_unique<TimeReport>();
+			timeReportPath = arg.size() > 14 ? arg.substr(14) : "";
+		} else if (arg == "--batch") {
+			batch = true;
+		} else if (arg == "--stream") {
+			stream = true;
+		} else if (arg == "--server" || arg == "--connect") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: " << arg << " requires a socket path" << std::endl;
+				return 1;
+			}
+			(arg == "--server" ? serverSocket : connectSocket) = argv[++i];
+		} else if (arg == "-j" || (arg.rfind("-j", 0) == 0 && arg.size() > 2)) {
+			std::string count = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+			int parsed = 0;
+			try {
+				parsed = std::stoi(count);
+			} catch (const std::exception&) {
+				parsed = 0;
+			}
+			if (parsed <= 0) {
+				std::cerr << "Error: Invalid job count: " << count << std::endl;
+				return 1;
+			}
+			jobs = (unsigned)parsed;
+		} else if (arg == "-o") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: -o requires a file name" << std::endl;
+				return 1;
+			}
+			outputPath = argv[++i];
+		} else if (arg == "--help" || arg == "-h") {
+			printUsage(argv[0]);
+			return 0;
+		} else if (arg[0] != '-') {
+			inputs.push_back(arg);
+		} else {
+			std::cerr << "Error: Unknown option: " << arg << std::endl;
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	
+	if (!batch && inputs.size() > 1) {
+		std::cerr << "Error: Multiple input files require --batch" << std::endl;
+		return 1;
+	}
+	
+	if (stream && (batch || options.stackMachine || !options.cacheDir.empty())) {
+		std::cerr << "Error: --stream cannot be combined with --batch, -stack-machine or --cache-dir" << std::endl;
+		return 1;
+	}
+	
+	if (!serverSocket.empty() || !connectSocket.empty()) {
+		if ((!serverSocket.empty() && !connectSocket.empty()) || batch || stream || timeReport) {
+			std::cerr << "Error: --server and --connect cannot be combined with each other, --batch, --stream or --time-report"
+			          << std::endl;
+			return 1;
+		}
+		if (!serverSocket.empty()) {
+			// 编译选项由各请求给出，这里只取各请求共用的缓存目录
+			if (!inputs.empty() || !requestFlags.empty() || !outputPath.empty()) {
+				std::cerr << "Error: --server takes no input, output or compile options" << std::endl;
+				return 1;
+			}
+			CompileOptions defaults;
+			defaults.cacheDir = options.cacheDir;
+			return runServer(serverSocket, defaults, jobs, std::cerr);
+		}
+		if (!options.cacheDir.empty()) {
+			std::cerr << "Error: --cache-dir belongs to the --server side" << std::endl;
+			return 1;
+		}
+		return compileRemote(connectSocket, requestFlags, inputs.empty() ? "" : inputs[0], outputPath);
+	}
+	
+	// 调试信息输出到stderr
+	if (options.optimize) {
+		std::cerr << "[INFO] Optimizations enabled" << std::endl;
+	}
+	
+	if (batch) {
+		if (inputs.empty()) {
+			std::cerr << "Error: --batch requires at least one input file" << std::endl;
+			return 1;
+		}
+		options.timeReport = timeReport.get();
+		bool ok = compileBatch(inputs, outputPath, options, jobs, std::cerr) == 0;
+		if (timeReport) ok = writeTimeReport(*timeReport, timeReportPath) && ok;
+		return ok ? 0 : 1;
+	}
+	// 单个单元时线程用于并行处理各函数
+	options.jobs = jobs;
+	options.timeReport = timeReport.get();
+	
+	if (stream) {
+		int status;
+		try {
+			status = compileStreaming(inputs.empty() ? "" : inputs[0], outputPath, options);
+		} catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return 1;
+		}
+		if (status == 0 && timeReport && !writeTimeReport(*timeReport, timeReportPath)) {
+			return 1;
+		}
+		return status;
+	}
+	
+	try {
+		// 1. 读取输入并解析：给出文件时映射到内存原地扫描，否则从stdin读取
+		std::unique_ptr<SourceFile> source;
+		std::unique_ptr<CompilationUnit> root;
+		{
+			// 语法分析：节点从 arena 分配，由 root 持有并在最后整体释放
+			ASTArena::Scope arenaScope(std::make_shared<ASTArena>());
+			if (!inputs.empty()) {
+				std::string error;
+				{
+					TimeReport::Phase phase(timeReport.get(), "read");
+					source = SourceFile::open(inputs[0], error);
+				}
+				if (!source) {
+					std::cerr << "Error: " << error << std::endl;
+					return 1;
+				}
+				std::cerr << "[INFO] Reading " << inputs[0] << " (" << source->size() << " bytes, mapped)" << std::endl;
+				if (timeReport) timeReport->addCounter("input_bytes", (int64_t)source->size());
+				TimeReport::Phase phase(timeReport.get(), "parse");
+				root = parseBuffer(source->buffer(), source->bufferSize(), std::cerr);
+			} else {
+				std::cerr << "[INFO] Reading from stdin..." << std::endl;
+				TimeReport::Phase phase(timeReport.get(), "parse");
+				root = parseStream(stdin, std::cerr);
+			}
+		}
+		source.reset();
+		
+		if (!root) {
+			std::cerr << "Error: Parsing failed" << std::endl;
+			return 1;
+		}
+		
+		std::cerr << "[INFO] Parsing completed successfully" << std::endl;
+		std::cerr << "[INFO] AST arena: " << root->arena->bytesUsed() << " bytes in "
+		          << root->arena->blockCount() << " blocks" << std::endl;
+		if (timeReport) {
+			timeReport->addCounter("ast.arena_bytes", (int64_t)root->arena->bytesUsed());
+			timeReport->addCounter("ast.arena_blocks", (int64_t)root->arena->blockCount());
+		}
+		
+		// 2. 编译，输出到 -o 指定的文件或 stdout：经定长缓冲区直接写文件描述符，函数生成完即写出
+		int outputFd = openOutput(outputPath);
+		if (outputFd < 0) {
+			return 1;
+		}
+		OutputSink sink(outputFd);
+		if (!compileUnit(*root, options, sink, std::cerr)) {
+			return 1;
+		}
+		if (!closeOutput(sink, outputFd, outputPath, timeReport.get())) {
+			return 1;
+		}
+		
+		std::cerr << "[INFO] Compilation successful!" << std::endl;
+		if (timeReport && !writeTimeReport(*timeReport, timeReportPath)) {
+			return 1;
+		}
+		return 0;
+		
+	} catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Error: Unknown error occurred" << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,246 @@
+#include "opt/constant_folder.hpp"
+#include <cstdint>
+
+std::unique_ptr<Expression> ConstantFolder::fold(std::unique_ptr<Expression> expr) {
+    if (!expr) return expr;
+    
+    // 先折叠子表达式，再化简当前节点
+    dispatch(*expr);
+    if (auto binary = expr->as<BinaryExpression>()) {
+        return simplifyBinary(std::move(expr), *binary);
+    }
+    if (auto unary = expr->as<UnaryExpression>()) {
+        return simplifyUnary(std::move(expr), *unary);
+    }
+    return expr;
+}
+
+std::unique_ptr<Expression> ConstantFolder::literal(int value) {
+    foldCount++;
+    return std::make_unique<NumberLiteral>(value);
+}
+
+// 逻辑运算的结果只能是 0 或 1：e 化为 e != 0（e 本身已是 0/1 时保持不变）
+std::unique_ptr<Expression> ConstantFolder::toBoolean(std::unique_ptr<Expression> expr) {
+    foldCount++;
+    if (auto binary = expr->as<BinaryExpression>()) {
+        if (binary->op >= BinaryExpression::LT) return expr;
+    }
+    if (auto unary = expr->as<UnaryExpression>()) {
+        if (unary->op == UnaryExpression::NOT) return expr;
+    }
+    return std::make_unique<BinaryExpression>(std::move(expr), BinaryExpression::NE, std::make_unique<NumberLiteral>(0));
+}
+
+bool ConstantFolder::isLiteral(const Expression* expr, int& value) {
+    if (auto numLit = expr->as<NumberLiteral>()) {
+        value = numLit->value;
+        return true;
+    }
+    return false;
+}
+
+// 不含函数调用的表达式没有副作用，可以整体删除
+bool ConstantFolder::isPure(const Expression* expr) {
+    if (expr->is<NumberLiteral>() || expr->is<Identifier>()) {
+        return true;
+    }
+    if (auto binary = expr->as<BinaryExpression>()) {
+        return isPure(binary->left.get()) && isPure(binary->right.get());
+    }
+    if (auto unary = expr->as<UnaryExpression>()) {
+        return isPure(unary->operand.get());
+    }
+    return false;
+}
+
+bool ConstantFolder::sameVariable(const Expression* a, const Expression* b) {
+    auto left = a->as<Identifier>();
+    auto right = b->as<Identifier>();
+    return left && right && left->name == right->name;
+}
+
+// 与 RV32 指令的结果一致：加减乘按 32 位回绕，除数为 0 时不折叠
+bool ConstantFolder::evaluate(BinaryExpression::Operator op, int lhs, int rhs, int& result) {
+    uint32_t a = (uint32_t)lhs;
+    uint32_t b = (uint32_t)rhs;
+    switch (op) {
+        case BinaryExpression::ADD: result = (int)(a + b); return true;
+        case BinaryExpression::SUB: result = (int)(a - b); return true;
+        case BinaryExpression::MUL: result = (int)(a * b); return true;
+        case BinaryExpression::DIV:
+            if (rhs == 0) return false;
+            result = (lhs == INT32_MIN && rhs == -1) ? INT32_MIN : lhs / rhs;
+            return true;
+        case BinaryExpression::MOD:
+            if (rhs == 0) return false;
+            result = (lhs == INT32_MIN && rhs == -1) ? 0 : lhs % rhs;
+            return true;
+        case BinaryExpression::LT: result = lhs < rhs; return true;
+        case BinaryExpression::LE: result = lhs <= rhs; return true;
+        case BinaryExpression::GT: result = lhs > rhs; return true;
+        case BinaryExpression::GE: result = lhs >= rhs; return true;
+        case BinaryExpression::EQ: result = lhs == rhs; return true;
+        case BinaryExpression::NE: result = lhs != rhs; return true;
+        case BinaryExpression::AND: result = lhs && rhs; return true;
+        case BinaryExpression::OR: result = lhs || rhs; return true;
+    }
+    return false;
+}
+
+std::unique_ptr<Expression> ConstantFolder::simplifyBinary(std::unique_ptr<Expression> expr, BinaryExpression& node) {
+    int lhs = 0, rhs = 0;
+    bool lhsConst = isLiteral(node.left.get(), lhs);
+    bool rhsConst = isLiteral(node.right.get(), rhs);
+    int result;
+    
+    if (lhsConst && rhsConst && evaluate(node.op, lhs, rhs, result)) {
+        return literal(result);
+    }
+    
+    switch (node.op) {
+        case BinaryExpression::AND:
+            // 0 && e 不求值 e；e && 0 只有 e 无副作用时才能删掉
+            if (lhsConst) return lhs ? toBoolean(std::move(node.right)) : literal(0);
+            if (rhsConst && !rhs && isPure(node.left.get())) return literal(0);
+            if (rhsConst && rhs) return toBoolean(std::move(node.left));
+            break;
+        case BinaryExpression::OR:
+            if (lhsConst) return lhs ? literal(1) : toBoolean(std::move(node.right));
+            if (rhsConst && rhs && isPure(node.left.get())) return literal(1);
+            if (rhsConst && !rhs) return toBoolean(std::move(node.left));
+            break;
+        case BinaryExpression::ADD:
+            if (rhsConst && rhs == 0) { foldCount++; return std::move(node.left); }
+            if (lhsConst && lhs == 0) { foldCount++; return std::move(node.right); }
+            break;
+        case BinaryExpression::SUB:
+            if (rhsConst && rhs == 0) { foldCount++; return std::move(node.left); }
+            if (lhsConst && lhs == 0) {
+                foldCount++;
+                return std::make_unique<UnaryExpression>(UnaryExpression::MINUS, std::move(node.right));
+            }
+            if (sameVariable(node.left.get(), node.right.get())) return literal(0);
+            break;
+        case BinaryExpression::MUL:
+            if (rhsConst && rhs == 1) { foldCount++; return std::move(node.left); }
+            if (lhsConst && lhs == 1) { foldCount++; return std::move(node.right); }
+            if (rhsConst && rhs == 0 && isPure(node.left.get())) return literal(0);
+            if (lhsConst && lhs == 0 && isPure(node.right.get())) return literal(0);
+            break;
+        case BinaryExpression::DIV:
+            if (rhsConst && rhs == 1) { foldCount++; return std::move(node.left); }
+            break;
+        case BinaryExpression::MOD:
+            if (rhsConst && (rhs == 1 || rhs == -1) && isPure(node.left.get())) return literal(0);
+            break;
+        case BinaryExpression::EQ:
+        case BinaryExpression::LE:
+        case BinaryExpression::GE:
+            if (sameVariable(node.left.get(), node.right.get())) return literal(1);
+            break;
+        case BinaryExpression::NE:
+        case BinaryExpression::LT:
+        case BinaryExpression::GT:
+            if (sameVariable(node.left.get(), node.right.get())) return literal(0);
+            break;
+    }
+    return expr;
+}
+
+std::unique_ptr<Expression> ConstantFolder::simplifyUnary(std::unique_ptr<Expression> expr, UnaryExpression& node) {
+    int value;
+    if (node.op == UnaryExpression::PLUS) {
+        foldCount++;
+        return std::move(node.operand);
+    }
+    if (isLiteral(node.operand.get(), value)) {
+        return literal(node.op == UnaryExpression::MINUS ? (int)(0u - (uint32_t)value) : !value);
+    }
+    // --e => e
+    if (auto inner = node.operand->as<UnaryExpression>()) {
+        if (node.op == UnaryExpression::MINUS && inner->op == UnaryExpression::MINUS) {
+            foldCount++;
+            return std::move(inner->operand);
+        }
+    }
+    return expr;
+}
+
+// 表达式节点：只折叠子表达式，当前节点由 fold 化简
+void ConstantFolder::visit(BinaryExpression& node) {
+    node.left = fold(std::move(node.left));
+    node.right = fold(std::move(node.right));
+}
+
+void ConstantFolder::visit(UnaryExpression& node) {
+    node.operand = fold(std::move(node.operand));
+}
+
+void ConstantFolder::visit(NumberLiteral& node) {
+    (void)node;
+}
+
+void ConstantFolder::visit(Identifier& node) {
+    (void)node;
+}
+
+void ConstantFolder::visit(FunctionCall& node) {
+    for (auto& arg : node.arguments) {
+        arg = fold(std::move(arg));
+    }
+}
+
+// 语句节点：折叠其中的每个表达式
+void ConstantFolder::visit(AssignmentStatement& node) {
+    node.value = fold(std::move(node.value));
+}
+
+void ConstantFolder::visit(VariableDeclaration& node) {
+    node.initializer = fold(std::move(node.initializer));
+}
+
+void ConstantFolder::visit(Block& node) {
+    for (const auto& stmt : node.statements) {
+        dispatch(*stmt);
+    }
+}
+
+void ConstantFolder::visit(IfStatement& node) {
+    node.condition = fold(std::move(node.condition));
+    dispatch(*node.thenStatement);
+    if (node.elseStatement) {
+        dispatch(*node.elseStatement);
+    }
+}
+
+void ConstantFolder::visit(WhileStatement& node) {
+    node.condition = fold(std::move(node.condition));
+    dispatch(*node.body);
+}
+
+void ConstantFolder::visit(BreakStatement& node) {
+    (void)node;
+}
+
+void ConstantFolder::visit(ContinueStatement& node) {
+    (void)node;
+}
+
+void ConstantFolder::visit(ReturnStatement& node) {
+    node.value = fold(std::move(node.value));
+}
+
+void ConstantFolder::visit(ExpressionStatement& node) {
+    node.expression = fold(std::move(node.expression));
+}
+
+void ConstantFolder::visit(FunctionDefinition& node) {
+    dispatch(*node.body);
+}
+
+void ConstantFolder::visit(CompilationUnit& node) {
+    for (const auto& func : node.functions) {
+        dispatch(*func);
+    }
+}
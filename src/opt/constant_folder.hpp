@@ -0,0 +1,52 @@
+#pragma once
+#include "ast/ast.hpp"
+#include <memory>
+
+// AST 上的常量折叠与代数化简，在代码生成之前自底向上改写表达式树：
+// 全常量子树折叠为 NumberLiteral，&&/|| 的常量一侧、x*1、x+0、x-x 等恒等式随之化简。
+// 只在不丢失副作用（函数调用）时删除子表达式。
+class ConstantFolder : public ASTVisitor<ConstantFolder> {
+private:
+    int foldCount;  // 被改写的表达式个数
+    
+public:
+    ConstantFolder() : foldCount(0) {}
+    
+    void run(CompilationUnit& unit) { dispatch(unit); }
+    void run(FunctionDefinition& function) { dispatch(function); }
+    int getFoldCount() const { return foldCount; }
+    
+    // 按 RV32 语义求常量二元运算；除数为 0 时返回 false（扁平 AST 的折叠也使用）
+    static bool evaluate(BinaryExpression::Operator op, int lhs, int rhs, int& result);
+    
+    // 各节点的处理，由 ASTVisitor::dispatch 按节点标签静态分派
+    void visit(BinaryExpression& node);
+    void visit(UnaryExpression& node);
+    void visit(NumberLiteral& node);
+    void visit(Identifier& node);
+    void visit(FunctionCall& node);
+    void visit(AssignmentStatement& node);
+    void visit(VariableDeclaration& node);
+    void visit(Block& node);
+    void visit(IfStatement& node);
+    void visit(WhileStatement& node);
+    void visit(BreakStatement& node);
+    void visit(ContinueStatement& node);
+    void visit(ReturnStatement& node);
+    void visit(ExpressionStatement& node);
+    void visit(FunctionDefinition& node);
+    void visit(CompilationUnit& node);
+    
+private:
+    // 折叠 expr 及其子树，返回替换后的表达式
+    std::unique_ptr<Expression> fold(std::unique_ptr<Expression> expr);
+    std::unique_ptr<Expression> simplifyBinary(std::unique_ptr<Expression> expr, BinaryExpression& node);
+    std::unique_ptr<Expression> simplifyUnary(std::unique_ptr<Expression> expr, UnaryExpression& node);
+    
+    std::unique_ptr<Expression> literal(int value);
+    std::unique_ptr<Expression> toBoolean(std::unique_ptr<Expression> expr);
+    
+    static bool isLiteral(const Expression* expr, int& value);
+    static bool isPure(const Expression* expr);
+    static bool sameVariable(const Expression* a, const Expression* b);
+};
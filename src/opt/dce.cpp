@@ -0,0 +1,67 @@
+#include "opt/passes.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+// 死代码消除（标记-清除）：从有副作用的指令（调用、返回、分支）出发，
+// 沿 use-def 反向标记所有对它们有贡献的定义，未被标记的指令一律删除。
+// SSA 形式下每个变量只有一个定义，死存储和互相引用的死循环变量都能删掉；
+// 非 SSA 形式下同一变量的所有定义一起标记，结果依然正确但更保守。
+class DeadCodeEliminationPass : public IRPass {
+public:
+    const char* name() const override { return "dce"; }
+    
+    bool run(IRFunction& function) override {
+        std::unordered_map<int, std::vector<const IRInstr*>> defs;
+        std::vector<const IRInstr*> worklist;
+        std::unordered_set<const IRInstr*> live;
+        std::unordered_set<int> usedVars;
+        
+        for (auto& block : function.blocks) {
+            for (const auto& instr : block->instructions) {
+                if (instr.dst >= 0) defs[instr.dst].push_back(&instr);
+                if (instr.hasSideEffects() && live.insert(&instr).second) {
+                    worklist.push_back(&instr);
+                }
+            }
+        }
+        
+        while (!worklist.empty()) {
+            const IRInstr* instr = worklist.back();
+            worklist.pop_back();
+            for (const auto& operand : instr->operands) {
+                if (!operand.isVar()) continue;
+                usedVars.insert(operand.value);
+                auto it = defs.find(operand.value);
+                if (it == defs.end()) continue;
+                for (const IRInstr* def : it->second) {
+                    if (live.insert(def).second) worklist.push_back(def);
+                }
+            }
+        }
+        
+        bool changed = false;
+        for (auto& block : function.blocks) {
+            auto& instrs = block->instructions;
+            size_t kept = 0;
+            for (size_t i = 0; i < instrs.size(); ++i) {
+                if (!live.count(&instrs[i])) {
+                    changed = true;
+                    continue;
+                }
+                // 返回值没人用的调用只保留调用本身
+                if (instrs[i].op == IRInstr::CALL && instrs[i].dst >= 0 && !usedVars.count(instrs[i].dst)) {
+                    instrs[i].dst = -1;
+                    changed = true;
+                }
+                if (kept != i) instrs[kept] = std::move(instrs[i]);
+                ++kept;
+            }
+            instrs.erase(instrs.begin() + kept, instrs.end());
+        }
+        return changed;
+    }
+};
+
+std::unique_ptr<IRPass> createDeadCodeEliminationPass() {
+    return std::make_unique<DeadCodeEliminationPass>();
+}
@@ -0,0 +1,254 @@
+#include "opt/passes.hpp"
+#include "ir/dominators.hpp"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+// 基于支配树的全局值编号（要求 SSA 形式）。
+// 沿支配树先序遍历，每个块打开一层作用域：块内的表达式先在本层查找（局部值编号），
+// 再沿作用域链在所有支配者中查找，命中即用先前的结果替换。
+// 两个分支开头都要算的同一表达式先提升到分支之前，这样它才能支配两边的使用点。
+// 顺带做复制传播、常量折叠和 x+0、x*1、x-x 之类的代数化简。
+// 调用不参与编号：每次调用的结果都是新值，也从不被合并或删除。
+class GlobalValueNumberingPass : public IRPass {
+public:
+    const char* name() const override { return "gvn"; }
+    
+    bool run(IRFunction& function) override {
+        replacements.clear();
+        table.clear();
+        bool changed = hoistFromBranches(function);
+        
+        DominatorTree domTree(function);
+        // 非递归先序遍历；第二次遇到一个块时关闭它的作用域
+        std::vector<std::pair<BasicBlock*, bool>> stack = {{function.entry(), false}};
+        std::vector<std::vector<Key>> scopes;
+        while (!stack.empty()) {
+            auto [block, leaving] = stack.back();
+            stack.pop_back();
+            if (leaving) {
+                for (const Key& key : scopes.back()) table.erase(key);
+                scopes.pop_back();
+                continue;
+            }
+            scopes.emplace_back();
+            if (numberBlock(*block, scopes.back())) changed = true;
+            stack.push_back({block, true});
+            const auto& children = domTree.children(block);
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                stack.push_back({*it, false});
+            }
+        }
+        
+        // 回边上的 phi 操作数以及其他尚未改写的使用点
+        if (!replacements.empty()) {
+            for (auto& block : function.blocks) {
+                for (auto& instr : block->instructions) {
+                    for (auto& operand : instr.operands) operand = resolve(operand);
+                }
+            }
+        }
+        return changed;
+    }
+    
+private:
+    // (操作码, 左操作数, 右操作数)
+    typedef std::tuple<int, int, int, int, int> Key;
+    
+    std::map<Key, int> table;                       // 表达式 -> 持有该值的变量
+    std::unordered_map<int, IRValue> replacements;  // 被消除的变量 -> 替代值
+    
+    IRValue resolve(IRValue value) const {
+        while (value.isVar()) {
+            auto it = replacements.find(value.value);
+            if (it == replacements.end()) break;
+            value = it->second;
+        }
+        return value;
+    }
+    
+    static bool isCommutative(IRInstr::Opcode op) {
+        return op == IRInstr::ADD || op == IRInstr::MUL || op == IRInstr::EQ || op == IRInstr::NE ||
+               op == IRInstr::AND || op == IRInstr::OR;
+    }
+    
+    static bool before(const IRValue& a, const IRValue& b) {
+        return std::make_pair(a.kind, a.value) < std::make_pair(b.kind, b.value);
+    }
+    
+    // 规范化：gt/ge 改写为交换操作数的 lt/le，可交换运算按操作数排序
+    static Key makeKey(IRInstr::Opcode op, IRValue a, IRValue b) {
+        if (op == IRInstr::GT || op == IRInstr::GE) {
+            std::swap(a, b);
+            op = op == IRInstr::GT ? IRInstr::LT : IRInstr::LE;
+        }
+        if (isCommutative(op) && before(b, a)) std::swap(a, b);
+        return Key(op, a.kind, a.value, b.kind, b.value);
+    }
+    
+    // 代数化简，能化简时写入 result
+    static bool simplify(IRInstr::Opcode op, const IRValue& a, const IRValue& b, IRValue& result) {
+        int folded;
+        if (a.isConst() && b.isConst() && foldBinary(op, a.value, b.value, folded)) {
+            result = IRValue::constant(folded);
+            return true;
+        }
+        bool same = a.isVar() && a == b;
+        auto isConst = [](const IRValue& v, int c) { return v.isConst() && v.value == c; };
+        switch (op) {
+            case IRInstr::ADD:
+                if (isConst(b, 0)) { result = a; return true; }
+                if (isConst(a, 0)) { result = b; return true; }
+                break;
+            case IRInstr::SUB:
+                if (isConst(b, 0)) { result = a; return true; }
+                if (same) { result = IRValue::constant(0); return true; }
+                break;
+            case IRInstr::MUL:
+                if (isConst(b, 1)) { result = a; return true; }
+                if (isConst(a, 1)) { result = b; return true; }
+                if (isConst(a, 0) || isConst(b, 0)) { result = IRValue::constant(0); return true; }
+                break;
+            case IRInstr::DIV:
+                if (isConst(b, 1)) { result = a; return true; }
+                break;
+            case IRInstr::MOD:
+                if (isConst(b, 1) || isConst(b, -1)) { result = IRValue::constant(0); return true; }
+                break;
+            case IRInstr::EQ: case IRInstr::LE: case IRInstr::GE:
+                if (same) { result = IRValue::constant(1); return true; }
+                break;
+            case IRInstr::NE: case IRInstr::LT: case IRInstr::GT:
+                if (same) { result = IRValue::constant(0); return true; }
+                break;
+            default:
+                break;
+        }
+        return false;
+    }
+    
+    static bool isNumbered(const IRInstr& instr) {
+        return instr.dst >= 0 && (instr.isBinary() || instr.isUnary());
+    }
+    
+    static Key keyOf(const IRInstr& instr) {
+        return makeKey(instr.op, instr.operands[0], instr.operands.size() > 1 ? instr.operands[1] : IRValue());
+    }
+    
+    // 分支的两个后继都只有这一个前驱时，两边都计算、且操作数都来自分支之前的表达式
+    // 移到分支块末尾；另一边的那份随后由值编号消掉。纯运算在 RV32 上不会陷入，可以提前执行
+    static bool hoistFromBranches(IRFunction& function) {
+        bool changed = false;
+        for (auto& block : function.blocks) {
+            if (!block->hasTerminator() || block->terminator().op != IRInstr::BRANCH) continue;
+            BasicBlock* left = block->terminator().targets[0];
+            BasicBlock* right = block->terminator().targets[1];
+            if (left == right || left->preds.size() != 1 || right->preds.size() != 1) continue;
+            
+            auto available = [](const BasicBlock& successor) {
+                std::map<Key, size_t> result;
+                std::unordered_map<int, bool> localDefs;
+                for (size_t i = 0; i < successor.instructions.size(); ++i) {
+                    const IRInstr& instr = successor.instructions[i];
+                    bool external = std::none_of(instr.operands.begin(), instr.operands.end(), [&localDefs](const IRValue& v) {
+                        return v.isVar() && localDefs.count(v.value);
+                    });
+                    if (isNumbered(instr) && external) result.emplace(keyOf(instr), i);
+                    if (instr.dst >= 0) localDefs[instr.dst] = true;
+                }
+                return result;
+            };
+            std::map<Key, size_t> leftExprs = available(*left);
+            std::map<Key, size_t> rightExprs = available(*right);
+            
+            std::vector<size_t> hoisted;
+            for (const auto& [key, index] : leftExprs) {
+                if (rightExprs.count(key)) hoisted.push_back(index);
+            }
+            if (hoisted.empty()) continue;
+            std::sort(hoisted.begin(), hoisted.end());
+            auto& target = block->instructions;
+            for (size_t index : hoisted) {
+                target.insert(target.end() - 1, left->instructions[index]);
+            }
+            for (size_t k = hoisted.size(); k-- > 0;) {
+                left->instructions.erase(left->instructions.begin() + hoisted[k]);
+            }
+            changed = true;
+        }
+        return changed;
+    }
+    
+    bool numberBlock(BasicBlock& block, std::vector<Key>& scope) {
+        bool changed = false;
+        auto& instrs = block.instructions;
+        size_t kept = 0;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            IRInstr& instr = instrs[i];
+            if (!instr.isPhi()) {
+                for (auto& operand : instr.operands) operand = resolve(operand);
+            }
+            
+            IRValue value;
+            if (isRedundant(instr, scope, value)) {
+                replacements[instr.dst] = value;
+                changed = true;
+                continue;
+            }
+            if (kept != i) instrs[kept] = std::move(instr);
+            ++kept;
+        }
+        instrs.erase(instrs.begin() + kept, instrs.end());
+        return changed;
+    }
+    
+    // 指令的值已经存在（或可以化简）时返回 true，并给出替代值；否则登记到当前作用域
+    bool isRedundant(const IRInstr& instr, std::vector<Key>& scope, IRValue& value) {
+        if (instr.dst < 0) return false;
+        switch (instr.op) {
+            case IRInstr::COPY:
+                value = instr.operands[0];
+                return true;
+            case IRInstr::PHI: {
+                // 除自身外所有来源都相同
+                IRValue common;
+                for (const auto& operand : instr.operands) {
+                    IRValue resolved = resolve(operand);
+                    if (resolved == IRValue::var(instr.dst)) continue;
+                    if (!common.isNone() && resolved != common) return false;
+                    common = resolved;
+                }
+                if (common.isNone()) return false;
+                value = common;
+                return true;
+            }
+            case IRInstr::CALL:
+                return false;
+            default:
+                break;
+        }
+        
+        IRValue a = instr.operands[0];
+        IRValue b = instr.operands.size() > 1 ? instr.operands[1] : IRValue();
+        if (instr.isBinary() && simplify(instr.op, a, b, value)) return true;
+        if (instr.isUnary() && a.isConst()) {
+            value = IRValue::constant(foldUnary(instr.op, a.value));
+            return true;
+        }
+        
+        Key key = makeKey(instr.op, a, b);
+        auto it = table.find(key);
+        if (it != table.end()) {
+            value = IRValue::var(it->second);
+            return true;
+        }
+        table[key] = instr.dst;
+        scope.push_back(key);
+        return false;
+    }
+};
+
+std::unique_ptr<IRPass> createGVNPass() {
+    return std::make_unique<GlobalValueNumberingPass>();
+}
@@ -0,0 +1,169 @@
+#include "opt/inliner.hpp"
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+int FunctionInliner::functionSize(const IRFunction& function) {
+    int size = 0;
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block->instructions) {
+            // 无条件跳转多半会在布局时消失，不计入规模
+            if (instr.op != IRInstr::JUMP) size++;
+        }
+    }
+    return size;
+}
+
+// Tarjan 算法：强连通分量按完成顺序输出，恰好是被调者在前
+std::vector<std::vector<IRFunction*>> FunctionInliner::callGraphSCCs(IRModule& module) {
+    std::unordered_map<IRFunction*, int> index, lowLink;
+    std::unordered_set<IRFunction*> onStack;
+    std::vector<IRFunction*> stack;
+    std::vector<std::vector<IRFunction*>> sccs;
+    int counter = 0;
+    
+    auto callees = [this](IRFunction* function) {
+        std::vector<IRFunction*> result;
+        for (const auto& block : function->blocks) {
+            for (const auto& instr : block->instructions) {
+                if (instr.op != IRInstr::CALL) continue;
+                auto it = byName.find(instr.callee);
+                if (it != byName.end()) result.push_back(it->second);
+            }
+        }
+        return result;
+    };
+    
+    auto visit = [&](auto& self, IRFunction* function) -> void {
+        index[function] = lowLink[function] = counter++;
+        stack.push_back(function);
+        onStack.insert(function);
+        for (IRFunction* callee : callees(function)) {
+            if (!index.count(callee)) {
+                self(self, callee);
+                lowLink[function] = std::min(lowLink[function], lowLink[callee]);
+            } else if (onStack.count(callee)) {
+                lowLink[function] = std::min(lowLink[function], index[callee]);
+            }
+        }
+        if (lowLink[function] != index[function]) return;
+        
+        std::vector<IRFunction*> scc;
+        IRFunction* member;
+        do {
+            member = stack.back();
+            stack.pop_back();
+            onStack.erase(member);
+            scc.push_back(member);
+        } while (member != function);
+        
+        bool isRecursive = scc.size() > 1;
+        for (IRFunction* callee : callees(function)) {
+            if (callee == function) isRecursive = true;
+        }
+        for (IRFunction* f : scc) recursive[f->name] = isRecursive;
+        sccs.push_back(std::move(scc));
+    };
+    
+    for (auto& function : module.functions) {
+        if (!index.count(function.get())) visit(visit, function.get());
+    }
+    return sccs;
+}
+
+bool FunctionInliner::shouldInline(const IRFunction& caller, const IRInstr& call) const {
+    auto it = byName.find(call.callee);
+    if (it == byName.end() || it->second == &caller) return false;
+    const IRFunction& callee = *it->second;
+    if (recursive.at(callee.name) || callee.params.size() != call.operands.size()) return false;
+    return functionSize(callee) <= threshold && functionSize(caller) <= MAX_CALLER_SIZE;
+}
+
+int FunctionInliner::run(IRModule& module) {
+    byName.clear();
+    recursive.clear();
+    for (auto& function : module.functions) {
+        byName[function->name] = function.get();
+    }
+    
+    int before = inlinedCalls;
+    for (const auto& scc : callGraphSCCs(module)) {
+        for (IRFunction* caller : scc) {
+            bool changed = false;
+            for (size_t b = 0; b < caller->blocks.size(); ++b) {
+                BasicBlock* block = caller->blocks[b].get();
+                for (size_t i = 0; i < block->instructions.size(); ++i) {
+                    const IRInstr& instr = block->instructions[i];
+                    if (instr.op != IRInstr::CALL || !shouldInline(*caller, instr)) continue;
+                    
+                    // 内联进来的函数体已经处理过，从剩余指令所在的块继续扫描
+                    BasicBlock* rest = inlineCall(*caller, block, i, *byName[instr.callee]);
+                    while (caller->blocks[b].get() != rest) ++b;
+                    block = rest;
+                    i = (size_t)-1;
+                    inlinedCalls++;
+                    changed = true;
+                }
+            }
+            if (changed) caller->rebuildCFG();
+        }
+    }
+    return inlinedCalls - before;
+}
+
+BasicBlock* FunctionInliner::inlineCall(IRFunction& caller, BasicBlock* block, size_t index, const IRFunction& callee) {
+    IRInstr call = block->instructions[index];
+    
+    // 调用之后的指令移到新的后继块
+    BasicBlock* rest = caller.newBlockAfter(block);
+    auto& instrs = block->instructions;
+    rest->instructions.assign(std::make_move_iterator(instrs.begin() + index + 1), std::make_move_iterator(instrs.end()));
+    instrs.erase(instrs.begin() + index, instrs.end());
+    
+    // 被调函数的变量全部换成调用者的新变量
+    std::vector<int> varMap(callee.numVars());
+    for (int v = 0; v < callee.numVars(); ++v) {
+        varMap[v] = caller.newVar(callee.varNames[v]);
+    }
+    auto mapValue = [&varMap](const IRValue& value) {
+        return value.isVar() ? IRValue::var(varMap[value.value]) : value;
+    };
+    
+    for (size_t i = 0; i < callee.params.size(); ++i) {
+        instrs.push_back(IRInstr(IRInstr::COPY, varMap[callee.params[i]], {call.operands[i]}));
+    }
+    
+    std::unordered_map<const BasicBlock*, BasicBlock*> blockMap;
+    BasicBlock* after = block;
+    for (const auto& calleeBlock : callee.blocks) {
+        after = caller.newBlockAfter(after);
+        blockMap[calleeBlock.get()] = after;
+    }
+    
+    for (const auto& calleeBlock : callee.blocks) {
+        BasicBlock* clone = blockMap[calleeBlock.get()];
+        for (const auto& instr : calleeBlock->instructions) {
+            if (instr.op == IRInstr::RET) {
+                // return 变成对结果变量的赋值，再跳到调用点之后
+                if (call.dst >= 0) {
+                    IRValue value = instr.operands.empty() ? IRValue::constant(0) : mapValue(instr.operands[0]);
+                    clone->instructions.push_back(IRInstr(IRInstr::COPY, call.dst, {value}));
+                }
+                IRInstr jump(IRInstr::JUMP);
+                jump.targets.push_back(rest);
+                clone->instructions.push_back(std::move(jump));
+                continue;
+            }
+            IRInstr copy = instr;
+            if (copy.dst >= 0) copy.dst = varMap[copy.dst];
+            for (auto& operand : copy.operands) operand = mapValue(operand);
+            for (auto& target : copy.targets) target = blockMap[target];
+            clone->instructions.push_back(std::move(copy));
+        }
+    }
+    
+    IRInstr jump(IRInstr::JUMP);
+    jump.targets.push_back(blockMap[callee.entry()]);
+    instrs.push_back(std::move(jump));
+    return rest;
+}
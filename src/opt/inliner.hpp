@@ -0,0 +1,36 @@
+#pragma once
+#include "ir/ir.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 函数内联：把规模不超过阈值的非递归函数的调用点替换为被调函数体的副本。
+// 按调用图自底向上处理，被调函数自身的调用点先内联完毕再被复制；
+// 调用图强连通分量内的函数（含自递归）一律不内联。
+// 在 SSA 构建之前运行，实参中的常量随后由 SCCP 传播进内联进来的代码。
+class FunctionInliner {
+public:
+    static const int DEFAULT_THRESHOLD = 40;     // 被调函数的指令数上限
+    static const int MAX_CALLER_SIZE = 2000;     // 调用者膨胀到这个规模后不再内联
+    
+    explicit FunctionInliner(int sizeThreshold = DEFAULT_THRESHOLD) : threshold(sizeThreshold), inlinedCalls(0) {}
+    
+    // 返回本次内联的调用点个数
+    int run(IRModule& module);
+    int getInlinedCalls() const { return inlinedCalls; }
+    
+    static int functionSize(const IRFunction& function);
+    
+private:
+    int threshold;
+    int inlinedCalls;
+    
+    std::unordered_map<std::string, IRFunction*> byName;
+    std::unordered_map<std::string, bool> recursive;
+    
+    // 调用图的强连通分量，按逆拓扑序（被调者在前）排列
+    std::vector<std::vector<IRFunction*>> callGraphSCCs(IRModule& module);
+    bool shouldInline(const IRFunction& caller, const IRInstr& call) const;
+    // 内联 block 中第 index 条调用指令，返回调用之后剩余指令所在的新块
+    BasicBlock* inlineCall(IRFunction& caller, BasicBlock* block, size_t index, const IRFunction& callee);
+};
@@ -0,0 +1,80 @@
+#include "opt/passes.hpp"
+#include "ir/loops.hpp"
+#include <unordered_set>
+
+// 循环不变量外提（要求 SSA 形式）：操作数全部在循环外定义的纯运算移到循环前置块。
+// RV32 的除法、取余不会陷入异常，因此即使原位置并非每轮都执行，提前计算也是安全的。
+// 内层循环先处理，提到内层前置块的指令在处理外层循环时还可以继续外提。
+class LoopInvariantCodeMotionPass : public IRPass {
+public:
+    const char* name() const override { return "licm"; }
+    
+    bool run(IRFunction& function) override {
+        bool changed = false;
+        {
+            DominatorTree domTree(function);
+            LoopInfo loopInfo(domTree);
+            for (const Loop& loop : loopInfo.loops()) {
+                if (!loop.preheader() && insertPreheader(function, loop)) changed = true;
+            }
+        }
+        
+        // 前置块改变了 CFG，重新识别循环
+        DominatorTree domTree(function);
+        LoopInfo loopInfo(domTree);
+        for (const Loop& loop : loopInfo.loops()) {
+            BasicBlock* preheader = loop.preheader();
+            if (preheader && hoist(function, loop, preheader)) changed = true;
+        }
+        return changed;
+    }
+    
+private:
+    static bool isHoistable(const IRInstr& instr) {
+        return instr.dst >= 0 && (instr.isBinary() || instr.isUnary() || instr.op == IRInstr::COPY);
+    }
+    
+    static bool hoist(IRFunction& function, const Loop& loop, BasicBlock* preheader) {
+        std::unordered_set<int> loopDefs;
+        for (auto& block : function.blocks) {
+            if (!loop.contains(block.get())) continue;
+            for (const auto& instr : block->instructions) {
+                if (instr.dst >= 0) loopDefs.insert(instr.dst);
+            }
+        }
+        
+        auto isInvariant = [&loopDefs](const IRInstr& instr) {
+            for (const auto& operand : instr.operands) {
+                if (operand.isVar() && loopDefs.count(operand.value)) return false;
+            }
+            return true;
+        };
+        
+        // 按布局顺序反复扫描，外提一条指令可能使依赖它的指令也变为不变量
+        bool hoisted = false;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (auto& block : function.blocks) {
+                if (!loop.contains(block.get())) continue;
+                auto& instrs = block->instructions;
+                for (size_t i = 0; i < instrs.size();) {
+                    if (!isHoistable(instrs[i]) || !isInvariant(instrs[i])) {
+                        ++i;
+                        continue;
+                    }
+                    loopDefs.erase(instrs[i].dst);
+                    auto& target = preheader->instructions;
+                    target.insert(target.end() - 1, std::move(instrs[i]));
+                    instrs.erase(instrs.begin() + i);
+                    progress = hoisted = true;
+                }
+            }
+        }
+        return hoisted;
+    }
+};
+
+std::unique_ptr<IRPass> createLICMPass() {
+    return std::make_unique<LoopInvariantCodeMotionPass>();
+}
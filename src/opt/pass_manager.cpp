@@ -0,0 +1,91 @@
+#include "opt/passes.hpp"
+#include "opt/inliner.hpp"
+#include "common/time_report.hpp"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+void PassManager::addDefaultPipeline() {
+    inlineThreshold = FunctionInliner::DEFAULT_THRESHOLD;
+    add(createSimplifyCFGPass());
+    add(createTailRecursionPass());
+    add(createSSAConstructionPass());
+    add(createSCCPPass());
+    add(createGVNPass());
+    add(createDeadCodeEliminationPass());
+    add(createLICMPass());
+    add(createStrengthReductionPass());
+    add(createDeadCodeEliminationPass());
+    add(createSimplifyCFGPass());
+    add(createSSADestructionPass());
+}
+
+void PassManager::run(IRModule& module) {
+    runInliner(module);
+    for (auto& function : module.functions) {
+        run(*function);
+    }
+    // 调用点全部被内联的函数此时已不可达
+    removeUnreachableFunctions(module);
+}
+
+void PassManager::runInliner(IRModule& module) {
+    removeUnreachableFunctions(module);
+    if (inlineThreshold > 0) {
+        FunctionInliner inliner(inlineThreshold);
+        inlinedCalls += inliner.run(module);
+    }
+}
+
+static int64_t instructionCount(const IRFunction& function) {
+    int64_t count = 0;
+    for (const auto& block : function.blocks) {
+        count += (int64_t)block->instructions.size();
+    }
+    return count;
+}
+
+void PassManager::run(IRFunction& function) {
+    if (!timeReport) {
+        for (auto& pass : passes) {
+            pass->run(function);
+        }
+        return;
+    }
+    for (size_t i = 0; i < passes.size(); ++i) {
+        int64_t before = instructionCount(function);
+        auto start = std::chrono::steady_clock::now();
+        bool changed = passes[i]->run(function);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        timeReport->addPass(i, passes[i]->name(), seconds, changed, before - instructionCount(function));
+    }
+}
+
+int PassManager::removeUnreachableFunctions(IRModule& module) {
+    std::unordered_map<std::string, IRFunction*> byName;
+    for (auto& function : module.functions) {
+        byName[function->name] = function.get();
+    }
+    if (!byName.count("main")) return 0;
+    
+    std::unordered_set<std::string> reachable = {"main"};
+    std::vector<IRFunction*> worklist = {byName["main"]};
+    while (!worklist.empty()) {
+        IRFunction* function = worklist.back();
+        worklist.pop_back();
+        for (const auto& block : function->blocks) {
+            for (const auto& instr : block->instructions) {
+                if (instr.op != IRInstr::CALL || !reachable.insert(instr.callee).second) continue;
+                auto it = byName.find(instr.callee);
+                if (it != byName.end()) worklist.push_back(it->second);
+            }
+        }
+    }
+    
+    size_t before = module.functions.size();
+    module.functions.erase(std::remove_if(module.functions.begin(), module.functions.end(),
+        [&reachable](const std::unique_ptr<IRFunction>& function) { return !reachable.count(function->name); }),
+        module.functions.end());
+    return (int)(before - module.functions.size());
+}
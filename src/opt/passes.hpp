@@ -0,0 +1,55 @@
+#pragma once
+#include "ir/ir.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+class TimeReport;
+
+// IR 上的优化遍
+class IRPass {
+public:
+    virtual ~IRPass() = default;
+    virtual const char* name() const = 0;
+    // 返回是否修改了函数
+    virtual bool run(IRFunction& function) = 0;
+};
+
+// 按顺序对每个函数运行一组优化遍
+class PassManager {
+private:
+    std::vector<std::unique_ptr<IRPass>> passes;
+    int inlineThreshold;  // 0 表示不内联
+    int inlinedCalls;
+    TimeReport* timeReport;  // 非空时记录每个遍的耗时与增删的指令数
+    
+public:
+    PassManager() : inlineThreshold(0), inlinedCalls(0), timeReport(nullptr) {}
+    
+    void add(std::unique_ptr<IRPass> pass) { passes.push_back(std::move(pass)); }
+    void setInlineThreshold(int threshold) { inlineThreshold = threshold; }
+    int getInlinedCalls() const { return inlinedCalls; }
+    void setTimeReport(TimeReport* report) { timeReport = report; }
+    
+    // -opt 使用的默认优化流水线（含默认阈值的内联）
+    void addDefaultPipeline();
+    
+    // 先在模块范围内做内联，再优化每个函数，最后删除从 main 出发调用不到的函数
+    void run(IRModule& module);
+    void run(IRFunction& function);
+    // run(IRModule&) 的模块范围部分：删除不可达函数后内联。增量编译先做这一步，只对需要重新生成的函数调用 run(IRFunction&)
+    void runInliner(IRModule& module);
+    
+    static int removeUnreachableFunctions(IRModule& module);
+};
+
+// 各优化遍
+std::unique_ptr<IRPass> createSimplifyCFGPass();
+std::unique_ptr<IRPass> createTailRecursionPass();
+std::unique_ptr<IRPass> createSSAConstructionPass();
+std::unique_ptr<IRPass> createSCCPPass();
+std::unique_ptr<IRPass> createGVNPass();
+std::unique_ptr<IRPass> createDeadCodeEliminationPass();
+std::unique_ptr<IRPass> createLICMPass();
+std::unique_ptr<IRPass> createStrengthReductionPass();
+std::unique_ptr<IRPass> createSSADestructionPass();
@@ -0,0 +1,236 @@
+#include "opt/passes.hpp"
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+// 稀疏条件常量传播（Wegman & Zadeck），要求函数处于 SSA 形式。
+// 同时沿 SSA 边和“可执行”的 CFG 边传播格值，因此不会被永远不执行的分支拉低；
+// 结束后把常量代入所有使用点，常量条件的分支改成 jump，不可达的块随之删除。
+class SCCPPass : public IRPass {
+public:
+    const char* name() const override { return "sccp"; }
+    
+    bool run(IRFunction& function) override {
+        analyze(function);
+        return rewrite(function);
+    }
+    
+private:
+    enum State { TOP, CONSTANT, BOTTOM };
+    
+    struct Lattice {
+        State state;
+        int value;
+    };
+    
+    struct Use {
+        BasicBlock* block;
+        IRInstr* instr;
+    };
+    
+    std::vector<Lattice> values;
+    std::vector<std::vector<Use>> uses;
+    std::unordered_set<const BasicBlock*> executableBlocks;
+    std::set<std::pair<int, int>> executableEdges;  // (前驱 id, 后继 id)
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> cfgWorklist;
+    std::vector<int> ssaWorklist;
+    
+    Lattice valueOf(const IRValue& value) const {
+        if (value.isConst()) return {CONSTANT, value.value};
+        if (value.isVar()) return values[value.value];
+        return {BOTTOM, 0};
+    }
+    
+    void update(int var, Lattice lattice) {
+        Lattice& old = values[var];
+        if (old.state == lattice.state && (lattice.state != CONSTANT || old.value == lattice.value)) return;
+        // 格值只会下降：TOP -> 常量 -> BOTTOM
+        if (old.state == CONSTANT && lattice.state == CONSTANT) lattice.state = BOTTOM;
+        if (old.state == BOTTOM) return;
+        old = lattice;
+        ssaWorklist.push_back(var);
+    }
+    
+    static Lattice meet(Lattice a, Lattice b) {
+        if (a.state == TOP) return b;
+        if (b.state == TOP) return a;
+        if (a.state == CONSTANT && b.state == CONSTANT && a.value == b.value) return a;
+        return {BOTTOM, 0};
+    }
+    
+    void analyze(IRFunction& function) {
+        values.assign(function.numVars(), {TOP, 0});
+        uses.assign(function.numVars(), {});
+        executableBlocks.clear();
+        executableEdges.clear();
+        cfgWorklist.clear();
+        ssaWorklist.clear();
+        
+        for (int param : function.params) {
+            values[param] = {BOTTOM, 0};
+        }
+        for (auto& block : function.blocks) {
+            for (auto& instr : block->instructions) {
+                for (const auto& operand : instr.operands) {
+                    if (operand.isVar()) uses[operand.value].push_back({block.get(), &instr});
+                }
+            }
+        }
+        
+        cfgWorklist.push_back({nullptr, function.entry()});
+        while (!cfgWorklist.empty() || !ssaWorklist.empty()) {
+            while (!cfgWorklist.empty()) {
+                auto [from, to] = cfgWorklist.back();
+                cfgWorklist.pop_back();
+                if (from && !executableEdges.insert({from->id, to->id}).second) continue;
+                
+                bool firstVisit = executableBlocks.insert(to).second;
+                for (auto& instr : to->instructions) {
+                    if (!firstVisit && !instr.isPhi()) break;
+                    visit(to, instr);
+                }
+            }
+            while (!ssaWorklist.empty()) {
+                int var = ssaWorklist.back();
+                ssaWorklist.pop_back();
+                for (const Use& use : uses[var]) {
+                    if (executableBlocks.count(use.block)) visit(use.block, *use.instr);
+                }
+            }
+        }
+    }
+    
+    void visit(BasicBlock* block, IRInstr& instr) {
+        switch (instr.op) {
+            case IRInstr::PHI: {
+                Lattice result = {TOP, 0};
+                for (size_t i = 0; i < instr.operands.size(); ++i) {
+                    if (executableEdges.count({instr.targets[i]->id, block->id})) {
+                        result = meet(result, valueOf(instr.operands[i]));
+                    }
+                }
+                update(instr.dst, result);
+                return;
+            }
+            case IRInstr::JUMP:
+                cfgWorklist.push_back({block, instr.targets[0]});
+                return;
+            case IRInstr::BRANCH: {
+                Lattice cond = valueOf(instr.operands[0]);
+                if (cond.state == BOTTOM || (cond.state == CONSTANT && cond.value)) {
+                    cfgWorklist.push_back({block, instr.targets[0]});
+                }
+                if (cond.state == BOTTOM || (cond.state == CONSTANT && !cond.value)) {
+                    cfgWorklist.push_back({block, instr.targets[1]});
+                }
+                return;
+            }
+            case IRInstr::RET:
+                return;
+            case IRInstr::CALL:
+                if (instr.dst >= 0) update(instr.dst, {BOTTOM, 0});
+                return;
+            case IRInstr::COPY:
+                update(instr.dst, valueOf(instr.operands[0]));
+                return;
+            default:
+                break;
+        }
+        
+        if (instr.isUnary()) {
+            Lattice operand = valueOf(instr.operands[0]);
+            if (operand.state == CONSTANT) operand.value = foldUnary(instr.op, operand.value);
+            update(instr.dst, operand);
+            return;
+        }
+        
+        Lattice lhs = valueOf(instr.operands[0]);
+        Lattice rhs = valueOf(instr.operands[1]);
+        // 一侧常量即可确定结果的情形
+        auto isConst = [](const Lattice& l, int v) { return l.state == CONSTANT && l.value == v; };
+        if ((instr.op == IRInstr::MUL || instr.op == IRInstr::AND) && (isConst(lhs, 0) || isConst(rhs, 0))) {
+            update(instr.dst, {CONSTANT, 0});
+            return;
+        }
+        if (instr.op == IRInstr::OR && ((lhs.state == CONSTANT && lhs.value) || (rhs.state == CONSTANT && rhs.value))) {
+            update(instr.dst, {CONSTANT, 1});
+            return;
+        }
+        
+        if (lhs.state == BOTTOM || rhs.state == BOTTOM) {
+            update(instr.dst, {BOTTOM, 0});
+        } else if (lhs.state == TOP || rhs.state == TOP) {
+            return;
+        } else {
+            int result;
+            if (foldBinary(instr.op, lhs.value, rhs.value, result)) {
+                update(instr.dst, {CONSTANT, result});
+            } else {
+                update(instr.dst, {BOTTOM, 0});
+            }
+        }
+    }
+    
+    bool rewrite(IRFunction& function) {
+        bool changed = false;
+        for (auto& block : function.blocks) {
+            if (!executableBlocks.count(block.get())) continue;
+            auto& instrs = block->instructions;
+            for (size_t i = 0; i < instrs.size();) {
+                IRInstr& instr = instrs[i];
+                if (instr.dst >= 0 && instr.op != IRInstr::CALL && values[instr.dst].state == CONSTANT) {
+                    instrs.erase(instrs.begin() + i);
+                    changed = true;
+                    continue;
+                }
+                for (auto& operand : instr.operands) {
+                    if (operand.isVar() && values[operand.value].state == CONSTANT) {
+                        operand = IRValue::constant(values[operand.value].value);
+                        changed = true;
+                    }
+                }
+                if (instr.op == IRInstr::BRANCH && instr.operands[0].isConst()) {
+                    IRInstr jump(IRInstr::JUMP);
+                    jump.targets = {instr.targets[instr.operands[0].value ? 0 : 1]};
+                    instr = std::move(jump);
+                    changed = true;
+                }
+                ++i;
+            }
+        }
+        changed |= function.removeUnreachableBlocks();
+        
+        // 除自身外只剩一个来源的 phi 退化为 copy，放到其余 phi 之后以保持 phi 位于块首
+        for (auto& block : function.blocks) {
+            auto& instrs = block->instructions;
+            std::vector<IRInstr> phis;
+            std::vector<IRInstr> copies;
+            size_t phiCount = 0;
+            for (; phiCount < instrs.size() && instrs[phiCount].isPhi(); ++phiCount) {
+                IRInstr& phi = instrs[phiCount];
+                IRValue incoming;
+                bool trivial = true;
+                for (const auto& operand : phi.operands) {
+                    if (operand == IRValue::var(phi.dst) || operand == incoming) continue;
+                    trivial &= incoming.isNone();
+                    incoming = operand;
+                }
+                if (trivial && !incoming.isNone()) {
+                    copies.push_back(IRInstr(IRInstr::COPY, phi.dst, {incoming}));
+                } else {
+                    phis.push_back(phi);
+                }
+            }
+            if (copies.empty()) continue;
+            phis.insert(phis.end(), copies.begin(), copies.end());
+            std::move(phis.begin(), phis.end(), instrs.begin());
+            changed = true;
+        }
+        return changed;
+    }
+};
+
+std::unique_ptr<IRPass> createSCCPPass() {
+    return std::make_unique<SCCPPass>();
+}
@@ -0,0 +1,122 @@
+#include "opt/passes.hpp"
+#include <algorithm>
+
+// 控制流图化简：常量条件分支、跳转穿透、不可达块删除、直线块合并
+class SimplifyCFGPass : public IRPass {
+public:
+    const char* name() const override { return "simplify-cfg"; }
+    
+    bool run(IRFunction& function) override {
+        bool changed = false;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            progress |= foldBranches(function);
+            progress |= threadJumps(function);
+            progress |= function.removeUnreachableBlocks();
+            progress |= mergeBlocks(function);
+            changed |= progress;
+        }
+        return changed;
+    }
+    
+private:
+    // br 常量 / br x, L, L  =>  jump
+    static bool foldBranches(IRFunction& function) {
+        bool changed = false;
+        for (auto& block : function.blocks) {
+            if (!block->hasTerminator()) continue;
+            IRInstr& term = block->terminator();
+            if (term.op != IRInstr::BRANCH) continue;
+            
+            BasicBlock* target = nullptr;
+            if (term.operands[0].isConst()) {
+                target = term.operands[0].value ? term.targets[0] : term.targets[1];
+            } else if (term.targets[0] == term.targets[1]) {
+                target = term.targets[0];
+            }
+            if (target) {
+                IRInstr jump(IRInstr::JUMP);
+                jump.targets = {target};
+                term = std::move(jump);
+                changed = true;
+            }
+        }
+        if (changed) function.rebuildCFG();
+        return changed;
+    }
+    
+    // 只含一条 jump 的块：让所有跳向它的地方直接跳到最终目标
+    static BasicBlock* forwardTarget(BasicBlock* block) {
+        BasicBlock* target = block;
+        for (int hops = 0; hops < 16; ++hops) {
+            if (target->instructions.size() != 1 || target->terminator().op != IRInstr::JUMP) break;
+            BasicBlock* next = target->terminator().targets[0];
+            if (next == target) break;
+            target = next;
+        }
+        return target;
+    }
+    
+    static bool startsWithPhi(const BasicBlock* block) {
+        return !block->instructions.empty() && block->instructions.front().isPhi();
+    }
+    
+    static bool threadJumps(IRFunction& function) {
+        bool changed = false;
+        for (auto& block : function.blocks) {
+            if (!block->hasTerminator()) continue;
+            for (BasicBlock*& target : block->terminator().targets) {
+                BasicBlock* forwarded = forwardTarget(target);
+                // 目标块有 phi 时改动前驱会打乱 phi 的来源，保持原样
+                if (forwarded != target && !startsWithPhi(forwarded)) {
+                    target = forwarded;
+                    changed = true;
+                }
+            }
+        }
+        if (changed) function.rebuildCFG();
+        return changed;
+    }
+    
+    // A 以 jump 结尾且唯一后继 B 只有 A 一个前驱时，把 B 并入 A
+    static bool mergeBlocks(IRFunction& function) {
+        bool changed = false;
+        for (size_t i = 0; i < function.blocks.size(); ++i) {
+            BasicBlock* block = function.blocks[i].get();
+            while (block->hasTerminator() && block->terminator().op == IRInstr::JUMP) {
+                BasicBlock* succ = block->terminator().targets[0];
+                if (succ == block || succ == function.entry() || succ->preds.size() != 1) break;
+                
+                block->instructions.pop_back();
+                for (auto& instr : succ->instructions) {
+                    // 只有一个前驱的 phi 就是一次 copy
+                    if (instr.isPhi()) {
+                        IRValue value = instr.operands[0];
+                        instr = IRInstr(IRInstr::COPY, instr.dst, {value});
+                    }
+                    block->instructions.push_back(std::move(instr));
+                }
+                // succ 的后继里以 succ 为来源的 phi 改为来自 block
+                for (BasicBlock* next : succ->succs) {
+                    for (auto& instr : next->instructions) {
+                        if (!instr.isPhi()) break;
+                        for (BasicBlock*& incoming : instr.targets) {
+                            if (incoming == succ) incoming = block;
+                        }
+                    }
+                }
+                succ->instructions.clear();
+                function.blocks.erase(std::find_if(function.blocks.begin(), function.blocks.end(),
+                    [succ](const std::unique_ptr<BasicBlock>& b) { return b.get() == succ; }));
+                function.rebuildCFG();
+                changed = true;
+            }
+        }
+        return changed;
+    }
+};
+
+std::unique_ptr<IRPass> createSimplifyCFGPass() {
+    return std::make_unique<SimplifyCFGPass>();
+}
@@ -0,0 +1,377 @@
+#include "opt/passes.hpp"
+#include "ir/dominators.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+// 构造 SSA（Cytron 等）：在定义块的迭代支配边界上插入 phi，再沿支配树重命名。
+// 只为跨块活跃的变量插 phi（semi-pruned SSA），路径上没有定义的变量视为 0。
+class SSAConstructionPass : public IRPass {
+public:
+    const char* name() const override { return "ssa"; }
+    
+    bool run(IRFunction& function) override {
+        function.removeUnreachableBlocks();
+        DominatorTree domTree(function);
+        int originalVars = function.numVars();
+        
+        // 跨块活跃的变量及其定义块
+        std::vector<bool> global(originalVars, false);
+        std::vector<std::vector<BasicBlock*>> defBlocks(originalVars);
+        for (auto& block : function.blocks) {
+            std::unordered_set<int> defined;
+            for (const auto& instr : block->instructions) {
+                for (const auto& operand : instr.operands) {
+                    if (operand.isVar() && !defined.count(operand.value)) global[operand.value] = true;
+                }
+                if (instr.dst >= 0 && defined.insert(instr.dst).second) {
+                    defBlocks[instr.dst].push_back(block.get());
+                }
+            }
+        }
+        
+        // 插入 phi；phiVars 记录每个块开头各 phi 对应的原变量
+        std::unordered_map<const BasicBlock*, std::vector<int>> phiVars;
+        for (int var = 0; var < originalVars; ++var) {
+            if (!global[var] || defBlocks[var].empty()) continue;
+            std::vector<BasicBlock*> worklist = defBlocks[var];
+            std::unordered_set<BasicBlock*> hasPhi;
+            while (!worklist.empty()) {
+                BasicBlock* block = worklist.back();
+                worklist.pop_back();
+                for (BasicBlock* join : domTree.frontier(block)) {
+                    if (!hasPhi.insert(join).second) continue;
+                    IRInstr phi(IRInstr::PHI, var, std::vector<IRValue>(join->preds.size(), IRValue::constant(0)));
+                    phi.targets = join->preds;
+                    join->instructions.insert(join->instructions.begin(), std::move(phi));
+                    phiVars[join].insert(phiVars[join].begin(), var);
+                    worklist.push_back(join);
+                }
+            }
+        }
+        
+        rename(function, domTree, phiVars, originalVars);
+        return true;
+    }
+    
+private:
+    static void rename(IRFunction& function, const DominatorTree& domTree,
+                       std::unordered_map<const BasicBlock*, std::vector<int>>& phiVars, int originalVars) {
+        std::vector<std::vector<int>> stacks(originalVars);
+        for (int param : function.params) {
+            stacks[param].push_back(param);
+        }
+        auto current = [&stacks](int var) {
+            return stacks[var].empty() ? IRValue::constant(0) : IRValue::var(stacks[var].back());
+        };
+        
+        // 沿支配树的非递归先序遍历；离开块时弹出它压入的名字
+        struct Frame {
+            BasicBlock* block;
+            std::vector<int> pushed;
+            size_t nextChild;
+        };
+        std::vector<Frame> frames;
+        frames.push_back({function.entry(), {}, 0});
+        bool entering = true;
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            BasicBlock* block = frame.block;
+            if (entering) {
+                const std::vector<int>& phis = phiVars[block];
+                for (size_t i = 0; i < block->instructions.size(); ++i) {
+                    IRInstr& instr = block->instructions[i];
+                    if (!instr.isPhi()) {
+                        for (auto& operand : instr.operands) {
+                            if (operand.isVar() && operand.value < originalVars) operand = current(operand.value);
+                        }
+                    }
+                    if (instr.dst >= 0) {
+                        int var = instr.isPhi() ? phis[i] : instr.dst;
+                        instr.dst = function.newVar(function.varNames[var]);
+                        stacks[var].push_back(instr.dst);
+                        frame.pushed.push_back(var);
+                    }
+                }
+                for (BasicBlock* succ : block->succs) {
+                    const std::vector<int>& succPhis = phiVars[succ];
+                    for (size_t i = 0; i < succPhis.size(); ++i) {
+                        IRInstr& phi = succ->instructions[i];
+                        for (size_t k = 0; k < phi.targets.size(); ++k) {
+                            if (phi.targets[k] == block) phi.operands[k] = current(succPhis[i]);
+                        }
+                    }
+                }
+            }
+            
+            const auto& children = domTree.children(block);
+            if (frame.nextChild < children.size()) {
+                BasicBlock* child = children[frame.nextChild++];
+                frames.push_back({child, {}, 0});
+                entering = true;
+            } else {
+                for (int var : frame.pushed) {
+                    stacks[var].pop_back();
+                }
+                frames.pop_back();
+                entering = false;
+            }
+        }
+    }
+};
+
+// 退出 SSA：先把互不干涉的 phi 相关变量合并成同一个变量（phi 网合并），
+// 再把每个 phi 换成前驱末尾的并行复制并顺序化；合并后不再需要的复制直接消失。
+// 复制只在关键边（来自条件分支、且目标有多个前驱）上需要新块
+class SSADestructionPass : public IRPass {
+public:
+    const char* name() const override { return "out-of-ssa"; }
+    
+    bool run(IRFunction& function) override {
+        std::vector<BasicBlock*> joins;
+        for (auto& block : function.blocks) {
+            if (!block->instructions.empty() && block->instructions.front().isPhi()) joins.push_back(block.get());
+        }
+        if (joins.empty()) return false;
+        coalescePhiWebs(function);
+        
+        bool split = false;
+        for (BasicBlock* block : joins) {
+            auto& instrs = block->instructions;
+            size_t phiCount = 0;
+            while (phiCount < instrs.size() && instrs[phiCount].isPhi()) ++phiCount;
+            
+            std::vector<BasicBlock*> preds = block->preds;
+            for (BasicBlock* pred : preds) {
+                std::vector<std::pair<int, IRValue>> copies;
+                for (size_t i = 0; i < phiCount; ++i) {
+                    const IRInstr& phi = instrs[i];
+                    auto incoming = std::find(phi.targets.begin(), phi.targets.end(), pred);
+                    if (incoming != phi.targets.end()) {
+                        copies.push_back({phi.dst, phi.operands[incoming - phi.targets.begin()]});
+                    }
+                }
+                std::vector<IRInstr> sequence = sequentializeCopies(function, std::move(copies));
+                if (sequence.empty()) continue;
+                if (pred->terminator().op != IRInstr::BRANCH) {
+                    pred->instructions.insert(pred->instructions.end() - 1, sequence.begin(), sequence.end());
+                } else if (preds.size() == 1) {
+                    instrs.insert(instrs.begin() + phiCount, sequence.begin(), sequence.end());
+                } else {
+                    BasicBlock* edge = splitEdge(function, pred, block);
+                    edge->instructions.insert(edge->instructions.begin(), sequence.begin(), sequence.end());
+                    split = true;
+                }
+            }
+            instrs.erase(instrs.begin(), instrs.begin() + phiCount);
+        }
+        if (split) function.rebuildCFG();
+        return true;
+    }
+    
+private:
+    // 在条件分支 pred 到 block 的关键边上插入只含 jump 的新块并返回它
+    static BasicBlock* splitEdge(IRFunction& function, BasicBlock* pred, BasicBlock* block) {
+        BasicBlock* edge = function.newBlockAfter(pred);
+        IRInstr jump(IRInstr::JUMP);
+        jump.targets = {block};
+        edge->instructions.push_back(std::move(jump));
+        for (BasicBlock*& target : pred->terminator().targets) {
+            if (target == block) target = edge;
+        }
+        return edge;
+    }
+    
+    // 并行复制顺序化：先发出目标不再被读取的复制，剩下的环借一个临时变量打开
+    static std::vector<IRInstr> sequentializeCopies(IRFunction& function, std::vector<std::pair<int, IRValue>> copies) {
+        copies.erase(std::remove_if(copies.begin(), copies.end(), [](const std::pair<int, IRValue>& copy) {
+            return copy.second == IRValue::var(copy.first);
+        }), copies.end());
+        
+        std::vector<IRInstr> sequence;
+        while (!copies.empty()) {
+            bool emitted = false;
+            for (size_t i = 0; i < copies.size(); ++i) {
+                int dst = copies[i].first;
+                bool stillRead = std::any_of(copies.begin(), copies.end(), [dst](const std::pair<int, IRValue>& other) {
+                    return other.second == IRValue::var(dst);
+                });
+                if (!stillRead) {
+                    sequence.push_back(IRInstr(IRInstr::COPY, dst, {copies[i].second}));
+                    copies.erase(copies.begin() + i);
+                    emitted = true;
+                    break;
+                }
+            }
+            if (!emitted) {
+                int dst = copies[0].first;
+                int temp = function.newVar();
+                sequence.push_back(IRInstr(IRInstr::COPY, temp, {IRValue::var(dst)}));
+                for (auto& copy : copies) {
+                    if (copy.second == IRValue::var(dst)) copy.second = IRValue::var(temp);
+                }
+            }
+        }
+        return sequence;
+    }
+        
+    // phi 网合并（Budimlic 等）：phi 的目标与它的变量操作数在互不干涉时并入同一个类，整类改用一个变量。
+    // 干涉按 SSA 的性质判断：两个变量干涉当且仅当一个在另一个的定义点之后仍活跃；
+    // phi 的操作数算作在对应前驱末尾使用，phi 的目标在所在块的开头定义。
+    // 前驱末尾的复制写入的类中没有别的成员在那里活跃，因此合并后并行复制的语义不变
+    static void coalescePhiWebs(IRFunction& function) {
+        // 只关心出现在 phi 中的变量，给它们连续编号
+        std::vector<int> index(function.numVars(), -1);
+        std::vector<int> vars;
+        auto related = [&](int var) {
+            if (index[var] < 0) {
+                index[var] = (int)vars.size();
+                vars.push_back(var);
+            }
+        };
+        for (auto& block : function.blocks) {
+            for (const auto& instr : block->instructions) {
+                if (!instr.isPhi()) break;
+                related(instr.dst);
+                for (const auto& operand : instr.operands) {
+                    if (operand.isVar()) related(operand.value);
+                }
+            }
+        }
+        
+        // 定义点：块和块内下标，phi 为 -1，形参为入口块的 -2；以及各变量在 phi 之外的使用点
+        int count = (int)vars.size();
+        std::vector<const BasicBlock*> defBlock(count, nullptr);
+        std::vector<int> defIndex(count, 0);
+        std::vector<std::vector<std::pair<const BasicBlock*, int>>> uses(count);
+        for (int param : function.params) {
+            if (index[param] >= 0) {
+                defBlock[index[param]] = function.entry();
+                defIndex[index[param]] = -2;
+            }
+        }
+        std::unordered_map<const BasicBlock*, int> blockIndex;
+        for (auto& block : function.blocks) {
+            blockIndex[block.get()] = (int)blockIndex.size();
+            for (int i = 0; i < (int)block->instructions.size(); ++i) {
+                const IRInstr& instr = block->instructions[i];
+                if (instr.dst >= 0 && index[instr.dst] >= 0) {
+                    defBlock[index[instr.dst]] = block.get();
+                    defIndex[index[instr.dst]] = instr.isPhi() ? -1 : i;
+                }
+                if (instr.isPhi()) continue;
+                for (const auto& operand : instr.operands) {
+                    if (operand.isVar() && index[operand.value] >= 0) uses[index[operand.value]].push_back({block.get(), i});
+                }
+            }
+        }
+        
+        // 块出口处的活跃性（只对 phi 相关的变量）
+        size_t blockCount = function.blocks.size();
+        std::vector<std::vector<bool>> use(blockCount, std::vector<bool>(count, false));
+        std::vector<std::vector<bool>> def(blockCount, std::vector<bool>(count, false));
+        std::vector<std::vector<bool>> liveIn(blockCount, std::vector<bool>(count, false));
+        std::vector<std::vector<bool>> liveOut(blockCount, std::vector<bool>(count, false));
+        for (int v = 0; v < count; ++v) {
+            if (defBlock[v]) def[blockIndex[defBlock[v]]][v] = true;
+            for (const auto& site : uses[v]) {
+                int b = blockIndex[site.first];
+                if (!(defBlock[v] == site.first && defIndex[v] < site.second)) use[b][v] = true;
+            }
+        }
+        for (auto& block : function.blocks) {
+            for (const auto& phi : block->instructions) {
+                if (!phi.isPhi()) break;
+                for (size_t k = 0; k < phi.operands.size(); ++k) {
+                    if (phi.operands[k].isVar()) liveOut[blockIndex[phi.targets[k]]][index[phi.operands[k].value]] = true;
+                }
+            }
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int b = (int)blockCount - 1; b >= 0; --b) {
+                const BasicBlock* block = function.blocks[b].get();
+                for (const BasicBlock* succ : block->succs) {
+                    const std::vector<bool>& in = liveIn[blockIndex[succ]];
+                    for (int v = 0; v < count; ++v) {
+                        if (in[v]) liveOut[b][v] = true;
+                    }
+                }
+                for (int v = 0; v < count; ++v) {
+                    bool in = use[b][v] || (liveOut[b][v] && !def[b][v]);
+                    if (in != liveIn[b][v]) {
+                        liveIn[b][v] = in;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        
+        // v 在 block 的第 position 条指令之后是否活跃
+        auto liveAfter = [&](int v, const BasicBlock* block, int position) {
+            if (defBlock[v] == block && defIndex[v] > position) return false;
+            if (liveOut[blockIndex[block]][v]) return true;
+            return std::any_of(uses[v].begin(), uses[v].end(), [&](const std::pair<const BasicBlock*, int>& site) {
+                return site.first == block && site.second > position;
+            });
+        };
+        auto interfere = [&](int a, int b) {
+            return (defBlock[b] && liveAfter(a, defBlock[b], defIndex[b])) ||
+                   (defBlock[a] && liveAfter(b, defBlock[a], defIndex[a]));
+        };
+        
+        std::vector<int> leader(count);
+        std::vector<std::vector<int>> members(count);
+        for (int v = 0; v < count; ++v) {
+            leader[v] = v;
+            members[v] = {v};
+        }
+        for (auto& block : function.blocks) {
+            for (const auto& phi : block->instructions) {
+                if (!phi.isPhi()) break;
+                for (const auto& operand : phi.operands) {
+                    if (!operand.isVar()) continue;
+                    int x = leader[index[phi.dst]];
+                    int y = leader[index[operand.value]];
+                    if (x == y) continue;
+                    bool disjoint = std::none_of(members[x].begin(), members[x].end(), [&](int a) {
+                        return std::any_of(members[y].begin(), members[y].end(), [&](int b) { return interfere(a, b); });
+                    });
+                    if (!disjoint) continue;
+                    for (int v : members[y]) leader[v] = x;
+                    members[x].insert(members[x].end(), members[y].begin(), members[y].end());
+                    members[y].clear();
+                }
+            }
+        }
+        
+        // 每类改用一个变量；含形参的类必须用形参本身
+        std::vector<int> rename(function.numVars());
+        for (int var = 0; var < function.numVars(); ++var) rename[var] = var;
+        for (int v = 0; v < count; ++v) {
+            if (members[v].size() < 2) continue;
+            int target = vars[members[v][0]];
+            for (int m : members[v]) {
+                if (defIndex[m] == -2) target = vars[m];
+            }
+            for (int m : members[v]) rename[vars[m]] = target;
+        }
+        for (auto& block : function.blocks) {
+            for (auto& instr : block->instructions) {
+                if (instr.dst >= 0) instr.dst = rename[instr.dst];
+                for (auto& operand : instr.operands) {
+                    if (operand.isVar()) operand = IRValue::var(rename[operand.value]);
+                }
+            }
+        }
+    }
+};
+
+std::unique_ptr<IRPass> createSSAConstructionPass() {
+    return std::make_unique<SSAConstructionPass>();
+}
+
+std::unique_ptr<IRPass> createSSADestructionPass() {
+    return std::make_unique<SSADestructionPass>();
+}
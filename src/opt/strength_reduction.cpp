@@ -0,0 +1,241 @@
+#include "opt/passes.hpp"
+#include "ir/loops.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+// 归纳变量强度削弱（要求 SSA 形式，位于 LICM 之后）：
+// 基本归纳变量 i = phi(init, i + c) 的常数倍 j = i * k 改为单独的归纳变量，
+// 前置块中求初值 init * k，每轮随 i 的更新加上 c * k，循环内的乘法随之消失。
+// 有多条回边（continue）的循环先合并为一条回边；各回边上步长相同的更新 i + c 在合并后的回边块里
+// 改为一次更新，于是仍是基本归纳变量。
+class StrengthReductionPass : public IRPass {
+public:
+    const char* name() const override { return "strength-reduce"; }
+    
+    bool run(IRFunction& function) override {
+        bool changed = false;
+        {
+            DominatorTree domTree(function);
+            LoopInfo loopInfo(domTree);
+            for (const Loop& loop : loopInfo.loops()) {
+                if (loop.preheader() && loop.latches.size() > 1 && scalesHeaderPhi(function, loop)) {
+                    insertLatch(function, loop);
+                    changed = true;
+                }
+            }
+        }
+        
+        // 回边块改变了 CFG，重新识别循环
+        DominatorTree domTree(function);
+        LoopInfo loopInfo(domTree);
+        for (const Loop& loop : loopInfo.loops()) {
+            BasicBlock* preheader = loop.preheader();
+            if (!preheader || loop.latches.size() != 1) continue;
+            if (reduce(function, loop, preheader, loop.latches[0])) changed = true;
+        }
+        return changed;
+    }
+    
+private:
+    struct Induction {
+        IRValue init;    // 来自前置块的初值
+        int next;        // 回边上的新值 i + step
+        int step;
+    };
+    
+    static bool phiOperand(const IRInstr& phi, const BasicBlock* from, IRValue& value) {
+        for (size_t i = 0; i < phi.targets.size(); ++i) {
+            if (phi.targets[i] == from) {
+                value = phi.operands[i];
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // 循环内是否有循环头 phi 乘以常数，没有时不必合并回边：多出的回边块只会多一次跳转
+    static bool scalesHeaderPhi(IRFunction& function, const Loop& loop) {
+        std::unordered_set<int> phis;
+        for (const auto& phi : loop.header->instructions) {
+            if (!phi.isPhi()) break;
+            phis.insert(phi.dst);
+        }
+        for (auto& block : function.blocks) {
+            if (!loop.contains(block.get())) continue;
+            for (const auto& instr : block->instructions) {
+                if (instr.op != IRInstr::MUL) continue;
+                for (int side = 0; side < 2; ++side) {
+                    const IRValue& iv = instr.operands[side];
+                    if (iv.isVar() && phis.count(iv.value) && instr.operands[1 - side].isConst()) return true;
+                }
+            }
+        }
+        return false;
+    }
+        
+    // update 是否为 var + step / step + var / var - c
+    static bool stepOf(const IRInstr& update, int var, int& step) {
+        IRValue self = IRValue::var(var);
+        if (update.op == IRInstr::ADD && update.operands[0] == self && update.operands[1].isConst()) {
+            step = update.operands[1].value;
+        } else if (update.op == IRInstr::ADD && update.operands[1] == self && update.operands[0].isConst()) {
+            step = update.operands[0].value;
+        } else if (update.op == IRInstr::SUB && update.operands[0] == self && update.operands[1].isConst()) {
+            step = (int)(0u - (uint32_t)update.operands[1].value);
+        } else {
+            return false;
+        }
+        return true;
+    }
+    
+    // 循环内定义的变量及其定义（SSA 下每个变量只有一个定义）
+    static std::unordered_map<int, const IRInstr*> loopDefinitions(IRFunction& function, const Loop& loop) {
+        std::unordered_map<int, const IRInstr*> loopDefs;
+        for (auto& block : function.blocks) {
+            if (!loop.contains(block.get())) continue;
+            for (const auto& instr : block->instructions) {
+                if (instr.dst >= 0) loopDefs[instr.dst] = &instr;
+            }
+        }
+        return loopDefs;
+    }
+    
+    // 回边块中的 next = phi(i + c, i + c, ...)（例如由 insertLatch 合并而来，步长都相同）改为 next = i + c。
+    // i 是循环头的 phi，一轮之内不变，所以各来源上的值本来就相同；原来的各个更新留给 DCE 删除
+    static void mergeUpdates(IRFunction& function, const Loop& loop, BasicBlock* latch) {
+        std::unordered_map<int, const IRInstr*> loopDefs = loopDefinitions(function, loop);
+        std::vector<std::pair<int, IRInstr>> merged;  // (回边块 phi 的结果, 代替它的更新)
+        for (const auto& join : latch->instructions) {
+            if (!join.isPhi()) break;
+            // join 须是某个循环头 phi 来自回边的值
+            const IRInstr* phi = nullptr;
+            for (const auto& candidate : loop.header->instructions) {
+                if (!candidate.isPhi()) break;
+                IRValue next;
+                if (phiOperand(candidate, latch, next) && next == IRValue::var(join.dst)) phi = &candidate;
+            }
+            if (!phi) continue;
+            bool same = true;
+            int step = 0;
+            for (size_t i = 0; i < join.operands.size() && same; ++i) {
+                const IRValue& operand = join.operands[i];
+                int current = 0;
+                same = operand.isVar() && loopDefs.count(operand.value) &&
+                       stepOf(*loopDefs[operand.value], phi->dst, current) && (i == 0 || current == step);
+                step = current;
+            }
+            if (same) {
+                merged.emplace_back(join.dst, IRInstr(IRInstr::ADD, join.dst, {IRValue::var(phi->dst), IRValue::constant(step)}));
+            }
+        }
+        
+        auto& instrs = latch->instructions;
+        for (auto& [var, update] : merged) {
+            instrs.erase(std::find_if(instrs.begin(), instrs.end(), [var = var](const IRInstr& instr) {
+                return instr.isPhi() && instr.dst == var;
+            }));
+            auto firstNonPhi = std::find_if(instrs.begin(), instrs.end(), [](const IRInstr& instr) { return !instr.isPhi(); });
+            instrs.insert(firstNonPhi, std::move(update));
+        }
+    }
+    
+    static bool reduce(IRFunction& function, const Loop& loop, BasicBlock* preheader, BasicBlock* latch) {
+        BasicBlock* header = loop.header;
+        if (latch->preds.size() > 1) mergeUpdates(function, loop, latch);
+        std::unordered_map<int, const IRInstr*> loopDefs = loopDefinitions(function, loop);
+        
+        std::unordered_map<int, Induction> inductions;
+        for (const auto& phi : header->instructions) {
+            if (!phi.isPhi()) break;
+            IRValue init, next;
+            int step;
+            if (phi.targets.size() != 2 || !phiOperand(phi, preheader, init) || !phiOperand(phi, latch, next) ||
+                !next.isVar() || !loopDefs.count(next.value)) {
+                continue;
+            }
+            if (stepOf(*loopDefs[next.value], phi.dst, step)) {
+                inductions[phi.dst] = Induction{init, next.value, step};
+            }
+        }
+        if (inductions.empty()) return false;
+        
+        // 先找出全部 j = i * k，再统一改写，避免边遍历边插入
+        std::map<std::pair<int, int>, std::vector<int>> candidates;  // (归纳变量, 倍数) -> 乘积变量
+        for (const auto& [var, def] : loopDefs) {
+            if (def->op != IRInstr::MUL) continue;
+            for (int side = 0; side < 2; ++side) {
+                const IRValue& iv = def->operands[side];
+                const IRValue& factor = def->operands[1 - side];
+                if (iv.isVar() && inductions.count(iv.value) && factor.isConst()) {
+                    candidates[{iv.value, factor.value}].push_back(var);
+                    break;
+                }
+            }
+        }
+        if (candidates.empty()) return false;
+        
+        std::unordered_map<int, int> replacements;
+        for (const auto& [key, products] : candidates) {
+            int reduced = createInduction(function, header, preheader, latch, inductions[key.first], key.second);
+            for (int product : products) replacements[product] = reduced;
+        }
+        
+        for (auto& block : function.blocks) {
+            auto& instrs = block->instructions;
+            instrs.erase(std::remove_if(instrs.begin(), instrs.end(), [&replacements](const IRInstr& instr) {
+                return instr.op == IRInstr::MUL && replacements.count(instr.dst);
+            }), instrs.end());
+            for (auto& instr : instrs) {
+                for (auto& operand : instr.operands) {
+                    if (!operand.isVar()) continue;
+                    auto it = replacements.find(operand.value);
+                    if (it != replacements.end()) operand = IRValue::var(it->second);
+                }
+            }
+        }
+        return true;
+    }
+    
+    // 返回新归纳变量（循环头 phi 的结果）
+    static int createInduction(IRFunction& function, BasicBlock* header, BasicBlock* preheader, BasicBlock* latch,
+                               const Induction& induction, int factor) {
+        IRValue start;
+        int product;
+        if (induction.init.isConst()) {
+            foldBinary(IRInstr::MUL, induction.init.value, factor, product);
+            start = IRValue::constant(product);
+        } else {
+            int initVar = function.newVar();
+            auto& instrs = preheader->instructions;
+            instrs.insert(instrs.end() - 1, IRInstr(IRInstr::MUL, initVar, {induction.init, IRValue::constant(factor)}));
+            start = IRValue::var(initVar);
+        }
+        
+        int phiVar = function.newVar();
+        int nextVar = function.newVar();
+        foldBinary(IRInstr::MUL, induction.step, factor, product);
+        
+        // 新值紧跟在原归纳变量的更新之后计算，两者在同一位置推进
+        for (auto& block : function.blocks) {
+            auto& instrs = block->instructions;
+            auto update = std::find_if(instrs.begin(), instrs.end(), [&induction](const IRInstr& instr) {
+                return instr.dst == induction.next;
+            });
+            if (update == instrs.end()) continue;
+            instrs.insert(update + 1, IRInstr(IRInstr::ADD, nextVar, {IRValue::var(phiVar), IRValue::constant(product)}));
+            break;
+        }
+        
+        IRInstr phi(IRInstr::PHI, phiVar, {start, IRValue::var(nextVar)});
+        phi.targets = {preheader, latch};
+        header->instructions.insert(header->instructions.begin(), std::move(phi));
+        return phiVar;
+    }
+};
+
+std::unique_ptr<IRPass> createStrengthReductionPass() {
+    return std::make_unique<StrengthReductionPass>();
+}
@@ -0,0 +1,134 @@
+#include "opt/passes.hpp"
+#include <algorithm>
+
+// 尾递归消除：把 return f(...)（f 为函数自身）改写为给形参重新赋值后跳回函数开头，
+// 递归变成循环，栈深度不随递归层数增长。
+// return n * f(...) / return f(...) + n 这类只差一个加法或乘法的递归，
+// 借助累加器一并改写：累加器初值取单位元，其余 return v 改为 return acc op v。
+// 在 SSA 构建之前运行，形参的多次赋值由 SSA 构建在循环头插入 phi。
+class TailRecursionPass : public IRPass {
+public:
+    const char* name() const override { return "tail-recursion"; }
+    
+    bool run(IRFunction& function) override {
+        std::vector<Site> sites;
+        IRInstr::Opcode accumulator = IRInstr::COPY;
+        
+        for (auto& block : function.blocks) {
+            Site site{block.get(), 0, IRInstr::COPY, IRValue()};
+            if (!matchSite(function, *block, site)) continue;
+            if (site.op != IRInstr::COPY) {
+                if (accumulator != IRInstr::COPY && accumulator != site.op) continue;
+                accumulator = site.op;
+            }
+            sites.push_back(site);
+        }
+        if (sites.empty()) return false;
+        
+        // 新的入口块初始化累加器后落入原入口，原入口成为循环头
+        BasicBlock* header = function.entry();
+        function.newBlock();
+        std::rotate(function.blocks.begin(), function.blocks.end() - 1, function.blocks.end());
+        BasicBlock* preheader = function.entry();
+        int acc = -1;
+        if (accumulator != IRInstr::COPY) {
+            acc = function.newVar("acc");
+            int identity = accumulator == IRInstr::MUL ? 1 : 0;
+            preheader->instructions.push_back(IRInstr(IRInstr::COPY, acc, {IRValue::constant(identity)}));
+            
+            // 非递归的 return 带上累加器
+            for (auto& block : function.blocks) {
+                if (!block->hasTerminator() || block->terminator().op != IRInstr::RET) continue;
+                bool isSite = std::any_of(sites.begin(), sites.end(), [&block](const Site& other) { return other.block == block.get(); });
+                if (isSite) continue;
+                IRInstr& ret = block->terminator();
+                int result = function.newVar();
+                IRInstr combine(accumulator, result, {IRValue::var(acc), ret.operands[0]});
+                ret.operands[0] = IRValue::var(result);
+                block->instructions.insert(block->instructions.end() - 1, std::move(combine));
+            }
+        }
+        preheader->instructions.push_back(jumpTo(header));
+        
+        for (const Site& site : sites) {
+            auto& instrs = site.block->instructions;
+            IRInstr call = instrs[site.call];
+            instrs.erase(instrs.begin() + site.call, instrs.end());
+            
+            // 实参可能引用形参，先全部求值到临时变量再赋给形参
+            std::vector<int> temps;
+            for (const auto& arg : call.operands) {
+                temps.push_back(function.newVar());
+                instrs.push_back(IRInstr(IRInstr::COPY, temps.back(), {arg}));
+            }
+            if (site.op != IRInstr::COPY) {
+                instrs.push_back(IRInstr(site.op, acc, {IRValue::var(acc), site.operand}));
+            }
+            for (size_t i = 0; i < temps.size(); ++i) {
+                instrs.push_back(IRInstr(IRInstr::COPY, function.params[i], {IRValue::var(temps[i])}));
+            }
+            instrs.push_back(jumpTo(header));
+        }
+        function.rebuildCFG();
+        return true;
+    }
+    
+private:
+    // 尾递归点：块末尾的 call [op] ret
+    struct Site {
+        BasicBlock* block;
+        size_t call;          // 调用指令的下标
+        IRInstr::Opcode op;   // 累加运算，COPY 表示纯尾调用
+        IRValue operand;      // 累加运算的另一个操作数
+    };
+    
+    static IRInstr jumpTo(BasicBlock* target) {
+        IRInstr jump(IRInstr::JUMP);
+        jump.targets.push_back(target);
+        return jump;
+    }
+    
+    // 块以 t = call self(...); ret t，或 t = call self(...); r = t op x; ret r 结尾
+    static bool matchSite(const IRFunction& function, const BasicBlock& block, Site& site) {
+        const auto& instrs = block.instructions;
+        size_t n = instrs.size();
+        if (n < 2 || instrs[n - 1].op != IRInstr::RET) return false;
+        const IRInstr& ret = instrs[n - 1];
+        
+        auto isSelfCall = [&function](const IRInstr& instr) {
+            return instr.op == IRInstr::CALL && instr.callee == function.name &&
+                   instr.operands.size() == function.params.size();
+        };
+        
+        if (isSelfCall(instrs[n - 2])) {
+            const IRInstr& call = instrs[n - 2];
+            if (ret.operands.empty() || (call.dst >= 0 && ret.operands[0] == IRValue::var(call.dst))) {
+                site.call = n - 2;
+                return true;
+            }
+            return false;
+        }
+        
+        if (n < 3 || !isSelfCall(instrs[n - 3]) || instrs[n - 3].dst < 0 || ret.operands.empty()) return false;
+        const IRInstr& call = instrs[n - 3];
+        const IRInstr& combine = instrs[n - 2];
+        if ((combine.op != IRInstr::ADD && combine.op != IRInstr::MUL) || ret.operands[0] != IRValue::var(combine.dst)) {
+            return false;
+        }
+        IRValue result = IRValue::var(call.dst);
+        if (combine.operands[0] == result && combine.operands[1] != result) {
+            site.operand = combine.operands[1];
+        } else if (combine.operands[1] == result && combine.operands[0] != result) {
+            site.operand = combine.operands[0];
+        } else {
+            return false;
+        }
+        site.call = n - 3;
+        site.op = combine.op;
+        return true;
+    }
+};
+
+std::unique_ptr<IRPass> createTailRecursionPass() {
+    return std::make_unique<TailRecursionPass>();
+}
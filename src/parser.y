@@ -1,269 +1,306 @@
-%{
-#include "ast/ast.hpp"
-#include <iostream>
-#include <vector>
-#include <memory>
-#include <cstdlib>
-
-extern int yylex();
-extern int yylineno;
-extern char* yytext;
-void yyerror(const char* s);
-
-std::unique_ptr<CompilationUnit> root;
-
-#define SAFE_FREE(p) { if (p) { free(p); p = NULL; } }
-%}
-
-%union {
-    int int_val;
-    char* str_val;
-    Expression* expr;
-    Statement* stmt;
-    Block* block;
-    FunctionDefinition* func_def;
-    CompilationUnit* comp_unit;
-    std::vector<Parameter>* param_list;
-    std::vector<std::unique_ptr<Expression>>* expr_list;
-    Parameter* param;
-    Expression::Type type_val;
-    BinaryExpression::Operator bin_op;
-    UnaryExpression::Operator un_op;
-}
-
-%token <int_val> NUMBER_LITERAL
-%token <str_val> ID
-%token INT VOID IF ELSE WHILE BREAK CONTINUE RETURN
-%token PLUS MINUS MULTIPLY DIVIDE MOD ASSIGN
-%token EQ NE LT LE GT GE AND OR NOT
-%token LPAREN RPAREN LBRACE RBRACE COMMA SEMICOLON
-%token ERROR
-
-%type <comp_unit> CompUnit
-%type <func_def> FuncDef
-%type <param_list> ParamList
-%type <param> Param
-%type <block> Block
-%type <stmt> Stmt
-%type <expr> Expr LOrExpr LAndExpr RelExpr AddExpr MulExpr UnaryExpr PrimaryExpr
-%type <expr_list> ExprList
-%type <type_val> Type
-%type <bin_op> RelOp AddOp MulOp
-%type <un_op> UnaryOp
-
-%nonassoc NO_ELSE
-%nonassoc ELSE
-
-%left OR
-%left AND
-%left EQ NE
-%left LT LE GT GE
-%left PLUS MINUS
-%left MULTIPLY DIVIDE MOD
-%right NOT UMINUS UPLUS
-
-%%
-
-CompUnit: 
-    FuncDef {
-        root = std::make_unique<CompilationUnit>();
-        root->addFunction(std::unique_ptr<FunctionDefinition>($1));
-        $$
- = root.get();
-    }
-    | CompUnit FuncDef {
-        $1->addFunction(std::unique_ptr<FunctionDefinition>($2));
-        $$ = $1;
-    };
-
-FuncDef: 
-    Type ID LPAREN ParamList RPAREN Block {
-        auto params = $4 ? *$4 : std::vector<Parameter>();
-        $$
- = new FunctionDefinition($2, $1, std::move(params), std::unique_ptr<Block>($6));
-        SAFE_FREE($2);
-        delete $4;
-    }
-    | Type ID LPAREN RPAREN Block {
-        $$ = new FunctionDefinition($2, $1, std::vector<Parameter>(), std::unique_ptr<Block>($5));
-        SAFE_FREE($2);
-    };
-
-Type: 
-    INT { $$ = Expression::INT; }
-    | VOID { $$ = Expression::VOID; };
-
-ParamList: 
-    Param {
-        $$
- = new std::vector<Parameter>();
-        $$->push_back(*$1);
-        delete $1;
-    }
-    | ParamList COMMA Param {
-        $1->push_back(*$3);
-        delete $3;
-        $$
- = $1;
-    };
-
-Param: 
-    INT ID {
-        $$ = new Parameter($2, Expression::INT);
-        SAFE_FREE($2);
-    };
-
-Block: 
-    LBRACE RBRACE {
-        $$
- = new Block();
-    }
-    | LBRACE BlockItems RBRACE {
-        $$ = dynamic_cast<Block*>($<stmt>2);
-    };
-
-BlockItems: 
-    Stmt {
-        auto block = new Block();
-        block->addStatement(std::unique_ptr<Statement>($1));
-        $<stmt>$ = block;
-    }
-    | BlockItems Stmt {
-        auto block = dynamic_cast<Block*>($<stmt>1);
-        block->addStatement(std::unique_ptr<Statement>($2));
-        $<stmt>$ = block;
-    };
-
-Stmt: 
-    Block { $$ = $1; }
-    | SEMICOLON { $$ = new Block(); }
-    | Expr SEMICOLON { $$
- = new ExpressionStatement(std::unique_ptr<Expression>($1)); }
-    | ID ASSIGN Expr SEMICOLON {
-        $$ = new AssignmentStatement($1, std::unique_ptr<Expression>($3));
-        SAFE_FREE($1);
-    }
-    | INT ID ASSIGN Expr SEMICOLON {
-        $$
- = new VariableDeclaration($2, std::unique_ptr<Expression>($4));
-        SAFE_FREE($2);
-    }
-    | IF LPAREN Expr RPAREN Stmt %prec NO_ELSE {
-        $$ = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
-    }
-    | IF LPAREN Expr RPAREN Stmt ELSE Stmt {
-        $$
- = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5), std::unique_ptr<Statement>($7));
-    }
-    | WHILE LPAREN Expr RPAREN Stmt {
-        $$ = new WhileStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
-    }
-    | BREAK SEMICOLON { $$ = new BreakStatement(); }
-    | CONTINUE SEMICOLON { $$ = new ContinueStatement(); }
-    | RETURN SEMICOLON { $$ = new ReturnStatement(); }
-    | RETURN Expr SEMICOLON { $$ = new ReturnStatement(std::unique_ptr<Expression>($2)); };
-
-Expr: 
-    LOrExpr { $$ = $1; };
-
-LOrExpr: 
-    LAndExpr { $$ = $1; }
-    | LOrExpr OR LAndExpr {
-        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), BinaryExpression::OR, std::unique_ptr<Expression>($3));
-    };
-
-LAndExpr: 
-    RelExpr { $$ = $1; }
-    | LAndExpr AND RelExpr {
-        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), BinaryExpression::AND, std::unique_ptr<Expression>($3));
-    };
-
-RelExpr: 
-    AddExpr { $$ = $1; }
-    | RelExpr RelOp AddExpr {
-        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
-    };
-
-RelOp: 
-    LT { $$ = BinaryExpression::LT; }
-    | LE { $$ = BinaryExpression::LE; }
-    | GT { $$ = BinaryExpression::GT; }
-    | GE { $$ = BinaryExpression::GE; }
-    | EQ { $$ = BinaryExpression::EQ; }
-    | NE { $$ = BinaryExpression::NE; };
-
-AddExpr: 
-    MulExpr { $$ = $1; }
-    | AddExpr AddOp MulExpr {
-        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
-    };
-
-AddOp: 
-    PLUS { $$ = BinaryExpression::ADD; }
-    | MINUS { $$ = BinaryExpression::SUB; };
-
-MulExpr: 
-    UnaryExpr { $$ = $1; }
-    | MulExpr MulOp UnaryExpr {
-        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
-    };
-
-MulOp: 
-    MULTIPLY { $$ = BinaryExpression::MUL; }
-    | DIVIDE { $$ = BinaryExpression::DIV; }
-    | MOD { $$ = BinaryExpression::MOD; };
-
-UnaryExpr: 
-    PrimaryExpr { $$
- = $1; }
-    | UnaryOp UnaryExpr {
-        $$ = new UnaryExpression($1, std::unique_ptr<Expression>($2));
-    };
-
-UnaryOp: 
-    PLUS { $$ = UnaryExpression::PLUS; }
-    | MINUS { $$ = UnaryExpression::MINUS; }
-    | NOT { $$
- = UnaryExpression::NOT; };
-
-PrimaryExpr: 
-    ID {
-        $$ = new Identifier($1);
-        SAFE_FREE($1);
-    }
-    | NUMBER_LITERAL {
-        $$ = new NumberLiteral($1);
-    }
-    | LPAREN Expr RPAREN { $$ = $2; }
-    | ID LPAREN ExprList RPAREN {
-        auto args = $3 ? std::move(*$3) : std::vector<std::unique_ptr<Expression>>();
-        $$
- = new FunctionCall($1, std::move(args), Expression::INT);
-        SAFE_FREE($1);
-        delete $3;
-    }
-    | ID LPAREN RPAREN {
-        $$ = new FunctionCall($1, std::vector<std::unique_ptr<Expression>>(), Expression::INT);
-        SAFE_FREE($1);
-    };
-
-ExprList: 
-    Expr {
-        $$
- = new std::vector<std::unique_ptr<Expression>>();
-        $$->push_back(std::unique_ptr<Expression>($1));
-    }
-    | ExprList COMMA Expr {
-        $1->push_back(std::unique_ptr<Expression>($3));
-        $$ = $1;
-    };
-
-%%
-
-void yyerror(const char* s) {
-    std::cerr << "Line " << yylineno << ": " << s;
-    if (yytext) std::cerr << " near '" << yytext << "'";
-    std::cerr << std::endl;
-    
-    if (root) root.reset();
+%code requires {
+#include "ast/parse.hpp"
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+}
+
+%{
+#include "ast/ast.hpp"
+#include "ast/fast_lexer.hpp"
+#include "ast/flat_ast.hpp"
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+%}
+
+// 纯分析器：没有全局状态，分析结果和扁平 AST 输出都在 context 中
+%define api.pure full
+%param {yyscan_t scanner} {ParseContext& context}
+
+%code {
+int yylex(YYSTYPE* lvalue, yyscan_t scanner);
+int yyget_lineno(yyscan_t scanner);
+char* yyget_text(yyscan_t scanner);
+void yyerror(yyscan_t scanner, ParseContext& context, const char* s);
+
+// 设置了 context.fastLexer 时记号来自手写扫描器，否则来自 Flex
+static int yylex(YYSTYPE* lvalue, yyscan_t scanner, ParseContext& context) {
+    return context.fastLexer ? context.fastLexer->next(*lvalue) : yylex(lvalue, scanner);
+}
+
+// 设置了 context.flatOutput 时在归约的同时按后序追加扁平 AST 节点
+#define FLAT(action) if (context.flatOutput) context.flatOutput->action
+}
+
+%union {
+    int int_val;
+    SymbolId sym_val;
+    Expression* expr;
+    Statement* stmt;
+    Block* block;
+    FunctionDefinition* func_def;
+    CompilationUnit* comp_unit;
+    ParameterList* param_list;
+    ExpressionList* expr_list;
+    Parameter* param;
+    Expression::Type type_val;
+    BinaryExpression::Operator bin_op;
+    UnaryExpression::Operator un_op;
+}
+
+%token <int_val> NUMBER_LITERAL
+%token <sym_val> ID
+%token INT VOID IF ELSE WHILE BREAK CONTINUE RETURN
+%token PLUS MINUS MULTIPLY DIVIDE MOD ASSIGN
+%token EQ NE LT LE GT GE AND OR NOT
+%token LPAREN RPAREN LBRACE RBRACE COMMA SEMICOLON
+%token ERROR
+
+%type <comp_unit> CompUnit
+%type <func_def> FuncDef
+%type <param_list> ParamList
+%type <param> Param
+%type <block> Block
+%type <stmt> Stmt
+%type <expr> Expr LOrExpr LAndExpr RelExpr AddExpr MulExpr UnaryExpr PrimaryExpr
+%type <expr_list> ExprList
+%type <type_val> Type
+%type <bin_op> RelOp AddOp MulOp
+%type <un_op> UnaryOp
+
+%nonassoc NO_ELSE
+%nonassoc ELSE
+
+%left OR
+%left AND
+%left EQ NE
+%left LT LE GT GE
+%left PLUS MINUS
+%left MULTIPLY DIVIDE MOD
+%right NOT UMINUS UPLUS
+
+%%
+
+CompUnit: 
+    FuncDef {
+        context.root = std::make_unique<CompilationUnit>();
+        if (!context.addFunction($1)) YYABORT;
+        $$
+ = context.root.get();
+    }
+    | CompUnit FuncDef {
+        if (!context.addFunction($2)) YYABORT;
+        $$ = $1;
+    };
+
+FuncDef: 
+    Type ID LPAREN ParamList RPAREN Block {
+        auto params = $4 ? *$4 : ParameterList();
+        FLAT(function($2, $1, params));
+        $$
+ = new FunctionDefinition($2, $1, std::move(params), std::unique_ptr<Block>($6));
+        delete $4;
+    }
+    | Type ID LPAREN RPAREN Block {
+        $$ = new FunctionDefinition($2, $1, ParameterList(), std::unique_ptr<Block>($5));
+        FLAT(function($2, $1, $$->parameters));
+    };
+
+Type: 
+    INT { $$ = Expression::INT; }
+    | VOID { $$ = Expression::VOID; };
+
+ParamList: 
+    Param {
+        $$
+ = new ParameterList();
+        $$->push_back(*$1);
+        delete $1;
+    }
+    | ParamList COMMA Param {
+        $1->push_back(*$3);
+        delete $3;
+        $$
+ = $1;
+    };
+
+Param: 
+    INT ID {
+        $$ = new Parameter($2, Expression::INT);
+    };
+
+Block: 
+    LBRACE RBRACE {
+        $$
+ = new Block();
+        FLAT(block(0));
+    }
+    | LBRACE BlockItems RBRACE {
+        $$ = $<stmt>2->as<Block>();
+        FLAT(block($$->statements.size()));
+    };
+
+BlockItems: 
+    Stmt {
+        auto block = new Block();
+        block->addStatement(std::unique_ptr<Statement>($1));
+        $<stmt>$ = block;
+    }
+    | BlockItems Stmt {
+        auto block = $<stmt>1->as<Block>();
+        block->addStatement(std::unique_ptr<Statement>($2));
+        $<stmt>$ = block;
+    };
+
+Stmt: 
+    Block { $$ = $1; }
+    | SEMICOLON { $$ = new Block(); FLAT(block(0)); }
+    | Expr SEMICOLON { $$
+ = new ExpressionStatement(std::unique_ptr<Expression>($1)); FLAT(expressionStatement()); }
+    | ID ASSIGN Expr SEMICOLON {
+        $$ = new AssignmentStatement($1, std::unique_ptr<Expression>($3));
+        FLAT(assignment($1));
+    }
+    | INT ID ASSIGN Expr SEMICOLON {
+        $$
+ = new VariableDeclaration($2, std::unique_ptr<Expression>($4));
+        FLAT(declaration($2, true));
+    }
+    | IF LPAREN Expr RPAREN Stmt %prec NO_ELSE {
+        $$ = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
+        FLAT(ifStatement(false));
+    }
+    | IF LPAREN Expr RPAREN Stmt ELSE Stmt {
+        $$
+ = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5), std::unique_ptr<Statement>($7));
+        FLAT(ifStatement(true));
+    }
+    | WHILE LPAREN Expr RPAREN Stmt {
+        $$ = new WhileStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
+        FLAT(whileStatement());
+    }
+    | BREAK SEMICOLON { $$ = new BreakStatement(); FLAT(breakStatement()); }
+    | CONTINUE SEMICOLON { $$ = new ContinueStatement(); FLAT(continueStatement()); }
+    | RETURN SEMICOLON { $$ = new ReturnStatement(); FLAT(returnStatement(false)); }
+    | RETURN Expr SEMICOLON { $$ = new ReturnStatement(std::unique_ptr<Expression>($2)); FLAT(returnStatement(true)); };
+
+Expr: 
+    LOrExpr { $$ = $1; };
+
+LOrExpr: 
+    LAndExpr { $$ = $1; }
+    | LOrExpr OR LAndExpr {
+        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), BinaryExpression::OR, std::unique_ptr<Expression>($3));
+        FLAT(binary(BinaryExpression::OR));
+    };
+
+LAndExpr: 
+    RelExpr { $$ = $1; }
+    | LAndExpr AND RelExpr {
+        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), BinaryExpression::AND, std::unique_ptr<Expression>($3));
+        FLAT(binary(BinaryExpression::AND));
+    };
+
+RelExpr: 
+    AddExpr { $$ = $1; }
+    | RelExpr RelOp AddExpr {
+        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
+        FLAT(binary($2));
+    };
+
+RelOp: 
+    LT { $$ = BinaryExpression::LT; }
+    | LE { $$ = BinaryExpression::LE; }
+    | GT { $$ = BinaryExpression::GT; }
+    | GE { $$ = BinaryExpression::GE; }
+    | EQ { $$ = BinaryExpression::EQ; }
+    | NE { $$ = BinaryExpression::NE; };
+
+AddExpr: 
+    MulExpr { $$ = $1; }
+    | AddExpr AddOp MulExpr {
+        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
+        FLAT(binary($2));
+    };
+
+AddOp: 
+    PLUS { $$ = BinaryExpression::ADD; }
+    | MINUS { $$ = BinaryExpression::SUB; };
+
+MulExpr: 
+    UnaryExpr { $$ = $1; }
+    | MulExpr MulOp UnaryExpr {
+        $$ = new BinaryExpression(std::unique_ptr<Expression>($1), $2, std::unique_ptr<Expression>($3));
+        FLAT(binary($2));
+    };
+
+MulOp: 
+    MULTIPLY { $$ = BinaryExpression::MUL; }
+    | DIVIDE { $$ = BinaryExpression::DIV; }
+    | MOD { $$ = BinaryExpression::MOD; };
+
+UnaryExpr: 
+    PrimaryExpr { $$
+ = $1; }
+    | UnaryOp UnaryExpr {
+        $$ = new UnaryExpression($1, std::unique_ptr<Expression>($2));
+        FLAT(unary($1));
+    };
+
+UnaryOp: 
+    PLUS { $$ = UnaryExpression::PLUS; }
+    | MINUS { $$ = UnaryExpression::MINUS; }
+    | NOT { $$
+ = UnaryExpression::NOT; };
+
+PrimaryExpr: 
+    ID {
+        $$ = new Identifier($1);
+        FLAT(identifier($1));
+    }
+    | NUMBER_LITERAL {
+        $$ = new NumberLiteral($1);
+        FLAT(number($1));
+    }
+    | LPAREN Expr RPAREN { $$ = $2; }
+    | ID LPAREN ExprList RPAREN {
+        auto args = $3 ? std::move(*$3) : ExpressionList();
+        FLAT(call($1, args.size()));
+        $$
+ = new FunctionCall($1, std::move(args), Expression::INT);
+        delete $3;
+    }
+    | ID LPAREN RPAREN {
+        $$ = new FunctionCall($1, ExpressionList(), Expression::INT);
+        FLAT(call($1, 0));
+    };
+
+ExprList: 
+    Expr {
+        $$
+ = new ExpressionList();
+        $$->push_back(std::unique_ptr<Expression>($1));
+    }
+    | ExprList COMMA Expr {
+        $1->push_back(std::unique_ptr<Expression>($3));
+        $$ = $1;
+    };
+
+%%
+
+void yyerror(yyscan_t scanner, ParseContext& context, const char* s) {
+    if (context.fastLexer) {
+        context.diagnostics << "Line " << context.fastLexer->lineno() << ", offset " << context.tokenOffset << ": " << s
+                            << " near '" << context.fastLexer->text() << "'";
+    } else {
+        const char* text = yyget_text(scanner);
+        context.diagnostics << "Line " << yyget_lineno(scanner) << ", offset " << context.tokenOffset << ": " << s;
+        if (text) context.diagnostics << " near '" << text << "'";
+    }
+    context.diagnostics << std::endl;
+    
+    if (context.root) context.root.reset();
 }
\ No newline at end of file
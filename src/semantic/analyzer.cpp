@@ -1,202 +1,280 @@
-#include "semantic/analyzer.hpp"
-#include <iostream>
-
-bool SemanticAnalyzer::analyze(CompilationUnit& unit) {
-    errors.clear();
-    
-    // 收集所有函数声明
-    for (auto& func : unit.functions) {
-        std::vector<Expression::Type> paramTypes;
-        for (const auto& param : func->parameters) {
-            paramTypes.push_back(param.type);
-        }
-        
-        if (functions.find(func->name) != functions.end()) {
-            addError("Function '" + func->name + "' is already declared");
-            continue;
-        }
-        
-        functions[func->name] = FunctionInfo(func->name, func->returnType, paramTypes, true);
-    }
-    
-    // 检查main函数
-    if (!checkMainFunction()) {
-        addError("Missing main function with signature: int main()");
-    }
-    
-    // 分析函数体
-    unit.accept(*this);
-    
-    return errors.empty();
-}
-
-void SemanticAnalyzer::addError(const std::string& message) {
-    errors.push_back(message);
-}
-
-bool SemanticAnalyzer::checkMainFunction() {
-    auto it = functions.find("main");
-    if (it == functions.end()) {
-        return false;
-    }
-    
-    const FunctionInfo& mainFunc = it->second;
-    return mainFunc.returnType == Expression::INT && mainFunc.paramTypes.empty();
-}
-
-// Visitor实现
-void SemanticAnalyzer::visit(CompilationUnit& node) {
-    for (auto& func : node.functions) {
-        func->accept(*this);
-    }
-}
-
-void SemanticAnalyzer::visit(FunctionDefinition& node) {
-    currentFunction = node.name;
-    hasReturn = false;
-    
-    scope.enterScope();
-    scope.resetOffset();
-    
-    // 添加参数到符号表
-    for (const auto& param : node.parameters) {
-        if (!scope.declareVariable(param.name, param.type, true)) {
-            addError("Parameter '" + param.name + "' is already declared");
-        }
-    }
-    
-    // 分析函数体
-    node.body->accept(*this);
-    
-    // 检查返回值
-    if (node.returnType == Expression::INT && !hasReturn) {
-        addError("Function '" + node.name + "' must return a value");
-    }
-    
-    scope.exitScope();
-}
-
-void SemanticAnalyzer::visit(Block& node) {
-    scope.enterScope();
-    for (auto& stmt : node.statements) {
-        stmt->accept(*this);
-    }
-    scope.exitScope();
-}
-
-void SemanticAnalyzer::visit(VariableDeclaration& node) {
-    if (!scope.declareVariable(node.name, Expression::INT)) {
-        addError("Variable '" + node.name + "' is already declared in this scope");
-        return;
-    }
-    
-    if (node.initializer) {
-        node.initializer->accept(*this);
-    }
-}
-
-void SemanticAnalyzer::visit(AssignmentStatement& node) {
-    Symbol* symbol = scope.lookupVariable(node.variable);
-    if (!symbol) {
-        addError("Undefined variable '" + node.variable + "'");
-        return;
-    }
-    
-    node.value->accept(*this);
-}
-
-void SemanticAnalyzer::visit(Identifier& node) {
-    Symbol* symbol = scope.lookupVariable(node.name);
-    if (!symbol) {
-        addError("Undefined variable '" + node.name + "'");
-    }
-}
-
-void SemanticAnalyzer::visit(FunctionCall& node) {
-    auto it = functions.find(node.functionName);
-    if (it == functions.end()) {
-        addError("Undefined function '" + node.functionName + "'");
-        return;
-    }
-    
-    const FunctionInfo& funcInfo = it->second;
-    
-    // 检查参数数量
-    if (node.arguments.size() != funcInfo.paramTypes.size()) {
-        addError("Function '" + node.functionName + "' expects " + 
-                std::to_string(funcInfo.paramTypes.size()) + " arguments, got " + 
-                std::to_string(node.arguments.size()));
-        return;
-    }
-    
-    // 检查参数
-    for (auto& arg : node.arguments) {
-        arg->accept(*this);
-    }
-    
-    // 设置返回类型
-    const_cast<FunctionCall&>(node).returnType = funcInfo.returnType;
-}
-
-void SemanticAnalyzer::visit(BinaryExpression& node) {
-    node.left->accept(*this);
-    node.right->accept(*this);
-}
-
-void SemanticAnalyzer::visit(UnaryExpression& node) {
-    node.operand->accept(*this);
-}
-
-void SemanticAnalyzer::visit(NumberLiteral& node) {
-    // 数字字面量总是有效的
-}
-
-void SemanticAnalyzer::visit(IfStatement& node) {
-    node.condition->accept(*this);
-    node.thenStatement->accept(*this);
-    if (node.elseStatement) {
-        node.elseStatement->accept(*this);
-    }
-}
-
-void SemanticAnalyzer::visit(WhileStatement& node) {
-    node.condition->accept(*this);
-    loopDepth++;
-    node.body->accept(*this);
-    loopDepth--;
-}
-
-void SemanticAnalyzer::visit(BreakStatement& node) {
-    if (loopDepth == 0) {
-        addError("break statement not within a loop");
-    }
-}
-
-void SemanticAnalyzer::visit(ContinueStatement& node) {
-    if (loopDepth == 0) {
-        addError("continue statement not within a loop");
-    }
-}
-
-void SemanticAnalyzer::visit(ReturnStatement& node) {
-    hasReturn = true;
-    
-    auto it = functions.find(currentFunction);
-    if (it != functions.end()) {
-        const FunctionInfo& funcInfo = it->second;
-        
-        if (funcInfo.returnType == Expression::VOID && node.value) {
-            addError("void function should not return a value");
-        } else if (funcInfo.returnType == Expression::INT && !node.value) {
-            addError("non-void function must return a value");
-        }
-    }
-    
-    if (node.value) {
-        node.value->accept(*this);
-    }
-}
-
-void SemanticAnalyzer::visit(ExpressionStatement& node) {
-    node.expression->accept(*this);
+#include "semantic/analyzer.hpp"
+#include "common/parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+void ScopeManager::enterScope() {
+    scopeStarts.push_back(bindings.size());
+}
+
+void ScopeManager::exitScope() {
+    size_t start = scopeStarts.back();
+    scopeStarts.pop_back();
+    // 按声明的逆序撤销，恢复被遮蔽的外层绑定
+    while (bindings.size() > start) {
+        const Symbol& symbol = bindings.back();
+        innermost[symbol.name.index()] = symbol.shadowed;
+        bindings.pop_back();
+    }
+}
+
+bool ScopeManager::declareVariable(SymbolId name, Expression::Type type, bool isParam) {
+    uint32_t id = name.index();
+    if (id >= innermost.size()) {
+        // 按 ID 成倍扩大，不按只增不减的全局驻留表
+        innermost.resize(std::max<size_t>(id + 1, innermost.size() * 2), -1);
+    }
+    int depth = (int)scopeStarts.size();
+    int32_t previous = innermost[id];
+    if (previous >= 0 && bindings[previous].depth == depth) {
+        return false;
+    }
+    offset -= 4;
+    innermost[id] = (int32_t)bindings.size();
+    bindings.push_back(Symbol{name, type, offset, isParam, depth, previous});
+    return true;
+}
+
+Symbol* ScopeManager::lookupVariable(SymbolId name) {
+    uint32_t id = name.index();
+    if (id >= innermost.size() || innermost[id] < 0) {
+        return nullptr;
+    }
+    return &bindings[innermost[id]];
+}
+
+bool SemanticAnalyzer::analyze(CompilationUnit& unit, unsigned jobs) {
+    errors.clear();
+    
+    // 收集所有函数声明
+    for (auto& func : unit.functions) {
+        declareFunction(*func);
+    }
+    
+    // 检查main函数
+    if (!checkMainFunction()) {
+        addError("Missing main function with signature: int main()");
+    }
+    
+    // 分析函数体：签名表此后不再改变，各函数体互不相关。每个工作线程用一个分析器依次检查
+    // 它取到的函数，作用域表在函数之间复用（退出作用域时已恢复原状），不为每个函数重新分配
+    size_t count = unit.functions.size();
+    if (jobs == 0) jobs = hardwareThreads();
+    unsigned workers = (unsigned)std::min<size_t>(jobs, count);
+    std::vector<std::vector<std::string>> bodyErrors(count);
+    std::atomic<size_t> next(0);
+    parallelFor(workers, workers, [&](size_t) {
+        SemanticAnalyzer body(functions);
+        for (size_t i = next++; i < count; i = next++) {
+            unit.functions[i]->accept(body);
+            bodyErrors[i].swap(body.errors);
+            body.errors.clear();
+        }
+    });
+    for (auto& list : bodyErrors) {
+        errors.insert(errors.end(), list.begin(), list.end());
+    }
+    
+    return errors.empty();
+}
+
+bool SemanticAnalyzer::analyzeFunction(FunctionDefinition& function) {
+    size_t known = errors.size();
+    if (declareFunction(function)) {
+        function.accept(*this);
+    }
+    return errors.size() == known;
+}
+
+bool SemanticAnalyzer::finish() {
+    if (!checkMainFunction()) {
+        addError("Missing main function with signature: int main()");
+    }
+    return errors.empty();
+}
+
+bool SemanticAnalyzer::declareFunction(const FunctionDefinition& function) {
+    if (functions.find(function.name.str()) != functions.end()) {
+        addError("Function '" + function.name.str() + "' is already declared");
+        return false;
+    }
+    
+    std::vector<Expression::Type> paramTypes;
+    for (const auto& param : function.parameters) {
+        paramTypes.push_back(param.type);
+    }
+    functions[function.name.str()] = FunctionInfo(function.name.str(), function.returnType, paramTypes, true);
+    return true;
+}
+
+void SemanticAnalyzer::addError(const std::string& message) {
+    errors.push_back(message);
+}
+
+bool SemanticAnalyzer::checkMainFunction() {
+    auto it = functions.find("main");
+    if (it == functions.end()) {
+        return false;
+    }
+    
+    const FunctionInfo& mainFunc = it->second;
+    return mainFunc.returnType == Expression::INT && mainFunc.paramTypes.empty();
+}
+
+// Visitor实现
+void SemanticAnalyzer::visit(CompilationUnit& node) {
+    for (auto& func : node.functions) {
+        func->accept(*this);
+    }
+}
+
+void SemanticAnalyzer::visit(FunctionDefinition& node) {
+    currentFunction = node.name.str();
+    hasReturn = false;
+    
+    scope.enterScope();
+    scope.resetOffset();
+    
+    // 添加参数到符号表
+    for (const auto& param : node.parameters) {
+        if (!scope.declareVariable(param.name, param.type, true)) {
+            addError("Parameter '" + param.name.str() + "' is already declared");
+        }
+    }
+    
+    // 分析函数体
+    node.body->accept(*this);
+    
+    // 检查返回值
+    if (node.returnType == Expression::INT && !hasReturn) {
+        addError("Function '" + node.name.str() + "' must return a value");
+    }
+    
+    scope.exitScope();
+}
+
+void SemanticAnalyzer::visit(Block& node) {
+    scope.enterScope();
+    for (auto& stmt : node.statements) {
+        stmt->accept(*this);
+    }
+    scope.exitScope();
+}
+
+void SemanticAnalyzer::visit(VariableDeclaration& node) {
+    if (!scope.declareVariable(node.name, Expression::INT)) {
+        addError("Variable '" + node.name.str() + "' is already declared in this scope");
+        return;
+    }
+    
+    if (node.initializer) {
+        node.initializer->accept(*this);
+    }
+}
+
+void SemanticAnalyzer::visit(AssignmentStatement& node) {
+    Symbol* symbol = scope.lookupVariable(node.variable);
+    if (!symbol) {
+        addError("Undefined variable '" + node.variable.str() + "'");
+        return;
+    }
+    
+    node.value->accept(*this);
+}
+
+void SemanticAnalyzer::visit(Identifier& node) {
+    Symbol* symbol = scope.lookupVariable(node.name);
+    if (!symbol) {
+        addError("Undefined variable '" + node.name.str() + "'");
+    }
+}
+
+void SemanticAnalyzer::visit(FunctionCall& node) {
+    auto it = declared->find(node.functionName.str());
+    if (it == declared->end()) {
+        addError("Undefined function '" + node.functionName.str() + "'");
+        return;
+    }
+    
+    const FunctionInfo& funcInfo = it->second;
+    
+    // 检查参数数量
+    if (node.arguments.size() != funcInfo.paramTypes.size()) {
+        addError("Function '" + node.functionName.str() + "' expects " + 
+                std::to_string(funcInfo.paramTypes.size()) + " arguments, got " + 
+                std::to_string(node.arguments.size()));
+        return;
+    }
+    
+    // 检查参数
+    for (auto& arg : node.arguments) {
+        arg->accept(*this);
+    }
+    
+    // 设置返回类型
+    const_cast<FunctionCall&>(node).returnType = funcInfo.returnType;
+}
+
+void SemanticAnalyzer::visit(BinaryExpression& node) {
+    node.left->accept(*this);
+    node.right->accept(*this);
+}
+
+void SemanticAnalyzer::visit(UnaryExpression& node) {
+    node.operand->accept(*this);
+}
+
+void SemanticAnalyzer::visit(NumberLiteral& node) {
+    // 数字字面量总是有效的
+}
+
+void SemanticAnalyzer::visit(IfStatement& node) {
+    node.condition->accept(*this);
+    node.thenStatement->accept(*this);
+    if (node.elseStatement) {
+        node.elseStatement->accept(*this);
+    }
+}
+
+void SemanticAnalyzer::visit(WhileStatement& node) {
+    node.condition->accept(*this);
+    loopDepth++;
+    node.body->accept(*this);
+    loopDepth--;
+}
+
+void SemanticAnalyzer::visit(BreakStatement& node) {
+    if (loopDepth == 0) {
+        addError("break statement not within a loop");
+    }
+}
+
+void SemanticAnalyzer::visit(ContinueStatement& node) {
+    if (loopDepth == 0) {
+        addError("continue statement not within a loop");
+    }
+}
+
+void SemanticAnalyzer::visit(ReturnStatement& node) {
+    hasReturn = true;
+    
+    auto it = declared->find(currentFunction);
+    if (it != declared->end()) {
+        const FunctionInfo& funcInfo = it->second;
+        
+        if (funcInfo.returnType == Expression::VOID && node.value) {
+            addError("void function should not return a value");
+        } else if (funcInfo.returnType == Expression::INT && !node.value) {
+            addError("non-void function must return a value");
+        }
+    }
+    
+    if (node.value) {
+        node.value->accept(*this);
+    }
+}
+
+void SemanticAnalyzer::visit(ExpressionStatement& node) {
+    node.expression->accept(*this);
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include "ast/ast.hpp"
+#include "common/symbol.hpp"
+#include "common/types.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 变量符号
+struct Symbol {
+    SymbolId name;
+    Expression::Type type;
+    int offset;
+    bool isParam;
+    int depth;       // 声明所在的作用域深度
+    int32_t shadowed; // 被它遮蔽的同名绑定在 bindings 中的下标，-1 表示没有
+};
+
+// 作用域符号表：不为每个作用域建哈希表，而是把所有活跃绑定按声明顺序放在一个数组里，
+// 数组同时充当撤销日志；innermost 以符号 ID 为下标记录每个名字最内层的绑定，
+// 被遮蔽的绑定通过 shadowed 串成栈。查找 O(1)，退出作用域只撤销本作用域的声明
+class ScopeManager {
+public:
+    ScopeManager() : offset(0) {}
+    
+    void enterScope();
+    void exitScope();
+    void resetOffset() { offset = 0; }
+    
+    // 同一作用域内重复声明返回 false
+    bool declareVariable(SymbolId name, Expression::Type type, bool isParam = false);
+    // 返回的指针在下一次声明或退出作用域之前有效
+    Symbol* lookupVariable(SymbolId name);
+    
+private:
+    std::vector<Symbol> bindings;
+    std::vector<size_t> scopeStarts;  // 每个作用域开始时 bindings 的长度
+    std::vector<int32_t> innermost;   // 符号 ID -> bindings 下标，-1 表示未声明
+    int offset;
+};
+
+// 语义分析：检查函数声明、变量作用域、调用参数个数、返回值以及 break/continue 的位置
+class SemanticAnalyzer : public Visitor {
+public:
+    SemanticAnalyzer() : declared(&functions), hasReturn(false), loopDepth(0) {}
+    SemanticAnalyzer(const SemanticAnalyzer&) = delete;
+    SemanticAnalyzer& operator=(const SemanticAnalyzer&) = delete;
+    
+    // 先顺序收集全部函数签名，再用 jobs 个线程分别检查各函数体（0 表示硬件线程数）。
+    // 每个函数由一个只读共享签名表的分析器检查，错误按函数顺序合并，与 jobs 无关
+    bool analyze(CompilationUnit& unit, unsigned jobs = 1);
+    // 流式分析：函数必须先定义后调用（可以递归调用自身），每个函数定义完成后立即检查，
+    // 有新错误时返回 false；全部函数之后调用 finish() 检查 main
+    bool analyzeFunction(FunctionDefinition& function);
+    bool finish();
+    const std::vector<std::string>& getErrors() const { return errors; }
+    
+    void visit(BinaryExpression& node) override;
+    void visit(UnaryExpression& node) override;
+    void visit(NumberLiteral& node) override;
+    void visit(Identifier& node) override;
+    void visit(FunctionCall& node) override;
+    void visit(AssignmentStatement& node) override;
+    void visit(VariableDeclaration& node) override;
+    void visit(Block& node) override;
+    void visit(IfStatement& node) override;
+    void visit(WhileStatement& node) override;
+    void visit(BreakStatement& node) override;
+    void visit(ContinueStatement& node) override;
+    void visit(ReturnStatement& node) override;
+    void visit(ExpressionStatement& node) override;
+    void visit(FunctionDefinition& node) override;
+    void visit(CompilationUnit& node) override;
+    
+private:
+    // 检查单个函数体的分析器，函数签名取自 declared
+    explicit SemanticAnalyzer(const std::unordered_map<std::string, FunctionInfo>& declared)
+        : declared(&declared), hasReturn(false), loopDepth(0) {}
+    
+    void addError(const std::string& message);
+    bool declareFunction(const FunctionDefinition& function);
+    bool checkMainFunction();
+    
+    std::vector<std::string> errors;
+    std::unordered_map<std::string, FunctionInfo> functions;
+    const std::unordered_map<std::string, FunctionInfo>* declared;  // 查找调用目标用，通常就是 functions
+    std::string currentFunction;
+    bool hasReturn;
+    int loopDepth;
+    ScopeManager scope;
+};